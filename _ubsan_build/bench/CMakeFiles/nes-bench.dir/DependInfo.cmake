@@ -0,0 +1,24 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/bench/bench.cpp" "bench/CMakeFiles/nes-bench.dir/bench.cpp.o" "gcc" "bench/CMakeFiles/nes-bench.dir/bench.cpp.o.d"
+  "/root/repo/bench/cpu_benchmarks.cpp" "bench/CMakeFiles/nes-bench.dir/cpu_benchmarks.cpp.o" "gcc" "bench/CMakeFiles/nes-bench.dir/cpu_benchmarks.cpp.o.d"
+  "/root/repo/bench/fixtures.cpp" "bench/CMakeFiles/nes-bench.dir/fixtures.cpp.o" "gcc" "bench/CMakeFiles/nes-bench.dir/fixtures.cpp.o.d"
+  "/root/repo/bench/frame_benchmarks.cpp" "bench/CMakeFiles/nes-bench.dir/frame_benchmarks.cpp.o" "gcc" "bench/CMakeFiles/nes-bench.dir/frame_benchmarks.cpp.o.d"
+  "/root/repo/bench/memory_benchmarks.cpp" "bench/CMakeFiles/nes-bench.dir/memory_benchmarks.cpp.o" "gcc" "bench/CMakeFiles/nes-bench.dir/memory_benchmarks.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_ubsan_build/src/CMakeFiles/nes-core.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
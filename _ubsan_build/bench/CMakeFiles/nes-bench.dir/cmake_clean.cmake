@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-bench.dir/bench.cpp.o"
+  "CMakeFiles/nes-bench.dir/bench.cpp.o.d"
+  "CMakeFiles/nes-bench.dir/cpu_benchmarks.cpp.o"
+  "CMakeFiles/nes-bench.dir/cpu_benchmarks.cpp.o.d"
+  "CMakeFiles/nes-bench.dir/fixtures.cpp.o"
+  "CMakeFiles/nes-bench.dir/fixtures.cpp.o.d"
+  "CMakeFiles/nes-bench.dir/frame_benchmarks.cpp.o"
+  "CMakeFiles/nes-bench.dir/frame_benchmarks.cpp.o.d"
+  "CMakeFiles/nes-bench.dir/memory_benchmarks.cpp.o"
+  "CMakeFiles/nes-bench.dir/memory_benchmarks.cpp.o.d"
+  "nes-bench"
+  "nes-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
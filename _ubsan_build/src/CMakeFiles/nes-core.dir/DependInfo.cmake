@@ -0,0 +1,35 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/block_cache.cpp" "src/CMakeFiles/nes-core.dir/block_cache.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/block_cache.cpp.o.d"
+  "/root/repo/src/cartridge.cpp" "src/CMakeFiles/nes-core.dir/cartridge.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/cartridge.cpp.o.d"
+  "/root/repo/src/cpu.cpp" "src/CMakeFiles/nes-core.dir/cpu.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/cpu.cpp.o.d"
+  "/root/repo/src/frame_convert.cpp" "src/CMakeFiles/nes-core.dir/frame_convert.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/frame_convert.cpp.o.d"
+  "/root/repo/src/headless.cpp" "src/CMakeFiles/nes-core.dir/headless.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/headless.cpp.o.d"
+  "/root/repo/src/io_registers.cpp" "src/CMakeFiles/nes-core.dir/io_registers.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/io_registers.cpp.o.d"
+  "/root/repo/src/mapper.cpp" "src/CMakeFiles/nes-core.dir/mapper.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/mapper.cpp.o.d"
+  "/root/repo/src/memory.cpp" "src/CMakeFiles/nes-core.dir/memory.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/memory.cpp.o.d"
+  "/root/repo/src/opcode_pairs.cpp" "src/CMakeFiles/nes-core.dir/opcode_pairs.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/opcode_pairs.cpp.o.d"
+  "/root/repo/src/ppu.cpp" "src/CMakeFiles/nes-core.dir/ppu.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/ppu.cpp.o.d"
+  "/root/repo/src/profiler.cpp" "src/CMakeFiles/nes-core.dir/profiler.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/profiler.cpp.o.d"
+  "/root/repo/src/recompiler.cpp" "src/CMakeFiles/nes-core.dir/recompiler.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/recompiler.cpp.o.d"
+  "/root/repo/src/scheduler.cpp" "src/CMakeFiles/nes-core.dir/scheduler.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/scheduler.cpp.o.d"
+  "/root/repo/src/static_recompiler.cpp" "src/CMakeFiles/nes-core.dir/static_recompiler.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/static_recompiler.cpp.o.d"
+  "/root/repo/src/tile_cache.cpp" "src/CMakeFiles/nes-core.dir/tile_cache.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/tile_cache.cpp.o.d"
+  "/root/repo/src/trace.cpp" "src/CMakeFiles/nes-core.dir/trace.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/trace.cpp.o.d"
+  "/root/repo/src/trace_compare.cpp" "src/CMakeFiles/nes-core.dir/trace_compare.cpp.o" "gcc" "src/CMakeFiles/nes-core.dir/trace_compare.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,43 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-core.dir/block_cache.cpp.o"
+  "CMakeFiles/nes-core.dir/block_cache.cpp.o.d"
+  "CMakeFiles/nes-core.dir/cartridge.cpp.o"
+  "CMakeFiles/nes-core.dir/cartridge.cpp.o.d"
+  "CMakeFiles/nes-core.dir/cpu.cpp.o"
+  "CMakeFiles/nes-core.dir/cpu.cpp.o.d"
+  "CMakeFiles/nes-core.dir/frame_convert.cpp.o"
+  "CMakeFiles/nes-core.dir/frame_convert.cpp.o.d"
+  "CMakeFiles/nes-core.dir/headless.cpp.o"
+  "CMakeFiles/nes-core.dir/headless.cpp.o.d"
+  "CMakeFiles/nes-core.dir/io_registers.cpp.o"
+  "CMakeFiles/nes-core.dir/io_registers.cpp.o.d"
+  "CMakeFiles/nes-core.dir/mapper.cpp.o"
+  "CMakeFiles/nes-core.dir/mapper.cpp.o.d"
+  "CMakeFiles/nes-core.dir/memory.cpp.o"
+  "CMakeFiles/nes-core.dir/memory.cpp.o.d"
+  "CMakeFiles/nes-core.dir/opcode_pairs.cpp.o"
+  "CMakeFiles/nes-core.dir/opcode_pairs.cpp.o.d"
+  "CMakeFiles/nes-core.dir/ppu.cpp.o"
+  "CMakeFiles/nes-core.dir/ppu.cpp.o.d"
+  "CMakeFiles/nes-core.dir/profiler.cpp.o"
+  "CMakeFiles/nes-core.dir/profiler.cpp.o.d"
+  "CMakeFiles/nes-core.dir/recompiler.cpp.o"
+  "CMakeFiles/nes-core.dir/recompiler.cpp.o.d"
+  "CMakeFiles/nes-core.dir/scheduler.cpp.o"
+  "CMakeFiles/nes-core.dir/scheduler.cpp.o.d"
+  "CMakeFiles/nes-core.dir/static_recompiler.cpp.o"
+  "CMakeFiles/nes-core.dir/static_recompiler.cpp.o.d"
+  "CMakeFiles/nes-core.dir/tile_cache.cpp.o"
+  "CMakeFiles/nes-core.dir/tile_cache.cpp.o.d"
+  "CMakeFiles/nes-core.dir/trace.cpp.o"
+  "CMakeFiles/nes-core.dir/trace.cpp.o.d"
+  "CMakeFiles/nes-core.dir/trace_compare.cpp.o"
+  "CMakeFiles/nes-core.dir/trace_compare.cpp.o.d"
+  "libnes-core.a"
+  "libnes-core.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
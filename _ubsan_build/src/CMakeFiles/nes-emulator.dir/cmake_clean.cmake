@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-emulator.dir/main.cpp.o"
+  "CMakeFiles/nes-emulator.dir/main.cpp.o.d"
+  "nes-emulator"
+  "nes-emulator.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-emulator.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-headless.dir/headless_main.cpp.o"
+  "CMakeFiles/nes-headless.dir/headless_main.cpp.o.d"
+  "nes-headless"
+  "nes-headless.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-headless.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-opcode-pairs.dir/opcode_pairs_main.cpp.o"
+  "CMakeFiles/nes-opcode-pairs.dir/opcode_pairs_main.cpp.o.d"
+  "nes-opcode-pairs"
+  "nes-opcode-pairs.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-opcode-pairs.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
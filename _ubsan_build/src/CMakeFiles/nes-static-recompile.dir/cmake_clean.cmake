@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-static-recompile.dir/static_recompile_main.cpp.o"
+  "CMakeFiles/nes-static-recompile.dir/static_recompile_main.cpp.o.d"
+  "nes-static-recompile"
+  "nes-static-recompile.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-static-recompile.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-trace-compare.dir/trace_compare_main.cpp.o"
+  "CMakeFiles/nes-trace-compare.dir/trace_compare_main.cpp.o.d"
+  "nes-trace-compare"
+  "nes-trace-compare.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-trace-compare.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
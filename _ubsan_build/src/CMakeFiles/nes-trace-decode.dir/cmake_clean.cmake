@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-trace-decode.dir/trace_decode.cpp.o"
+  "CMakeFiles/nes-trace-decode.dir/trace_decode.cpp.o.d"
+  "nes-trace-decode"
+  "nes-trace-decode.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-trace-decode.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
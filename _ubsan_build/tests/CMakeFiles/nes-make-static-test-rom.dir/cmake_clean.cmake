@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-make-static-test-rom.dir/make_static_test_rom.cpp.o"
+  "CMakeFiles/nes-make-static-test-rom.dir/make_static_test_rom.cpp.o.d"
+  "nes-make-static-test-rom"
+  "nes-make-static-test-rom.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-make-static-test-rom.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,43 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/arithmetic_instruction_tests.cpp" "tests/CMakeFiles/nes-tests.dir/arithmetic_instruction_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/arithmetic_instruction_tests.cpp.o.d"
+  "/root/repo/tests/block_cache_tests.cpp" "tests/CMakeFiles/nes-tests.dir/block_cache_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/block_cache_tests.cpp.o.d"
+  "/root/repo/tests/branch_instruction_tests.cpp" "tests/CMakeFiles/nes-tests.dir/branch_instruction_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/branch_instruction_tests.cpp.o.d"
+  "/root/repo/tests/cartridge_tests.cpp" "tests/CMakeFiles/nes-tests.dir/cartridge_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/cartridge_tests.cpp.o.d"
+  "/root/repo/tests/execution_tests.cpp" "tests/CMakeFiles/nes-tests.dir/execution_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/execution_tests.cpp.o.d"
+  "/root/repo/tests/flag_instruction_tests.cpp" "tests/CMakeFiles/nes-tests.dir/flag_instruction_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/flag_instruction_tests.cpp.o.d"
+  "/root/repo/tests/frame_convert_tests.cpp" "tests/CMakeFiles/nes-tests.dir/frame_convert_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/frame_convert_tests.cpp.o.d"
+  "/root/repo/tests/headless_tests.cpp" "tests/CMakeFiles/nes-tests.dir/headless_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/headless_tests.cpp.o.d"
+  "/root/repo/tests/interrupt_tests.cpp" "tests/CMakeFiles/nes-tests.dir/interrupt_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/interrupt_tests.cpp.o.d"
+  "/root/repo/tests/load_instruction_tests.cpp" "tests/CMakeFiles/nes-tests.dir/load_instruction_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/load_instruction_tests.cpp.o.d"
+  "/root/repo/tests/logic_instruction_tests.cpp" "tests/CMakeFiles/nes-tests.dir/logic_instruction_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/logic_instruction_tests.cpp.o.d"
+  "/root/repo/tests/mapper_tests.cpp" "tests/CMakeFiles/nes-tests.dir/mapper_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/mapper_tests.cpp.o.d"
+  "/root/repo/tests/memory_tests.cpp" "tests/CMakeFiles/nes-tests.dir/memory_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/memory_tests.cpp.o.d"
+  "/root/repo/tests/ppu_tests.cpp" "tests/CMakeFiles/nes-tests.dir/ppu_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/ppu_tests.cpp.o.d"
+  "/root/repo/tests/profiler_tests.cpp" "tests/CMakeFiles/nes-tests.dir/profiler_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/profiler_tests.cpp.o.d"
+  "/root/repo/tests/recompiler_tests.cpp" "tests/CMakeFiles/nes-tests.dir/recompiler_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/recompiler_tests.cpp.o.d"
+  "/root/repo/tests/scheduler_tests.cpp" "tests/CMakeFiles/nes-tests.dir/scheduler_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/scheduler_tests.cpp.o.d"
+  "/root/repo/tests/stack_instruction_tests.cpp" "tests/CMakeFiles/nes-tests.dir/stack_instruction_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/stack_instruction_tests.cpp.o.d"
+  "/root/repo/tests/static_recompiler_tests.cpp" "tests/CMakeFiles/nes-tests.dir/static_recompiler_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/static_recompiler_tests.cpp.o.d"
+  "/root/repo/_ubsan_build/tests/static_test_program.cpp" "tests/CMakeFiles/nes-tests.dir/static_test_program.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/static_test_program.cpp.o.d"
+  "/root/repo/tests/tile_cache_tests.cpp" "tests/CMakeFiles/nes-tests.dir/tile_cache_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/tile_cache_tests.cpp.o.d"
+  "/root/repo/tests/trace_compare_tests.cpp" "tests/CMakeFiles/nes-tests.dir/trace_compare_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/trace_compare_tests.cpp.o.d"
+  "/root/repo/tests/trace_tests.cpp" "tests/CMakeFiles/nes-tests.dir/trace_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/trace_tests.cpp.o.d"
+  "/root/repo/tests/transfer_instruction_tests.cpp" "tests/CMakeFiles/nes-tests.dir/transfer_instruction_tests.cpp.o" "gcc" "tests/CMakeFiles/nes-tests.dir/transfer_instruction_tests.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_ubsan_build/src/CMakeFiles/nes-core.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,59 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nes-tests.dir/arithmetic_instruction_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/arithmetic_instruction_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/block_cache_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/block_cache_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/branch_instruction_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/branch_instruction_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/cartridge_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/cartridge_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/execution_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/execution_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/flag_instruction_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/flag_instruction_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/frame_convert_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/frame_convert_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/headless_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/headless_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/interrupt_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/interrupt_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/load_instruction_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/load_instruction_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/logic_instruction_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/logic_instruction_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/mapper_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/mapper_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/memory_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/memory_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/ppu_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/ppu_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/profiler_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/profiler_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/recompiler_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/recompiler_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/scheduler_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/scheduler_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/stack_instruction_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/stack_instruction_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/static_recompiler_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/static_recompiler_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/static_test_program.cpp.o"
+  "CMakeFiles/nes-tests.dir/static_test_program.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/tile_cache_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/tile_cache_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/trace_compare_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/trace_compare_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/trace_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/trace_tests.cpp.o.d"
+  "CMakeFiles/nes-tests.dir/transfer_instruction_tests.cpp.o"
+  "CMakeFiles/nes-tests.dir/transfer_instruction_tests.cpp.o.d"
+  "nes-tests"
+  "nes-tests.pdb"
+  "static_test.nes"
+  "static_test_program.cpp"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nes-tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,567 @@
+// Generated by nes-static-recompile, 64 instructions found from the vectors
+#include "cpu.h"
+#include "static_recompiler.h"
+
+static bool run_static_test(CPU6502& cpu)
+{
+    bool entered = false;
+    goto start;
+dispatch:
+    if (cpu.cycle_count >= cpu.stop_cycle) return true;
+    entered = true;
+start:
+    switch (cpu.registers.pc) {
+    case 0xC000: goto l_C000;
+    case 0xC002: goto l_C002;
+    case 0xC003: goto l_C003;
+    case 0xC005: goto l_C005;
+    case 0xC008: goto l_C008;
+    case 0xC00B: goto l_C00B;
+    case 0xC00C: goto l_C00C;
+    case 0xC00E: goto l_C00E;
+    case 0xC010: goto l_C010;
+    case 0xC012: goto l_C012;
+    case 0xC014: goto l_C014;
+    case 0xC016: goto l_C016;
+    case 0xC018: goto l_C018;
+    case 0xC019: goto l_C019;
+    case 0xC01C: goto l_C01C;
+    case 0xC01F: goto l_C01F;
+    case 0xC021: goto l_C021;
+    case 0xC023: goto l_C023;
+    case 0xC025: goto l_C025;
+    case 0xC026: goto l_C026;
+    case 0xC027: goto l_C027;
+    case 0xC02A: goto l_C02A;
+    case 0xC02C: goto l_C02C;
+    case 0xC02F: goto l_C02F;
+    case 0xC031: goto l_C031;
+    case 0xC060: goto l_C060;
+    case 0xC061: goto l_C061;
+    case 0xC062: goto l_C062;
+    case 0xC063: goto l_C063;
+    case 0xC065: goto l_C065;
+    case 0xC067: goto l_C067;
+    case 0xC06A: goto l_C06A;
+    case 0xC06D: goto l_C06D;
+    case 0xC06E: goto l_C06E;
+    case 0xC06F: goto l_C06F;
+    case 0xC070: goto l_C070;
+    case 0xC080: goto l_C080;
+    case 0xC082: goto l_C082;
+    case 0xC100: goto l_C100;
+    case 0xC102: goto l_C102;
+    case 0xC103: goto l_C103;
+    case 0xC105: goto l_C105;
+    case 0xC107: goto l_C107;
+    case 0xC109: goto l_C109;
+    case 0xC10B: goto l_C10B;
+    case 0xC10D: goto l_C10D;
+    case 0xC10F: goto l_C10F;
+    case 0xC110: goto l_C110;
+    case 0xC112: goto l_C112;
+    case 0xC114: goto l_C114;
+    case 0xC115: goto l_C115;
+    case 0xC117: goto l_C117;
+    case 0xC119: goto l_C119;
+    case 0xC11B: goto l_C11B;
+    case 0xC11D: goto l_C11D;
+    case 0xC120: goto l_C120;
+    case 0xC122: goto l_C122;
+    case 0xC125: goto l_C125;
+    case 0xC128: goto l_C128;
+    case 0xC12B: goto l_C12B;
+    case 0xC12D: goto l_C12D;
+    case 0xC12F: goto l_C12F;
+    case 0xC130: goto l_C130;
+    case 0xC132: goto l_C132;
+    default: return entered;
+    }
+
+l_C000: // LDX
+    cpu.registers.x = 0xFF;
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.x);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC002;
+        return true;
+    }
+l_C002: // TXS
+    cpu.registers.s = cpu.registers.x;
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC003;
+        return true;
+    }
+l_C003: // LDX
+    cpu.registers.x = 0x00;
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.x);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC005;
+        return true;
+    }
+l_C005: // LDA
+    cpu.registers.a = cpu.memory.read_byte(cpu.resolve_absx(0xC180));
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 4 + cpu.page_crossed;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC008;
+        return true;
+    }
+l_C008: // STA
+    cpu.memory.write_byte(cpu.resolve_absx(0x0300), cpu.registers.a);
+    cpu.cycle_count += 5;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC00B;
+        return true;
+    }
+l_C00B: // INX
+    cpu.registers.x = (uint8_t)(cpu.registers.x + 1);
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.x);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC00C;
+        return true;
+    }
+l_C00C: // CPX
+    cpu.registers.pc = 0xC00E;
+    cpu.cycle_count += cpu.cpx(0xC00D) + 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC00E;
+        return true;
+    }
+l_C00E: // BNE
+    cpu.cycle_count += 2;
+    if (!cpu.registers.p.zero_flag_set()) {
+        cpu.cycle_count += 1;
+        if (cpu.cycle_count >= cpu.stop_cycle) {
+            cpu.registers.pc = 0xC005;
+            return true;
+        }
+        goto l_C005;
+    }
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC010;
+        return true;
+    }
+l_C010: // LDA
+    cpu.registers.a = 0xF8;
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC012;
+        return true;
+    }
+l_C012: // STA
+    cpu.memory.write_byte(0x30, cpu.registers.a);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC014;
+        return true;
+    }
+l_C014: // LDA
+    cpu.registers.a = 0x02;
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC016;
+        return true;
+    }
+l_C016: // STA
+    cpu.memory.write_byte(0x31, cpu.registers.a);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC018;
+        return true;
+    }
+l_C018: // CLI
+    cpu.registers.pc = 0xC019;
+    cpu.cycle_count += cpu.cli(0) + 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC019;
+        return true;
+    }
+l_C019: // JSR
+    cpu.registers.pc = 0xC01C;
+    cpu.cycle_count += cpu.jsr(0xC100) + 6;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC100;
+        return true;
+    }
+    goto l_C100;
+l_C01C: // JSR
+    cpu.registers.pc = 0xC01F;
+    cpu.cycle_count += cpu.jsr(0xC120) + 6;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC120;
+        return true;
+    }
+    goto l_C120;
+l_C01F: // INC
+    cpu.registers.pc = 0xC021;
+    cpu.cycle_count += cpu.inc(0x10) + 5;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC021;
+        return true;
+    }
+l_C021: // LDA
+    cpu.registers.a = cpu.memory.read_byte(0x10);
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC023;
+        return true;
+    }
+l_C023: // AND
+    cpu.registers.a &= 0x03;
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC025;
+        return true;
+    }
+l_C025: // ASL
+    cpu.registers.pc = 0xC026;
+    cpu.cycle_count += cpu.asl_acc(0) + 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC026;
+        return true;
+    }
+l_C026: // TAX
+    cpu.registers.x = cpu.registers.a;
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.x);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC027;
+        return true;
+    }
+l_C027: // LDA
+    cpu.registers.a = cpu.memory.read_byte(cpu.resolve_absx(0xC190));
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 4 + cpu.page_crossed;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC02A;
+        return true;
+    }
+l_C02A: // STA
+    cpu.memory.write_byte(0x20, cpu.registers.a);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC02C;
+        return true;
+    }
+l_C02C: // LDA
+    cpu.registers.a = cpu.memory.read_byte(cpu.resolve_absx(0xC191));
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 4 + cpu.page_crossed;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC02F;
+        return true;
+    }
+l_C02F: // STA
+    cpu.memory.write_byte(0x21, cpu.registers.a);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC031;
+        return true;
+    }
+l_C031: // JMP
+    cpu.registers.pc = 0xC034;
+    cpu.cycle_count += cpu.jmp(cpu.resolve_ind(0x0020)) + 5;
+    goto dispatch;
+l_C060: // PHA
+    cpu.registers.pc = 0xC061;
+    cpu.cycle_count += cpu.pha(0) + 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC061;
+        return true;
+    }
+l_C061: // TXA
+    cpu.registers.a = cpu.registers.x;
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC062;
+        return true;
+    }
+l_C062: // PHA
+    cpu.registers.pc = 0xC063;
+    cpu.cycle_count += cpu.pha(0) + 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC063;
+        return true;
+    }
+l_C063: // INC
+    cpu.registers.pc = 0xC065;
+    cpu.cycle_count += cpu.inc(0x50) + 5;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC065;
+        return true;
+    }
+l_C065: // LDX
+    cpu.registers.x = cpu.memory.read_byte(0x50);
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.x);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC067;
+        return true;
+    }
+l_C067: // LDA
+    cpu.registers.a = cpu.memory.read_byte(cpu.resolve_absx(0xC000));
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 4 + cpu.page_crossed;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC06A;
+        return true;
+    }
+l_C06A: // STA
+    cpu.memory.write_byte(cpu.resolve_absx(0x0600), cpu.registers.a);
+    cpu.cycle_count += 5;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC06D;
+        return true;
+    }
+l_C06D: // PLA
+    cpu.registers.pc = 0xC06E;
+    cpu.cycle_count += cpu.pla(0) + 4;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC06E;
+        return true;
+    }
+l_C06E: // TAX
+    cpu.registers.x = cpu.registers.a;
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.x);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC06F;
+        return true;
+    }
+l_C06F: // PLA
+    cpu.registers.pc = 0xC070;
+    cpu.cycle_count += cpu.pla(0) + 4;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC070;
+        return true;
+    }
+l_C070: // RTI
+    cpu.registers.pc = 0xC071;
+    cpu.cycle_count += cpu.rti(0) + 6;
+    goto dispatch;
+l_C080: // INC
+    cpu.registers.pc = 0xC082;
+    cpu.cycle_count += cpu.inc(0x51) + 5;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC082;
+        return true;
+    }
+l_C082: // RTI
+    cpu.registers.pc = 0xC083;
+    cpu.cycle_count += cpu.rti(0) + 6;
+    goto dispatch;
+l_C100: // LDA
+    cpu.registers.a = cpu.memory.read_byte(0x10);
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC102;
+        return true;
+    }
+l_C102: // CLC
+    cpu.registers.p.clear_carry_flag();
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC103;
+        return true;
+    }
+l_C103: // ADC
+    cpu.registers.pc = 0xC105;
+    cpu.cycle_count += cpu.adc(0xC104) + 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC105;
+        return true;
+    }
+l_C105: // STA
+    cpu.memory.write_byte(0x12, cpu.registers.a);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC107;
+        return true;
+    }
+l_C107: // LDX
+    cpu.registers.x = cpu.memory.read_byte(0x12);
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.x);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC109;
+        return true;
+    }
+l_C109: // LDA
+    cpu.registers.a = cpu.memory.read_byte(cpu.resolve_zpx(0x00));
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 4;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC10B;
+        return true;
+    }
+l_C10B: // EOR
+    cpu.registers.a ^= cpu.memory.read_byte(0x12);
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC10D;
+        return true;
+    }
+l_C10D: // STA
+    cpu.memory.write_byte(cpu.resolve_zpx(0x40), cpu.registers.a);
+    cpu.cycle_count += 4;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC10F;
+        return true;
+    }
+l_C10F: // SEC
+    cpu.registers.p.set_carry_bit();
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC110;
+        return true;
+    }
+l_C110: // SBC
+    cpu.registers.pc = 0xC112;
+    cpu.cycle_count += cpu.sbc(0x13) + 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC112;
+        return true;
+    }
+l_C112: // STA
+    cpu.memory.write_byte(0x13, cpu.registers.a);
+    cpu.cycle_count += 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC114;
+        return true;
+    }
+l_C114: // LSR
+    cpu.registers.pc = 0xC115;
+    cpu.cycle_count += cpu.lsr_acc(0) + 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC115;
+        return true;
+    }
+l_C115: // ROR
+    cpu.registers.pc = 0xC117;
+    cpu.cycle_count += cpu.ror(0x14) + 5;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC117;
+        return true;
+    }
+l_C117: // BIT
+    cpu.registers.pc = 0xC119;
+    cpu.cycle_count += cpu.bit(0x14) + 3;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC119;
+        return true;
+    }
+l_C119: // BMI
+    cpu.cycle_count += 2;
+    if (cpu.registers.p.negative_flag_set()) {
+        cpu.cycle_count += 1;
+        if (cpu.cycle_count >= cpu.stop_cycle) {
+            cpu.registers.pc = 0xC11D;
+            return true;
+        }
+        goto l_C11D;
+    }
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC11B;
+        return true;
+    }
+l_C11B: // DEC
+    cpu.registers.pc = 0xC11D;
+    cpu.cycle_count += cpu.dec(0x15) + 5;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC11D;
+        return true;
+    }
+l_C11D: // RTS
+    cpu.registers.pc = 0xC11E;
+    cpu.cycle_count += cpu.rts(0) + 6;
+    goto dispatch;
+l_C120: // LDY
+    cpu.registers.y = 0xF0;
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.y);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC122;
+        return true;
+    }
+l_C122: // LDA
+    cpu.registers.a = cpu.memory.read_byte(cpu.resolve_absy(0x0220));
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 4 + cpu.page_crossed;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC125;
+        return true;
+    }
+l_C125: // ADC
+    cpu.registers.pc = 0xC128;
+    cpu.cycle_count += cpu.adc(cpu.resolve_absy(0x0400)) + 4;
+    cpu.cycle_count += cpu.page_crossed;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC128;
+        return true;
+    }
+l_C128: // STA
+    cpu.memory.write_byte(cpu.resolve_absy(0x0500), cpu.registers.a);
+    cpu.cycle_count += 5;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC12B;
+        return true;
+    }
+l_C12B: // EOR
+    cpu.io_cycle = cpu.cycle_count + 4 + ((cpu.memory.read_byte(0x30) + cpu.registers.y) >> 8);
+    cpu.registers.a ^= cpu.memory.read_byte(cpu.resolve_indy(0x30));
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 5 + cpu.page_crossed;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC12D;
+        return true;
+    }
+l_C12D: // LDA
+    cpu.io_cycle = cpu.cycle_count + 5;
+    cpu.registers.a = cpu.memory.read_byte(cpu.resolve_indx(0x40));
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);
+    cpu.cycle_count += 6;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC12F;
+        return true;
+    }
+l_C12F: // INY
+    cpu.registers.y = (uint8_t)(cpu.registers.y + 1);
+    cpu.registers.p.set_zero_and_negative_from(cpu.registers.y);
+    cpu.cycle_count += 2;
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC130;
+        return true;
+    }
+l_C130: // BNE
+    cpu.cycle_count += 2;
+    if (!cpu.registers.p.zero_flag_set()) {
+        cpu.cycle_count += 1;
+        if (cpu.cycle_count >= cpu.stop_cycle) {
+            cpu.registers.pc = 0xC122;
+            return true;
+        }
+        goto l_C122;
+    }
+    if (cpu.cycle_count >= cpu.stop_cycle) {
+        cpu.registers.pc = 0xC132;
+        return true;
+    }
+l_C132: // RTS
+    cpu.registers.pc = 0xC133;
+    cpu.cycle_count += cpu.rts(0) + 6;
+    goto dispatch;
+}
+
+[[maybe_unused]] static const bool registered_static_test =
+    register_static_program(StaticProgram{ "static_test", 0x1E1207130185E554, &run_static_test });
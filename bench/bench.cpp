@@ -0,0 +1,145 @@
+#include "bench.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+struct Benchmark
+{
+    const char* name;
+    bench_fn_t fn;
+};
+
+struct BenchResult
+{
+    const char* name;
+    uint64_t iterations;
+    uint64_t items;
+    double ns_per_item;
+};
+
+std::vector<Benchmark>& registry()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+double run_once(const Benchmark& benchmark, uint64_t iterations, uint64_t& items)
+{
+    BenchState state(iterations);
+    benchmark.fn(state);
+    items = std::max<uint64_t>(state.items_processed(), 1);
+    return (double)state.elapsed().count();
+}
+
+BenchResult run_benchmark(const Benchmark& benchmark, double min_time_ns, int repetitions)
+{
+    // grow the iteration count until a run takes long enough to be timed reliably
+    uint64_t iterations = 1;
+    uint64_t items      = 0;
+    while (true) {
+        const double elapsed = run_once(benchmark, iterations, items);
+        if (elapsed >= min_time_ns || iterations >= (1ull << 40)) break;
+
+        const double scale = elapsed > 0 ? min_time_ns * 1.2 / elapsed : 100.0;
+        iterations         = std::max(iterations + 1, (uint64_t)((double)iterations * std::min(scale, 100.0)));
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < repetitions; ++i) {
+        const double elapsed = run_once(benchmark, iterations, items);
+        samples.push_back(elapsed / (double)items);
+    }
+    std::sort(samples.begin(), samples.end());
+    return { benchmark.name, iterations, items, samples[samples.size() / 2] };
+}
+
+void write_json(FILE* file, const std::vector<BenchResult>& results)
+{
+    fmt::print(file, "{{\n  \"context\": {{\n");
+    fmt::print(file, "    \"build_type\": \"{}\",\n", NES_BENCH_BUILD_TYPE);
+    fmt::print(file, "    \"compiler\": \"{}\"\n", NES_BENCH_COMPILER);
+    fmt::print(file, "  }},\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        fmt::print(file,
+                   "    {{ \"name\": \"{}\", \"iterations\": {}, \"items\": {}, \"ns_per_item\": {:.4f}, "
+                   "\"items_per_second\": {:.0f} }}{}\n",
+                   result.name,
+                   result.iterations,
+                   result.items,
+                   result.ns_per_item,
+                   1e9 / result.ns_per_item,
+                   i + 1 < results.size() ? "," : "");
+    }
+    fmt::print(file, "  ]\n}}\n");
+}
+
+} // namespace
+
+bool register_benchmark(const char* name, bench_fn_t fn)
+{
+    registry().push_back({ name, std::move(fn) });
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string_view filter;
+    const char* json_path = nullptr;
+    double min_time_ns    = 0.1e9;
+    int repetitions       = 5;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            min_time_ns = std::atof(argv[++i]) * 1e9;
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else {
+            fmt::print("usage: <program_name> [--filter <substring>] [--json <file>] [--min-time <seconds>] "
+                       "[--repetitions <count>]\n");
+            return -1;
+        }
+    }
+
+    std::vector<Benchmark> benchmarks = registry();
+    std::sort(benchmarks.begin(), benchmarks.end(), [](const Benchmark& lhs, const Benchmark& rhs) {
+        return strcmp(lhs.name, rhs.name) < 0;
+    });
+
+    // the table goes to stderr so stdout can be piped straight into a JSON file
+    std::vector<BenchResult> results;
+    for (const Benchmark& benchmark : benchmarks) {
+        if (std::string_view(benchmark.name).find(filter) == std::string_view::npos) continue;
+
+        results.push_back(run_benchmark(benchmark, min_time_ns, repetitions));
+        const BenchResult& result = results.back();
+        fmt::print(stderr, "{:<44} {:>10.3f} ns {:>14.0f} /s\n", result.name, result.ns_per_item, 1e9 / result.ns_per_item);
+    }
+
+    if (json_path) {
+        FILE* file = fopen(json_path, "w");
+        if (!file) {
+            info_message("fopen failed: {}", strerror(errno));
+            return EXIT_FAILURE;
+        }
+        write_json(file, results);
+        fclose(file);
+    } else {
+        write_json(stdout, results);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// A minimal benchmark harness. Each benchmark is a function that does its setup and then loops over the state, which
+// times just the loop:
+//
+//     BENCHMARK("memory/read_byte/ram", [](BenchState& state) {
+//         CPU6502 cpu;
+//         for (uint64_t i : state) { do_not_optimize(cpu.memory.read_byte(i & 0x7FF)); }
+//     });
+//
+// The runner picks an iteration count that takes long enough to time, repeats it a few times and reports the median.
+class BenchState
+{
+public:
+    explicit BenchState(uint64_t iterations) : m_Iterations(iterations), m_Items(iterations) {}
+
+    class Iterator
+    {
+    public:
+        Iterator(BenchState* state, uint64_t index) : m_State(state), m_Index(index) {}
+
+        uint64_t operator*() const { return m_Index; }
+        Iterator& operator++()
+        {
+            m_Index++;
+            return *this;
+        }
+        bool operator!=(const Iterator& end)
+        {
+            if (m_Index != end.m_Index) [[likely]] return true;
+            m_State->m_Stop = std::chrono::steady_clock::now();
+            return false;
+        }
+
+    private:
+        BenchState* m_State;
+        uint64_t m_Index;
+    };
+
+    Iterator begin()
+    {
+        m_Start = std::chrono::steady_clock::now();
+        return Iterator(this, 0);
+    }
+    Iterator end() { return Iterator(this, m_Iterations); }
+
+    uint64_t iterations() const { return m_Iterations; }
+
+    // By default one iteration is one item, benchmarks that do a variable amount of work per iteration (a number of
+    // cycles rather than instructions, say) report how many items they got through instead
+    void set_items_processed(uint64_t items) { m_Items = items; }
+    uint64_t items_processed() const { return m_Items; }
+
+    std::chrono::nanoseconds elapsed() const { return m_Stop - m_Start; }
+
+private:
+    uint64_t m_Iterations;
+    uint64_t m_Items;
+    std::chrono::steady_clock::time_point m_Start;
+    std::chrono::steady_clock::time_point m_Stop;
+};
+
+using bench_fn_t = std::function<void(BenchState&)>;
+bool register_benchmark(const char* name, bench_fn_t fn);
+
+#define BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define BENCHMARK_CONCAT(a, b)      BENCHMARK_CONCAT_IMPL(a, b)
+#define BENCHMARK(name, ...)                                                                                           \
+    static const bool BENCHMARK_CONCAT(benchmark_registered_, __LINE__) = register_benchmark(name, __VA_ARGS__)
+
+// Stops the compiler from discarding a value that's computed only to be measured
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__ volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile T sink;
+    sink = value;
+#endif
+}
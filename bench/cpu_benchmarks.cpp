@@ -0,0 +1,113 @@
+#include "bench.h"
+#include "fixtures.h"
+
+#include "opcodes.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+// Runs a block of the same instruction over and over. Operands point at $0200 (directly, or through $10 for the
+// indirect modes) which holds $8000 so JMP ($0200) lands back on itself.
+void bench_instruction(BenchState& state, std::initializer_list<uint8_t> instruction)
+{
+    CPU6502 cpu;
+    load_program(cpu, repeat_instruction(std::vector<uint8_t>(instruction)));
+    cpu.memory.write_word(0x0010, 0x0200);
+    cpu.memory.write_word(0x0200, 0x8000);
+
+    for ([[maybe_unused]] uint64_t i : state) {
+        cpu.cycle_count += cpu.process_instruction();
+    }
+    do_not_optimize(cpu.registers);
+}
+
+BENCHMARK("dispatch/imm", [](BenchState& state) { bench_instruction(state, { OPCODE_LDA_IMM, 0x42 }); });
+BENCHMARK("dispatch/zp", [](BenchState& state) { bench_instruction(state, { OPCODE_LDA_ZP, 0x10 }); });
+BENCHMARK("dispatch/zpx", [](BenchState& state) { bench_instruction(state, { OPCODE_LDA_ZPX, 0x10 }); });
+BENCHMARK("dispatch/abs", [](BenchState& state) { bench_instruction(state, { OPCODE_LDA_ABS, 0x00, 0x02 }); });
+BENCHMARK("dispatch/absx", [](BenchState& state) { bench_instruction(state, { OPCODE_LDA_ABSX, 0x00, 0x02 }); });
+BENCHMARK("dispatch/absy", [](BenchState& state) { bench_instruction(state, { OPCODE_LDA_ABSY, 0x00, 0x02 }); });
+BENCHMARK("dispatch/indx", [](BenchState& state) { bench_instruction(state, { OPCODE_LDA_INDX, 0x10 }); });
+BENCHMARK("dispatch/indy", [](BenchState& state) { bench_instruction(state, { OPCODE_LDA_INDY, 0x10 }); });
+BENCHMARK("dispatch/imp", [](BenchState& state) { bench_instruction(state, { OPCODE_INX_IMP }); });
+BENCHMARK("dispatch/acc", [](BenchState& state) { bench_instruction(state, { OPCODE_ASL_ACC }); });
+BENCHMARK("dispatch/rel", [](BenchState& state) { bench_instruction(state, { OPCODE_BNE_REL, 0x00 }); });
+BENCHMARK("dispatch/abs_jmp", [](BenchState& state) { bench_instruction(state, { OPCODE_JMP_ABS, 0x00, 0x80 }); });
+BENCHMARK("dispatch/ind", [](BenchState& state) { bench_instruction(state, { OPCODE_JMP_IND, 0x00, 0x02 }); });
+BENCHMARK("dispatch/abs_store", [](BenchState& state) { bench_instruction(state, { OPCODE_STA_ABS, 0x00, 0x03 }); });
+
+BENCHMARK("stack/push_pop_byte", [](BenchState& state) {
+    CPU6502 cpu;
+    for (uint64_t i : state) {
+        cpu.stack_push_byte((uint8_t)i);
+        do_not_optimize(cpu.stack_pop_byte());
+    }
+});
+
+BENCHMARK("stack/push_pop_word", [](BenchState& state) {
+    CPU6502 cpu;
+    for (uint64_t i : state) {
+        cpu.stack_push_word((uint16_t)i);
+        do_not_optimize(cpu.stack_pop_word());
+    }
+});
+
+// A loop that sums a page of RAM into itself with a subroutine call on the way round, roughly the mix of loads,
+// stores, branches and stack use of real game code
+const std::array<uint8_t, 0x25> synthetic_program = {
+    OPCODE_LDX_IMM,  0x00,       // $8000 LDX #$00
+    OPCODE_LDA_ABSX, 0x00, 0x03, // $8002 LDA $0300,X
+    OPCODE_CLC_IMP,              // $8005 CLC
+    OPCODE_ADC_ZP,   0x10,       // $8006 ADC $10
+    OPCODE_STA_ABSX, 0x00, 0x03, // $8008 STA $0300,X
+    OPCODE_INY_IMP,              // $800B INY
+    OPCODE_INX_IMP,              // $800C INX
+    OPCODE_BNE_REL,  0xF3,       // $800D BNE $8002
+    OPCODE_JSR_ABS,  0x20, 0x80, // $800F JSR $8020
+    OPCODE_JMP_ABS,  0x00, 0x80, // $8012 JMP $8000
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    OPCODE_LDA_IMM,  0x01,       // $8020 LDA #$01
+    OPCODE_PHA_IMP,              // $8022 PHA
+    OPCODE_PLA_IMP,              // $8023 PLA
+    OPCODE_RTS_IMP,              // $8024 RTS
+};
+
+void bench_synthetic_program(BenchState& state, bool use_block_cache, bool use_recompiler, bool profiled = false)
+{
+    std::vector<uint8_t> prg(synthetic_program.begin(), synthetic_program.end());
+    prg.resize(0x8000);
+
+    CPU6502 cpu;
+    cpu.use_block_cache = use_block_cache;
+    cpu.use_recompiler  = use_recompiler;
+    load_program(cpu, prg);
+    auto profiler = std::make_unique<Profiler>();
+    if (profiled) cpu.profiler = profiler.get();
+
+    // this measures run_for_cycles as a whole so instructions are worked out from the program's average cycles per
+    // instruction, which is measured by stepping one instruction at a time first
+    uint64_t instructions = 0;
+    while (instructions < 100000) {
+        cpu.cycle_count += cpu.process_instruction();
+        instructions++;
+    }
+    const double cycles_per_instruction = (double)cpu.cycle_count / (double)instructions;
+
+    const uint64_t start_cycle = cpu.cycle_count;
+    for ([[maybe_unused]] uint64_t i : state) {
+        cpu.run_for_cycles(1000);
+    }
+    state.set_items_processed((uint64_t)((double)(cpu.cycle_count - start_cycle) / cycles_per_instruction));
+    do_not_optimize(cpu.registers);
+}
+
+BENCHMARK("cpu/synthetic_program", [](BenchState& state) { bench_synthetic_program(state, true, false); });
+BENCHMARK("cpu/synthetic_program_uncached", [](BenchState& state) { bench_synthetic_program(state, false, false); });
+BENCHMARK("cpu/synthetic_program_recompiled", [](BenchState& state) { bench_synthetic_program(state, true, true); });
+BENCHMARK("cpu/synthetic_program_profiled", [](BenchState& state) { bench_synthetic_program(state, true, false, true); });
+
+} // namespace
@@ -0,0 +1,38 @@
+#include "fixtures.h"
+
+#include "cartridge.h"
+#include "opcodes.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <utility>
+
+std::vector<uint8_t> make_nrom_image(std::span<const uint8_t> prg)
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, (uint8_t)(prg.size() / 0x4000), 1 };
+    image.resize(16 + prg.size() + 0x2000);
+    if (!prg.empty()) memcpy(image.data() + 16, prg.data(), prg.size());
+    return image;
+}
+
+void load_program(CPU6502& cpu, std::span<const uint8_t> prg)
+{
+    std::optional<Cartridge> cart = Cartridge::from_memory(make_nrom_image(prg));
+    if (!cart.has_value() || !cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*cart)))) {
+        std::abort();
+    }
+    cpu.registers.pc = 0x8000;
+}
+
+std::vector<uint8_t> repeat_instruction(std::span<const uint8_t> instruction)
+{
+    std::vector<uint8_t> prg;
+    while (prg.size() + instruction.size() + 3 <= 0x8000 - 6) {
+        prg.insert(prg.end(), instruction.begin(), instruction.end());
+    }
+    prg.insert(prg.end(), { OPCODE_JMP_ABS, 0x00, 0x80 });
+    prg.resize(0x8000);
+    return prg;
+}
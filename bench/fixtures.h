@@ -0,0 +1,16 @@
+#pragma once
+
+#include "cpu.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// An iNES image for mapper 0 with the given PRG (16 or 32KiB) and a blank 8KiB of CHR
+std::vector<uint8_t> make_nrom_image(std::span<const uint8_t> prg);
+
+// Loads prg as an NROM cartridge and points the CPU at $8000
+void load_program(CPU6502& cpu, std::span<const uint8_t> prg);
+
+// 32KiB of PRG that's the given instruction over and over, ending in a JMP back to $8000
+std::vector<uint8_t> repeat_instruction(std::span<const uint8_t> instruction);
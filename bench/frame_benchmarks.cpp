@@ -0,0 +1,59 @@
+#include "bench.h"
+#include "fixtures.h"
+
+#include "frame_convert.h"
+
+#include <vector>
+
+namespace
+{
+
+// A frame of the backdrop with the emphasis changing halfway down, converted once per iteration
+void bench_convert_frame(BenchState& state, PixelFormat format, bool half_size, bool ssse3)
+{
+    CPU6502 cpu;
+    load_program(cpu, std::vector<uint8_t>(0x8000, 0xEA));
+    cpu.memory.write_byte(0x2006, 0x3F);
+    cpu.memory.write_byte(0x2006, 0x00);
+    cpu.memory.write_byte(0x2007, 0x16);
+    cpu.run_frame();
+    while (cpu.ppu.scanline() != 120) {
+        cpu.run_until(cpu.cycle_count + 1);
+        cpu.ppu.catch_up();
+    }
+    cpu.memory.write_byte(0x2001, 0x20);
+    cpu.run_frame();
+
+    std::vector<uint8_t> out(converted_frame_size(format, half_size));
+    frame_convert_use_ssse3 = ssse3;
+    for ([[maybe_unused]] uint64_t i : state) {
+        do_not_optimize(convert_frame(cpu.ppu, format, half_size, out));
+        do_not_optimize(out[0]);
+    }
+    frame_convert_use_ssse3 = true;
+}
+
+BENCHMARK("frame/convert/rgba", [](BenchState& state) {
+    bench_convert_frame(state, PixelFormat::Rgba8888, false, true);
+});
+BENCHMARK("frame/convert/rgb565", [](BenchState& state) {
+    bench_convert_frame(state, PixelFormat::Rgb565, false, true);
+});
+BENCHMARK("frame/convert/gray", [](BenchState& state) { bench_convert_frame(state, PixelFormat::Gray8, false, true); });
+BENCHMARK("frame/convert/rgba_half", [](BenchState& state) {
+    bench_convert_frame(state, PixelFormat::Rgba8888, true, true);
+});
+BENCHMARK("frame/convert_scalar/rgba", [](BenchState& state) {
+    bench_convert_frame(state, PixelFormat::Rgba8888, false, false);
+});
+BENCHMARK("frame/convert_scalar/rgb565", [](BenchState& state) {
+    bench_convert_frame(state, PixelFormat::Rgb565, false, false);
+});
+BENCHMARK("frame/convert_scalar/gray", [](BenchState& state) {
+    bench_convert_frame(state, PixelFormat::Gray8, false, false);
+});
+BENCHMARK("frame/convert_scalar/rgba_half", [](BenchState& state) {
+    bench_convert_frame(state, PixelFormat::Rgba8888, true, false);
+});
+
+} // namespace
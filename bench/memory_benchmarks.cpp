@@ -0,0 +1,94 @@
+#include "bench.h"
+#include "fixtures.h"
+
+#include "cartridge.h"
+
+#include <optional>
+#include <vector>
+
+namespace
+{
+
+// Each region is walked with a stride so consecutive accesses don't all hit the same byte
+struct Region
+{
+    uint16_t base;
+    uint16_t mask;
+};
+
+constexpr Region ram           = { 0x0000, 0x07FF };
+constexpr Region ram_mirror    = { 0x0800, 0x07FF };
+constexpr Region ppu_registers = { 0x2000, 0x1FFF };
+constexpr Region apu_registers = { 0x4000, 0x0017 };
+constexpr Region prg_ram       = { 0x6000, 0x1FFF };
+constexpr Region prg_rom       = { 0x8000, 0x7FFF };
+
+uint16_t region_address(Region region, uint64_t i)
+{
+    return (uint16_t)(region.base + ((i * 7) & region.mask));
+}
+
+void load_nrom(CPU6502& cpu)
+{
+    load_program(cpu, std::vector<uint8_t>(0x8000, 0xEA));
+}
+
+void bench_read_byte(BenchState& state, Region region)
+{
+    CPU6502 cpu;
+    load_nrom(cpu);
+    for (uint64_t i : state) {
+        do_not_optimize(cpu.memory.read_byte(region_address(region, i)));
+    }
+}
+
+void bench_write_byte(BenchState& state, Region region)
+{
+    CPU6502 cpu;
+    load_nrom(cpu);
+    for (uint64_t i : state) {
+        cpu.memory.write_byte(region_address(region, i), (uint8_t)i);
+    }
+    do_not_optimize(cpu.memory.read_byte(region.base));
+}
+
+void bench_read_word(BenchState& state, Region region)
+{
+    CPU6502 cpu;
+    load_nrom(cpu);
+    // keep the second byte inside the region
+    region.mask &= 0xFFFE;
+    for (uint64_t i : state) {
+        do_not_optimize(cpu.memory.read_word(region_address(region, i)));
+    }
+}
+
+BENCHMARK("memory/read_byte/ram", [](BenchState& state) { bench_read_byte(state, ram); });
+BENCHMARK("memory/read_byte/ram_mirror", [](BenchState& state) { bench_read_byte(state, ram_mirror); });
+BENCHMARK("memory/read_byte/ppu_registers", [](BenchState& state) { bench_read_byte(state, ppu_registers); });
+BENCHMARK("memory/read_byte/apu_registers", [](BenchState& state) { bench_read_byte(state, apu_registers); });
+BENCHMARK("memory/read_byte/prg_ram", [](BenchState& state) { bench_read_byte(state, prg_ram); });
+BENCHMARK("memory/read_byte/prg_rom", [](BenchState& state) { bench_read_byte(state, prg_rom); });
+
+BENCHMARK("memory/write_byte/ram", [](BenchState& state) { bench_write_byte(state, ram); });
+BENCHMARK("memory/write_byte/ram_mirror", [](BenchState& state) { bench_write_byte(state, ram_mirror); });
+BENCHMARK("memory/write_byte/ppu_registers", [](BenchState& state) { bench_write_byte(state, ppu_registers); });
+BENCHMARK("memory/write_byte/apu_registers", [](BenchState& state) { bench_write_byte(state, apu_registers); });
+BENCHMARK("memory/write_byte/prg_ram", [](BenchState& state) { bench_write_byte(state, prg_ram); });
+BENCHMARK("memory/write_byte/mapper_register", [](BenchState& state) { bench_write_byte(state, prg_rom); });
+
+BENCHMARK("memory/read_word/ram", [](BenchState& state) { bench_read_word(state, ram); });
+BENCHMARK("memory/read_word/prg_ram", [](BenchState& state) { bench_read_word(state, prg_ram); });
+BENCHMARK("memory/read_word/prg_rom", [](BenchState& state) { bench_read_word(state, prg_rom); });
+
+// 256KiB of PRG and 128KiB of CHR, the size of a big MMC3 game
+BENCHMARK("cartridge/from_memory", [](BenchState& state) {
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, 16, 16, 0x40, 0 };
+    image.resize(16 + 16 * 0x4000 + 16 * 0x2000);
+    for ([[maybe_unused]] uint64_t i : state) {
+        std::optional<Cartridge> cart = Cartridge::from_memory(image);
+        do_not_optimize(cart->get_program_data().data());
+    }
+});
+
+} // namespace
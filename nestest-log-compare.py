@@ -72,7 +72,8 @@ def format_out_file(file):
         final_out_file.write(line)
 
 raw_out_file = open("./roms/nes-emulator-raw.log", "r+")
-subprocess.run(["./build/src/nes-emulator", "./roms/nes-test-roms/other/nestest.nes"], stderr=raw_out_file)
+subprocess.run(["./build/src/nes-emulator", "./roms/nes-test-roms/other/nestest.nes", "--trace", "./roms/nes-emulator.trace"])
+subprocess.run(["./build/src/nes-trace-decode", "./roms/nes-emulator.trace"], stdout=raw_out_file)
 raw_out_file.close()
 
 raw_out_file = open("./roms/nes-emulator-raw.log", "r+")
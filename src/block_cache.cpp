@@ -0,0 +1,204 @@
+#include "block_cache.h"
+
+#include "cpu.h"
+
+#include <algorithm>
+
+BlockCache::BlockCache(Memory& memory, uint64_t& stop_cycle) : m_Memory(memory), m_StopCycle(stop_cycle)
+{
+    m_Memory.set_watcher(this);
+}
+
+BlockCache::~BlockCache()
+{
+    m_Memory.set_watcher(nullptr);
+}
+
+static bool is_branch(const CPU6502::Instruction& instruction)
+{
+    const CPU6502::operation_fn_t operation = instruction.operation_fn;
+    return operation == &CPU6502::bcc || operation == &CPU6502::bcs || operation == &CPU6502::beq ||
+           operation == &CPU6502::bne || operation == &CPU6502::bmi || operation == &CPU6502::bpl ||
+           operation == &CPU6502::bvc || operation == &CPU6502::bvs;
+}
+
+// anything that can send pc somewhere other than the next instruction
+static bool ends_block(const CPU6502::Instruction& instruction)
+{
+    const CPU6502::operation_fn_t operation = instruction.operation_fn;
+    return is_branch(instruction) || operation == &CPU6502::jmp || operation == &CPU6502::jsr ||
+           operation == &CPU6502::rts || operation == &CPU6502::rti || operation == &CPU6502::brk;
+}
+
+// Instructions that at most read memory at a fixed address and change registers. Stepping a register is left out as a
+// loop doing it can't come back round unchanged, which leaves a counting loop like DEX; BNE to be fused instead.
+static bool only_reads(const CPU6502::Instruction& instruction)
+{
+    const AddressingMode mode = instruction.mode;
+    if (mode != AddressingMode::Accumulator && mode != AddressingMode::Implied && mode != AddressingMode::Immediate &&
+        mode != AddressingMode::ZeroPage && mode != AddressingMode::Absolute) {
+        return false;
+    }
+
+    constexpr CPU6502::operation_fn_t reads[] = {
+        &CPU6502::lda,     &CPU6502::ldx,     &CPU6502::ldy,     &CPU6502::bit,     &CPU6502::cmp,    &CPU6502::cpx,
+        &CPU6502::cpy,     &CPU6502::and_op,  &CPU6502::ora,     &CPU6502::eor,     &CPU6502::adc,    &CPU6502::sbc,
+        &CPU6502::nop,     &CPU6502::clc,     &CPU6502::sec,     &CPU6502::cld,     &CPU6502::sed,    &CPU6502::cli,
+        &CPU6502::sei,     &CPU6502::clv,     &CPU6502::tax,     &CPU6502::tay,     &CPU6502::txa,    &CPU6502::tya,
+        &CPU6502::tsx,     &CPU6502::txs,     &CPU6502::asl_acc, &CPU6502::lsr_acc, &CPU6502::rol_acc,
+        &CPU6502::ror_acc,
+    };
+    return std::find(std::begin(reads), std::end(reads), instruction.operation_fn) != std::end(reads);
+}
+
+// A block that goes back to its own start having only read memory, which the CPU may be able to skip ahead through,
+// see CPU6502::fast_forward_idle_loop
+static bool is_idle_loop(std::span<const DecodedInstruction> block, uint16_t pc)
+{
+    uint16_t end = pc;
+    for (const DecodedInstruction& decoded : block) {
+        end += decoded.bytes;
+    }
+
+    const DecodedInstruction& last          = block.back();
+    const CPU6502::Instruction& instruction = CPU6502::instruction(last.opcode);
+    const bool branches_back = is_branch(instruction) && (uint16_t)(end + (int8_t)last.operand) == pc;
+    const bool jumps_back    = instruction.operation_fn == &CPU6502::jmp &&
+                            instruction.mode == AddressingMode::Absolute && last.operand == pc;
+    if (!branches_back && !jumps_back) return false;
+
+    return std::all_of(block.begin(), block.end() - 1, [](const DecodedInstruction& decoded) {
+        return only_reads(CPU6502::instruction(decoded.opcode));
+    });
+}
+
+std::span<const DecodedInstruction> BlockCache::decode_block(uint16_t pc)
+{
+    const uint8_t page_index = pc >> 8;
+    const uint8_t* host      = m_Memory.read_page(page_index);
+    if (!host) return {};
+
+    std::unique_ptr<CodePage>& slot = m_Pages[page_index];
+    if (!slot) slot = std::make_unique<CodePage>();
+    CodePage& page = *slot;
+    if (!page.valid) {
+        if (page.host != host) page.invalidations = 0;
+        if (page.invalidations >= max_invalidations) return {};
+
+        page.host  = host;
+        page.valid = true;
+        page.blocks.fill({});
+        page.native.fill({});
+        page.instructions.clear();
+        watch(host);
+    }
+
+    BlockRange& range = page.blocks[pc & 0xFF];
+    range.first       = (uint16_t)page.instructions.size();
+    range.count       = 0;
+    for (size_t offset = pc & 0xFF; offset < 0x100;) {
+        const uint8_t opcode                    = host[offset];
+        const CPU6502::Instruction& instruction = CPU6502::instruction(opcode);
+        if (instruction.operation_fn == &CPU6502::illegal_opcode || offset + instruction.bytes > 0x100) break;
+
+        DecodedInstruction decoded = { CPU6502::decoded_handler(opcode), 0, instruction.bytes, opcode };
+        if (instruction.bytes > 1) decoded.operand = host[offset + 1];
+        if (instruction.bytes > 2) decoded.operand |= (uint16_t)(host[offset + 2] << 8);
+        page.instructions.push_back(decoded);
+        range.count++;
+
+        offset += instruction.bytes;
+        if (ends_block(instruction)) break;
+    }
+
+    const std::span<DecodedInstruction> block = std::span(page.instructions).subspan(range.first, range.count);
+    if (block.empty()) return block;
+    if (is_idle_loop(block, pc)) {
+        // these are skipped through rather than run, and the skipping goes by the operands
+        block.back().handler = CPU6502::idle_loop_handler(block.back().opcode);
+    } else if (fuse_pairs) {
+        fuse(block);
+    }
+    return block;
+}
+
+// Pairs are taken from the start of the block, so of three in a row that could each be fused with the next only the
+// first two are
+void BlockCache::fuse(std::span<DecodedInstruction> block)
+{
+    for (size_t i = 0; i + 1 < block.size(); i += block[i].length) {
+        DecodedInstruction& first        = block[i];
+        const DecodedInstruction& second = block[i + 1];
+        const auto handler               = CPU6502::fused_pair_handler(first.opcode, second.opcode);
+        if (!handler) continue;
+
+        first.handler = handler;
+        first.operand |= second.operand << 16;
+        first.length = 2;
+    }
+}
+
+void BlockCache::drop_native_blocks()
+{
+    for (std::unique_ptr<CodePage>& page : m_Pages) {
+        if (page) page->native.fill({});
+    }
+}
+
+void BlockCache::watch(const uint8_t* host)
+{
+    bool writable = false;
+    for (size_t page = 0; page < 0x100; ++page) {
+        if (m_Memory.write_page((uint8_t)page) == host) {
+            m_Memory.watch_writes((uint8_t)page);
+            writable = true;
+        }
+    }
+
+    if (writable && std::find(m_WatchedHosts.begin(), m_WatchedHosts.end(), host) == m_WatchedHosts.end()) {
+        m_WatchedHosts.push_back(host);
+    }
+}
+
+void BlockCache::unwatch(const uint8_t* host)
+{
+    for (size_t page = 0; page < 0x100; ++page) {
+        if (m_Memory.watched_page((uint8_t)page) == host) {
+            m_Memory.unwatch_writes((uint8_t)page);
+        }
+    }
+    std::erase(m_WatchedHosts, host);
+}
+
+void BlockCache::watched_write(const uint8_t* backing)
+{
+    // the written page may be a mirror of the one the code was decoded through, so go by the memory behind it
+    for (std::unique_ptr<CodePage>& page : m_Pages) {
+        if (page && page->valid && page->host == backing) {
+            page->valid = false;
+            page->invalidations++;
+            m_StopCycle = 0;
+        }
+    }
+
+    // writes go back to the fast path until something is decoded from this memory again
+    unwatch(backing);
+}
+
+void BlockCache::pages_remapped(uint8_t first_page, size_t page_count)
+{
+    for (size_t page_index = first_page; page_index < first_page + page_count; ++page_index) {
+        CodePage* page = m_Pages[page_index].get();
+        if (page && page->valid && page->host != m_Memory.read_page((uint8_t)page_index)) {
+            page->valid = false;
+            m_StopCycle = 0;
+        }
+
+        // a page that's now mapped to write to memory that code was decoded from needs watching as well
+        const uint8_t* write_page = m_Memory.write_page((uint8_t)page_index);
+        if (write_page &&
+            std::find(m_WatchedHosts.begin(), m_WatchedHosts.end(), write_page) != m_WatchedHosts.end()) {
+            m_Memory.watch_writes((uint8_t)page_index);
+        }
+    }
+}
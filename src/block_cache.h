@@ -0,0 +1,113 @@
+#pragma once
+
+#include "memory.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+class CPU6502;
+
+// An instruction whose operand bytes have already been fetched, handler executes it. A pair of instructions the block
+// cache has fused has the pair's handler on the first, with the second's operand in the top half of operand, and
+// length 2 so the second is skipped over. The second is still there as it was for anything looking through the block.
+struct DecodedInstruction
+{
+    uint8_t (*handler)(CPU6502& cpu, uint32_t operand);
+    uint32_t operand;
+    uint8_t bytes;
+    uint8_t opcode;
+    uint8_t length = 1;
+};
+
+// A block translated to machine code by the Recompiler. It's only safe to enter when at least max_cycles are left
+// before the CPU has to stop, as it runs every instruction in the block without checking in between.
+struct NativeBlock
+{
+    void (*entry)(CPU6502& cpu) = nullptr;
+    uint16_t max_cycles         = 0;
+    uint16_t hits               = 0; // how many times the block has been run by the interpreter
+};
+
+// Runs of instructions decoded ahead of time so tight loops aren't fetched and decoded over and over. A block starts
+// wherever execution lands and ends after the first instruction that can change pc, or at the end of the page, so it
+// only ever depends on the one page it was decoded from.
+// Pages are dropped when they're mapped to something else (a bank switch). Pages of writable memory are watched so a
+// write drops whatever was decoded from them, ROM can't be written so it stays until it's switched out.
+class BlockCache : public MemoryWatcher
+{
+public:
+    // stop_cycle is zeroed whenever code is dropped so the CPU stops running the block it might be part way through
+    BlockCache(Memory& memory, uint64_t& stop_cycle);
+    ~BlockCache() override;
+    BlockCache(const BlockCache&)            = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    // Empty when the instruction at pc can't be decoded ahead of time (it's in registers, runs off the end of the
+    // page, is an illegal opcode or its page keeps being written to) in which case it has to be run on its own
+    std::span<const DecodedInstruction> block_at(uint16_t pc)
+    {
+        const CodePage* page = m_Pages[pc >> 8].get();
+        if (page && page->valid) [[likely]] {
+            const BlockRange range = page->blocks[pc & 0xFF];
+            if (range.first != not_decoded) {
+                return std::span(page->instructions).subspan(range.first, range.count);
+            }
+        }
+        return decode_block(pc);
+    }
+
+    // The same but never decodes, empty when there isn't a block cached for pc
+    std::span<const DecodedInstruction> cached_block_at(uint16_t pc) const
+    {
+        const CodePage* page = m_Pages[pc >> 8].get();
+        if (!page || !page->valid) return {};
+        const BlockRange range = page->blocks[pc & 0xFF];
+        if (range.first == not_decoded) return {};
+        return std::span(page->instructions).subspan(range.first, range.count);
+    }
+
+    // The native code slot of the block block_at(pc) just returned, which is cleared whenever the block is dropped
+    NativeBlock& native_block(uint16_t pc) { return m_Pages[pc >> 8]->native[pc & 0xFF]; }
+    // Forgets every translation, for when the code they point at is about to be overwritten
+    void drop_native_blocks();
+
+    // Runs the pairs of instructions in fused_pairs.h as one, which only applies to blocks decoded after it's changed
+    bool fuse_pairs = true;
+
+    void watched_write(const uint8_t* backing) override;
+    void pages_remapped(uint8_t first_page, size_t page_count) override;
+
+private:
+    static constexpr uint16_t not_decoded = 0xFFFF;
+    // a page that's written to this often is probably data as well as code, so stop decoding it
+    static constexpr uint8_t max_invalidations = 16;
+
+    struct BlockRange
+    {
+        uint16_t first = not_decoded; // index into CodePage::instructions
+        uint16_t count = 0;
+    };
+
+    struct CodePage
+    {
+        const uint8_t* host   = nullptr; // the memory the page was mapped to when it was decoded
+        bool valid            = false;
+        uint8_t invalidations = 0;
+        std::array<BlockRange, 0x100> blocks;
+        std::array<NativeBlock, 0x100> native;
+        std::vector<DecodedInstruction> instructions;
+    };
+
+    std::span<const DecodedInstruction> decode_block(uint16_t pc);
+    static void fuse(std::span<DecodedInstruction> block);
+    void watch(const uint8_t* host);
+    void unwatch(const uint8_t* host);
+
+    Memory& m_Memory;
+    uint64_t& m_StopCycle;
+    std::array<std::unique_ptr<CodePage>, 0x100> m_Pages;
+    std::vector<const uint8_t*> m_WatchedHosts; // writable memory that code has been decoded from
+};
@@ -2,8 +2,17 @@
 
 #include "log.h"
 
+#include <cerrno>
+#include <cstring>
 #include <memory>
 #include <optional>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    define NES_HAVE_MMAP 1
+#endif
 
 // NOTE: this implementation is for the file format INES
 
@@ -15,27 +24,54 @@ std::optional<Cartridge> Cartridge::from_file(const char* file_name)
         return std::nullopt;
     }
 
-    return from_file(file);
+    std::optional<Cartridge> cart = from_file(file);
+    fclose(file);
+    return cart;
 }
 
 std::optional<Cartridge> Cartridge::from_file(FILE* file)
 {
-    auto buffer       = std::make_unique<uint8_t[]>(max_size);
-    size_t bytes_read = fread(buffer.get(), 1, max_size, file);
+#ifdef NES_HAVE_MMAP
+    // the mapping stays valid after the file is closed
+    struct stat file_stat;
+    if (fstat(fileno(file), &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+        const size_t size = (size_t)file_stat.st_size;
+        void* mapping     = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if (mapping != MAP_FAILED) {
+            std::unique_ptr<const uint8_t, Unmapper> image((const uint8_t*)mapping, Unmapper{ size });
+            std::optional<Cartridge> cart = from_image(std::span(image.get(), size));
+            if (cart) cart->m_MappedImage = std::move(image);
+            return cart;
+        }
+        info_message("mmap failed, falling back to reading the file: {}", strerror(errno));
+    }
+#endif
+
+    // not something we can map (a pipe, or no mmap on this platform) so read the whole thing
+    std::vector<uint8_t> buffer;
+    uint8_t chunk[0x4000];
+    while (size_t bytes_read = fread(chunk, 1, sizeof(chunk), file)) {
+        buffer.insert(buffer.end(), chunk, chunk + bytes_read);
+    }
     if (ferror(file)) {
         info_message("fread failed: {}", errno);
         return std::nullopt;
     }
-    if (!feof(file)) {
-        info_message("fread no eof hit after {} bytes", bytes_read);
-        return std::nullopt;
-    }
 
-    // DEBUG_LOG("fread got eof after {} bytes", bytes_read);
-    return from_memory(std::span(buffer.get(), bytes_read));
+    return from_memory(buffer);
+}
+
+std::optional<Cartridge> Cartridge::from_memory(std::span<const uint8_t> buf)
+{
+    auto image = std::make_unique<uint8_t[]>(buf.size());
+    memcpy(image.get(), buf.data(), buf.size());
+
+    std::optional<Cartridge> cart = from_image(std::span(image.get(), buf.size()));
+    if (cart) cart->m_OwnedImage = std::move(image);
+    return cart;
 }
 
-std::optional<Cartridge> Cartridge::from_memory(std::span<uint8_t> buf)
+std::optional<Cartridge> Cartridge::from_image(std::span<const uint8_t> buf)
 {
     if (buf.size() < 16 || buf[0] != 'N' || buf[1] != 'E' || buf[2] != 'S' || buf[3] != 0x1A) {
         info_message("rom has invalid signature");
@@ -52,10 +88,6 @@ std::optional<Cartridge> Cartridge::from_memory(std::span<uint8_t> buf)
     // info_message("ram banks: {}", cart->m_Header.ram_banks);
     // info_message("mapper number: {}", cart->m_Header.get_mapper_number());
 
-    if (cart->m_Header.control_byte_1 & (1 << 1)) {
-        info_message("has battery backed ram, not supported yet");
-        return std::nullopt;
-    }
     if (cart->m_Header.control_byte_1 & (1 << 2)) {
         info_message("has trainer, not supported yet");
         return std::nullopt;
@@ -63,36 +95,54 @@ std::optional<Cartridge> Cartridge::from_memory(std::span<uint8_t> buf)
 
     const uint32_t program_size = cart->m_Header.prg_bank_count * 16 * 1024;
     buf                         = buf.subspan(16);
-    cart->m_PrgData             = std::make_unique<uint8_t[]>(program_size);
     if (buf.size() < program_size) {
         info_message("program memory ({}) claimed to be larger than what exists ({})", program_size, buf.size());
         return std::nullopt;
     }
-    memcpy(cart->m_PrgData.get(), buf.data(), program_size);
+    cart->m_PrgData = buf.first(program_size);
 
     const uint32_t video_size = cart->m_Header.chr_bank_count * 8192;
     buf                       = buf.subspan(program_size);
-    cart->m_VideoData         = std::make_unique<uint8_t[]>(video_size);
     if (buf.size() < video_size) {
         info_message("video memory ({}) claimed to be larger than what exists ({})", video_size, buf.size());
         return std::nullopt;
     }
-    memcpy(cart->m_VideoData.get(), buf.data(), video_size);
+    cart->m_VideoData = buf.first(video_size);
 
     return cart;
 }
 
+void Cartridge::Unmapper::operator()(const uint8_t* data) const
+{
+#ifdef NES_HAVE_MMAP
+    munmap(const_cast<uint8_t*>(data), size);
+#else
+    (void)data;
+#endif
+}
+
 uint8_t Cartridge::Header::get_mapper_number() const
 {
-    return control_byte_2 | (control_byte_1 >> 4);
+    return (control_byte_2 & 0xF0) | (control_byte_1 >> 4);
+}
+
+uint8_t Cartridge::get_mapper_number() const
+{
+    return m_Header.get_mapper_number();
+}
+
+Mirroring Cartridge::get_mirroring() const
+{
+    if (m_Header.control_byte_1 & (1 << 3)) return Mirroring::FourScreen;
+    return (m_Header.control_byte_1 & 1) ? Mirroring::Vertical : Mirroring::Horizontal;
 }
 
 std::span<const uint8_t> Cartridge::get_program_data() const
 {
-    return std::span<const uint8_t>(m_PrgData.get(), m_Header.prg_bank_count * 16 * 1024);
+    return m_PrgData;
 }
 
 std::span<const uint8_t> Cartridge::get_video_data() const
 {
-    return std::span<const uint8_t>(m_VideoData.get(), m_Header.chr_bank_count * 8192);
+    return m_VideoData;
 }
@@ -6,16 +6,27 @@
 #include <optional>
 #include <span>
 
+enum class Mirroring {
+    Horizontal,
+    Vertical,
+    SingleScreenLow,
+    SingleScreenHigh,
+    FourScreen
+};
+
 class Cartridge
 {
 public:
-    static inline size_t max_size = 0x8000;
+    // from_file maps the ROM read-only where the platform allows it so only the parts that are used get paged in,
+    // from_memory copies the image into a buffer owned by the cartridge
     static std::optional<Cartridge> from_file(const char* file_name);
     static std::optional<Cartridge> from_file(FILE* file);
-    static std::optional<Cartridge> from_memory(std::span<uint8_t> mem);
+    static std::optional<Cartridge> from_memory(std::span<const uint8_t> mem);
 
     std::span<const uint8_t> get_program_data() const;
     std::span<const uint8_t> get_video_data() const;
+    uint8_t get_mapper_number() const;
+    Mirroring get_mirroring() const;
 
 private:
     struct [[gnu::packed]] Header
@@ -30,8 +41,21 @@ private:
 
         uint8_t get_mapper_number() const;
     };
+
+    struct Unmapper
+    {
+        size_t size;
+        void operator()(const uint8_t* data) const;
+    };
+
+    static std::optional<Cartridge> from_image(std::span<const uint8_t> image);
+
     Header m_Header;
 
-    std::unique_ptr<uint8_t[]> m_PrgData;
-    std::unique_ptr<uint8_t[]> m_VideoData;
+    // only one of these holds the image, the PRG and CHR spans point into it
+    std::unique_ptr<const uint8_t, Unmapper> m_MappedImage = { nullptr, Unmapper{ 0 } };
+    std::unique_ptr<uint8_t[]> m_OwnedImage;
+
+    std::span<const uint8_t> m_PrgData;
+    std::span<const uint8_t> m_VideoData;
 };
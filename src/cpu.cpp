@@ -1,22 +1,14 @@
 #include "cpu.h"
 
+#include "fused_pairs.h"
 #include "log.h"
 #include "opcodes.h"
+#include "trace.h"
+#include <algorithm>
 #include <cstdint>
+#include <string_view>
 #include <utility>
 
-static void log_cpu_state(const CPU6502& cpu)
-{
-    info_message("a: {:02X}  x: {:02X}  y: {:02X}  sp: {:02X}  flags: {}({:02X})  cycles: {:5}",
-                 cpu.registers.a,
-                 cpu.registers.x,
-                 cpu.registers.y,
-                 cpu.registers.s,
-                 cpu.registers.p,
-                 (uint8_t)cpu.registers.p.reg,
-                 cpu.cycle_count);
-}
-
 static constexpr uint8_t BIT_6 = (1 << 6);
 static constexpr uint8_t BIT_7 = (1 << 7);
 
@@ -65,7 +57,329 @@ StatusRegFlag operator~(StatusRegFlag a)
 
 bool operator==(StatusRegister lhs, StatusRegister rhs)
 {
-    return lhs.reg == rhs.reg;
+    return lhs.value() == rhs.value();
+}
+
+// opcode plus operands
+static constexpr uint8_t instruction_bytes(AddressingMode mode)
+{
+    switch (mode) {
+        case AddressingMode::Implied:
+        case AddressingMode::Accumulator: return 1;
+        case AddressingMode::Absolute:
+        case AddressingMode::AbsoluteX:
+        case AddressingMode::AbsoluteY:
+        case AddressingMode::Indirect: return 3;
+        default: return 2;
+    }
+}
+
+static constexpr CPU6502::addressing_fn_t addressing_fn(AddressingMode mode)
+{
+    switch (mode) {
+        case AddressingMode::Implied: return &CPU6502::imp;
+        case AddressingMode::Accumulator: return nullptr;
+        case AddressingMode::Immediate: return &CPU6502::imm;
+        case AddressingMode::ZeroPage: return &CPU6502::zp;
+        case AddressingMode::ZeroPageX: return &CPU6502::zpx;
+        case AddressingMode::ZeroPageY: return &CPU6502::zpy;
+        case AddressingMode::Absolute: return &CPU6502::abs;
+        case AddressingMode::AbsoluteX: return &CPU6502::absx;
+        case AddressingMode::AbsoluteY: return &CPU6502::absy;
+        case AddressingMode::Indirect: return &CPU6502::ind;
+        case AddressingMode::IndirectX: return &CPU6502::indx;
+        case AddressingMode::IndirectY: return &CPU6502::indy;
+        case AddressingMode::Relative: return &CPU6502::rel;
+    }
+    return nullptr;
+}
+
+// the modes where indexing can carry into the high byte of the address
+static constexpr bool is_indexed(AddressingMode mode)
+{
+    return mode == AddressingMode::AbsoluteX || mode == AddressingMode::AbsoluteY || mode == AddressingMode::IndirectY;
+}
+
+// nullptr for the modes with no operand
+static constexpr CPU6502::resolve_fn_t resolve_fn(AddressingMode mode)
+{
+    switch (mode) {
+        case AddressingMode::Implied:
+        case AddressingMode::Accumulator: return nullptr;
+        case AddressingMode::Immediate:
+        case AddressingMode::Relative: return &CPU6502::resolve_operand_byte;
+        case AddressingMode::ZeroPage: return &CPU6502::resolve_zp;
+        case AddressingMode::ZeroPageX: return &CPU6502::resolve_zpx;
+        case AddressingMode::ZeroPageY: return &CPU6502::resolve_zpy;
+        case AddressingMode::Absolute: return &CPU6502::resolve_abs;
+        case AddressingMode::AbsoluteX: return &CPU6502::resolve_absx;
+        case AddressingMode::AbsoluteY: return &CPU6502::resolve_absy;
+        case AddressingMode::Indirect: return &CPU6502::resolve_ind;
+        case AddressingMode::IndirectX: return &CPU6502::resolve_indx;
+        case AddressingMode::IndirectY: return &CPU6502::resolve_indy;
+    }
+    return nullptr;
+}
+
+// The addressing mode the 6502's decoding gives an opcode from its bit pattern, which the unofficial opcodes follow
+// as well. The ones that jam the CPU are given no operand.
+static constexpr AddressingMode unofficial_addressing_mode(uint8_t opcode)
+{
+    const uint8_t group  = opcode & 3;
+    const bool by_y      = (opcode & 0xC0) == 0x80 && group >= 2; // like STX and LDX
+    const bool alu_group = group == 1 || group == 3;
+    switch ((opcode >> 2) & 7) {
+        case 0:
+            if (alu_group) return AddressingMode::IndirectX;
+            return group == 2 && opcode < 0x80 ? AddressingMode::Implied : AddressingMode::Immediate;
+        case 1: return AddressingMode::ZeroPage;
+        case 2: return alu_group ? AddressingMode::Immediate : AddressingMode::Implied;
+        case 3: return AddressingMode::Absolute;
+        case 4:
+            if (alu_group) return AddressingMode::IndirectY;
+            return group == 0 ? AddressingMode::Relative : AddressingMode::Implied;
+        case 5: return by_y ? AddressingMode::ZeroPageY : AddressingMode::ZeroPageX;
+        case 6: return alu_group ? AddressingMode::AbsoluteY : AddressingMode::Implied;
+        default: return by_y ? AddressingMode::AbsoluteY : AddressingMode::AbsoluteX;
+    }
+}
+
+// what the unofficial NOPs take for each addressing mode, and a read for the modes they don't come in
+static constexpr uint8_t unofficial_cycles(AddressingMode mode)
+{
+    switch (mode) {
+        case AddressingMode::ZeroPage: return 3;
+        case AddressingMode::ZeroPageX:
+        case AddressingMode::ZeroPageY:
+        case AddressingMode::Absolute:
+        case AddressingMode::AbsoluteX:
+        case AddressingMode::AbsoluteY: return 4;
+        case AddressingMode::IndirectX: return 6;
+        case AddressingMode::IndirectY: return 5;
+        default: return 2;
+    }
+}
+
+// Built once at compile time and shared by every CPU6502. The unofficial opcodes aren't emulated, they run as NOPs
+// that step over the operand their addressing mode gives them.
+static constexpr std::array<CPU6502::Instruction, 256> make_instruction_table()
+{
+    std::array<CPU6502::Instruction, 256> table = {};
+    for (size_t opcode = 0; opcode < table.size(); ++opcode) {
+        const AddressingMode mode = unofficial_addressing_mode((uint8_t)opcode);
+        table[opcode]             = { "???", &CPU6502::illegal_opcode, mode, unofficial_cycles(mode) };
+    }
+
+    table[OPCODE_LDA_IMM]  = { "LDA", &CPU6502::lda, AddressingMode::Immediate, 2 };
+    table[OPCODE_LDA_ZP]   = { "LDA", &CPU6502::lda, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_LDA_ZPX]  = { "LDA", &CPU6502::lda, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_LDA_ABS]  = { "LDA", &CPU6502::lda, AddressingMode::Absolute, 4 };
+    table[OPCODE_LDA_ABSX] = { "LDA", &CPU6502::lda, AddressingMode::AbsoluteX, 4 };
+    table[OPCODE_LDA_ABSY] = { "LDA", &CPU6502::lda, AddressingMode::AbsoluteY, 4 };
+    table[OPCODE_LDA_INDX] = { "LDA", &CPU6502::lda, AddressingMode::IndirectX, 6 };
+    table[OPCODE_LDA_INDY] = { "LDA", &CPU6502::lda, AddressingMode::IndirectY, 5 };
+
+    table[OPCODE_LDX_IMM]  = { "LDX", &CPU6502::ldx, AddressingMode::Immediate, 2 };
+    table[OPCODE_LDX_ZP]   = { "LDX", &CPU6502::ldx, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_LDX_ZPY]  = { "LDX", &CPU6502::ldx, AddressingMode::ZeroPageY, 4 };
+    table[OPCODE_LDX_ABS]  = { "LDX", &CPU6502::ldx, AddressingMode::Absolute, 4 };
+    table[OPCODE_LDX_ABSY] = { "LDX", &CPU6502::ldx, AddressingMode::AbsoluteY, 4 };
+
+    table[OPCODE_LDY_IMM]  = { "LDY", &CPU6502::ldy, AddressingMode::Immediate, 2 };
+    table[OPCODE_LDY_ZP]   = { "LDY", &CPU6502::ldy, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_LDY_ZPX]  = { "LDY", &CPU6502::ldy, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_LDY_ABS]  = { "LDY", &CPU6502::ldy, AddressingMode::Absolute, 4 };
+    table[OPCODE_LDY_ABSX] = { "LDY", &CPU6502::ldy, AddressingMode::AbsoluteX, 4 };
+
+    table[OPCODE_ADC_IMM]  = { "ADC", &CPU6502::adc, AddressingMode::Immediate, 2 };
+    table[OPCODE_ADC_ZP]   = { "ADC", &CPU6502::adc, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_ADC_ZPX]  = { "ADC", &CPU6502::adc, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_ADC_ABS]  = { "ADC", &CPU6502::adc, AddressingMode::Absolute, 4 };
+    table[OPCODE_ADC_ABSX] = { "ADC", &CPU6502::adc, AddressingMode::AbsoluteX, 4 };
+    table[OPCODE_ADC_ABSY] = { "ADC", &CPU6502::adc, AddressingMode::AbsoluteY, 4 };
+    table[OPCODE_ADC_INDX] = { "ADC", &CPU6502::adc, AddressingMode::IndirectX, 6 };
+    table[OPCODE_ADC_INDY] = { "ADC", &CPU6502::adc, AddressingMode::IndirectY, 5 };
+
+    table[OPCODE_AND_IMM]  = { "AND", &CPU6502::and_op, AddressingMode::Immediate, 2 };
+    table[OPCODE_AND_ZP]   = { "AND", &CPU6502::and_op, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_AND_ZPX]  = { "AND", &CPU6502::and_op, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_AND_ABS]  = { "AND", &CPU6502::and_op, AddressingMode::Absolute, 4 };
+    table[OPCODE_AND_ABSX] = { "AND", &CPU6502::and_op, AddressingMode::AbsoluteX, 4 };
+    table[OPCODE_AND_ABSY] = { "AND", &CPU6502::and_op, AddressingMode::AbsoluteY, 4 };
+    table[OPCODE_AND_INDX] = { "AND", &CPU6502::and_op, AddressingMode::IndirectX, 6 };
+    table[OPCODE_AND_INDY] = { "AND", &CPU6502::and_op, AddressingMode::IndirectY, 5 };
+
+    table[OPCODE_ASL_ACC]  = { "ASL", &CPU6502::asl_acc, AddressingMode::Accumulator, 2 };
+    table[OPCODE_ASL_ZP]   = { "ASL", &CPU6502::asl, AddressingMode::ZeroPage, 5 };
+    table[OPCODE_ASL_ZPX]  = { "ASL", &CPU6502::asl, AddressingMode::ZeroPageX, 6 };
+    table[OPCODE_ASL_ABS]  = { "ASL", &CPU6502::asl, AddressingMode::Absolute, 6 };
+    table[OPCODE_ASL_ABSX] = { "ASL", &CPU6502::asl, AddressingMode::AbsoluteX, 7 };
+
+    table[OPCODE_BCC_REL] = { "BCC", &CPU6502::bcc, AddressingMode::Relative, 2 };
+
+    table[OPCODE_BCS_REL] = { "BCS", &CPU6502::bcs, AddressingMode::Relative, 2 };
+
+    table[OPCODE_BEQ_REL] = { "BEQ", &CPU6502::beq, AddressingMode::Relative, 2 };
+
+    table[OPCODE_BNE_REL] = { "BNE", &CPU6502::bne, AddressingMode::Relative, 2 };
+
+    table[OPCODE_BIT_ZP]  = { "BIT", &CPU6502::bit, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_BIT_ABS] = { "BIT", &CPU6502::bit, AddressingMode::Absolute, 4 };
+
+    table[OPCODE_BMI_REL] = { "BMI", &CPU6502::bmi, AddressingMode::Relative, 2 };
+
+    table[OPCODE_BPL_REL] = { "BPL", &CPU6502::bpl, AddressingMode::Relative, 2 };
+
+    table[OPCODE_BRK_IMP] = { "BRK", &CPU6502::brk, AddressingMode::Implied, 7 };
+
+    table[OPCODE_BVC_REL] = { "BVC", &CPU6502::bvc, AddressingMode::Relative, 2 };
+
+    table[OPCODE_BVS_REL] = { "BVS", &CPU6502::bvs, AddressingMode::Relative, 2 };
+
+    table[OPCODE_CLC_IMP] = { "CLC", &CPU6502::clc, AddressingMode::Implied, 2 };
+    table[OPCODE_CLD_IMP] = { "CLD", &CPU6502::cld, AddressingMode::Implied, 2 };
+    table[OPCODE_CLI_IMP] = { "CLI", &CPU6502::cli, AddressingMode::Implied, 2 };
+    table[OPCODE_CLV_IMP] = { "CLV", &CPU6502::clv, AddressingMode::Implied, 2 };
+
+    table[OPCODE_CMP_IMM]  = { "CMP", &CPU6502::cmp, AddressingMode::Immediate, 2 };
+    table[OPCODE_CMP_ZP]   = { "CMP", &CPU6502::cmp, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_CMP_ZPX]  = { "CMP", &CPU6502::cmp, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_CMP_ABS]  = { "CMP", &CPU6502::cmp, AddressingMode::Absolute, 4 };
+    table[OPCODE_CMP_ABSX] = { "CMP", &CPU6502::cmp, AddressingMode::AbsoluteX, 4 };
+    table[OPCODE_CMP_ABSY] = { "CMP", &CPU6502::cmp, AddressingMode::AbsoluteY, 4 };
+    table[OPCODE_CMP_INDX] = { "CMP", &CPU6502::cmp, AddressingMode::IndirectX, 6 };
+    table[OPCODE_CMP_INDY] = { "CMP", &CPU6502::cmp, AddressingMode::IndirectY, 5 };
+
+    table[OPCODE_CPX_IMM] = { "CPX", &CPU6502::cpx, AddressingMode::Immediate, 2 };
+    table[OPCODE_CPX_ZP]  = { "CPX", &CPU6502::cpx, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_CPX_ABS] = { "CPX", &CPU6502::cpx, AddressingMode::Absolute, 4 };
+
+    table[OPCODE_CPY_IMM] = { "CPY", &CPU6502::cpy, AddressingMode::Immediate, 2 };
+    table[OPCODE_CPY_ZP]  = { "CPY", &CPU6502::cpy, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_CPY_ABS] = { "CPY", &CPU6502::cpy, AddressingMode::Absolute, 4 };
+
+    table[OPCODE_DEC_ZP]   = { "DEC", &CPU6502::dec, AddressingMode::ZeroPage, 5 };
+    table[OPCODE_DEC_ZPX]  = { "DEC", &CPU6502::dec, AddressingMode::ZeroPageX, 6 };
+    table[OPCODE_DEC_ABS]  = { "DEC", &CPU6502::dec, AddressingMode::Absolute, 6 };
+    table[OPCODE_DEC_ABSX] = { "DEC", &CPU6502::dec, AddressingMode::AbsoluteX, 7 };
+
+    table[OPCODE_DEX_IMP] = { "DEX", &CPU6502::dex, AddressingMode::Implied, 2 };
+    table[OPCODE_DEY_IMP] = { "DEY", &CPU6502::dey, AddressingMode::Implied, 2 };
+
+    table[OPCODE_EOR_IMM]  = { "EOR", &CPU6502::eor, AddressingMode::Immediate, 2 };
+    table[OPCODE_EOR_ZP]   = { "EOR", &CPU6502::eor, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_EOR_ZPX]  = { "EOR", &CPU6502::eor, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_EOR_ABS]  = { "EOR", &CPU6502::eor, AddressingMode::Absolute, 4 };
+    table[OPCODE_EOR_ABSX] = { "EOR", &CPU6502::eor, AddressingMode::AbsoluteX, 4 };
+    table[OPCODE_EOR_ABSY] = { "EOR", &CPU6502::eor, AddressingMode::AbsoluteY, 4 };
+    table[OPCODE_EOR_INDX] = { "EOR", &CPU6502::eor, AddressingMode::IndirectX, 6 };
+    table[OPCODE_EOR_INDY] = { "EOR", &CPU6502::eor, AddressingMode::IndirectY, 5 };
+
+    table[OPCODE_INC_ZP]   = { "INC", &CPU6502::inc, AddressingMode::ZeroPage, 5 };
+    table[OPCODE_INC_ZPX]  = { "INC", &CPU6502::inc, AddressingMode::ZeroPageX, 6 };
+    table[OPCODE_INC_ABS]  = { "INC", &CPU6502::inc, AddressingMode::Absolute, 6 };
+    table[OPCODE_INC_ABSX] = { "INC", &CPU6502::inc, AddressingMode::AbsoluteX, 7 };
+    table[OPCODE_INX_IMP]  = { "INX", &CPU6502::inx, AddressingMode::Implied, 2 };
+    table[OPCODE_INY_IMP]  = { "INY", &CPU6502::iny, AddressingMode::Implied, 2 };
+
+    table[OPCODE_JMP_ABS] = { "JMP", &CPU6502::jmp, AddressingMode::Absolute, 3 };
+    table[OPCODE_JMP_IND] = { "JMP", &CPU6502::jmp, AddressingMode::Indirect, 5 };
+    table[OPCODE_JSR_ABS] = { "JSR", &CPU6502::jsr, AddressingMode::Absolute, 6 };
+
+    table[OPCODE_LSR_ACC]  = { "LSR", &CPU6502::lsr_acc, AddressingMode::Accumulator, 2 };
+    table[OPCODE_LSR_ZP]   = { "LSR", &CPU6502::lsr, AddressingMode::ZeroPage, 5 };
+    table[OPCODE_LSR_ZPX]  = { "LSR", &CPU6502::lsr, AddressingMode::ZeroPageX, 6 };
+    table[OPCODE_LSR_ABS]  = { "LSR", &CPU6502::lsr, AddressingMode::Absolute, 6 };
+    table[OPCODE_LSR_ABSX] = { "LSR", &CPU6502::lsr, AddressingMode::AbsoluteX, 7 };
+
+    table[OPCODE_NOP_IMP] = { "NOP", &CPU6502::nop, AddressingMode::Implied, 2 };
+
+    table[OPCODE_ORA_IMM]  = { "ORA", &CPU6502::ora, AddressingMode::Immediate, 2 };
+    table[OPCODE_ORA_ZP]   = { "ORA", &CPU6502::ora, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_ORA_ZPX]  = { "ORA", &CPU6502::ora, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_ORA_ABS]  = { "ORA", &CPU6502::ora, AddressingMode::Absolute, 4 };
+    table[OPCODE_ORA_ABSX] = { "ORA", &CPU6502::ora, AddressingMode::AbsoluteX, 4 };
+    table[OPCODE_ORA_ABSY] = { "ORA", &CPU6502::ora, AddressingMode::AbsoluteY, 4 };
+    table[OPCODE_ORA_INDX] = { "ORA", &CPU6502::ora, AddressingMode::IndirectX, 6 };
+    table[OPCODE_ORA_INDY] = { "ORA", &CPU6502::ora, AddressingMode::IndirectY, 5 };
+
+    table[OPCODE_PHA_IMP] = { "PHA", &CPU6502::pha, AddressingMode::Implied, 3 };
+    table[OPCODE_PHP_IMP] = { "PHP", &CPU6502::php, AddressingMode::Implied, 3 };
+    table[OPCODE_PLA_IMP] = { "PLA", &CPU6502::pla, AddressingMode::Implied, 4 };
+    table[OPCODE_PLP_IMP] = { "PLP", &CPU6502::plp, AddressingMode::Implied, 4 };
+
+    table[OPCODE_ROL_ACC]  = { "ROL", &CPU6502::rol_acc, AddressingMode::Accumulator, 2 };
+    table[OPCODE_ROL_ZP]   = { "ROL", &CPU6502::rol, AddressingMode::ZeroPage, 5 };
+    table[OPCODE_ROL_ZPX]  = { "ROL", &CPU6502::rol, AddressingMode::ZeroPageX, 6 };
+    table[OPCODE_ROL_ABS]  = { "ROL", &CPU6502::rol, AddressingMode::Absolute, 6 };
+    table[OPCODE_ROL_ABSX] = { "ROL", &CPU6502::rol, AddressingMode::AbsoluteX, 7 };
+
+    table[OPCODE_ROR_ACC]  = { "ROR", &CPU6502::ror_acc, AddressingMode::Accumulator, 2 };
+    table[OPCODE_ROR_ZP]   = { "ROR", &CPU6502::ror, AddressingMode::ZeroPage, 5 };
+    table[OPCODE_ROR_ZPX]  = { "ROR", &CPU6502::ror, AddressingMode::ZeroPageX, 6 };
+    table[OPCODE_ROR_ABS]  = { "ROR", &CPU6502::ror, AddressingMode::Absolute, 6 };
+    table[OPCODE_ROR_ABSX] = { "ROR", &CPU6502::ror, AddressingMode::AbsoluteX, 7 };
+
+    table[OPCODE_RTI_IMP] = { "RTI", &CPU6502::rti, AddressingMode::Implied, 6 };
+    table[OPCODE_RTS_IMP] = { "RTS", &CPU6502::rts, AddressingMode::Implied, 6 };
+
+    table[OPCODE_SBC_IMM]  = { "SBC", &CPU6502::sbc, AddressingMode::Immediate, 2 };
+    table[OPCODE_SBC_ZP]   = { "SBC", &CPU6502::sbc, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_SBC_ZPX]  = { "SBC", &CPU6502::sbc, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_SBC_ABS]  = { "SBC", &CPU6502::sbc, AddressingMode::Absolute, 4 };
+    table[OPCODE_SBC_ABSX] = { "SBC", &CPU6502::sbc, AddressingMode::AbsoluteX, 4 };
+    table[OPCODE_SBC_ABSY] = { "SBC", &CPU6502::sbc, AddressingMode::AbsoluteY, 4 };
+    table[OPCODE_SBC_INDX] = { "SBC", &CPU6502::sbc, AddressingMode::IndirectX, 6 };
+    table[OPCODE_SBC_INDY] = { "SBC", &CPU6502::sbc, AddressingMode::IndirectY, 5 };
+
+    table[OPCODE_SEC_IMP] = { "SEC", &CPU6502::sec, AddressingMode::Implied, 2 };
+    table[OPCODE_SED_IMP] = { "SED", &CPU6502::sed, AddressingMode::Implied, 2 };
+    table[OPCODE_SEI_IMP] = { "SEI", &CPU6502::sei, AddressingMode::Implied, 2 };
+
+    table[OPCODE_STA_ZP]   = { "STA", &CPU6502::sta, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_STA_ZPX]  = { "STA", &CPU6502::sta, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_STA_ABS]  = { "STA", &CPU6502::sta, AddressingMode::Absolute, 4 };
+    table[OPCODE_STA_ABSX] = { "STA", &CPU6502::sta, AddressingMode::AbsoluteX, 5 };
+    table[OPCODE_STA_ABSY] = { "STA", &CPU6502::sta, AddressingMode::AbsoluteY, 5 };
+    table[OPCODE_STA_INDX] = { "STA", &CPU6502::sta, AddressingMode::IndirectX, 6 };
+    table[OPCODE_STA_INDY] = { "STA", &CPU6502::sta, AddressingMode::IndirectY, 6 };
+    table[OPCODE_STX_ZP]   = { "STX", &CPU6502::stx, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_STX_ZPY]  = { "STX", &CPU6502::stx, AddressingMode::ZeroPageY, 4 };
+    table[OPCODE_STX_ABS]  = { "STX", &CPU6502::stx, AddressingMode::Absolute, 4 };
+    table[OPCODE_STY_ZP]   = { "STY", &CPU6502::sty, AddressingMode::ZeroPage, 3 };
+    table[OPCODE_STY_ZPX]  = { "STY", &CPU6502::sty, AddressingMode::ZeroPageX, 4 };
+    table[OPCODE_STY_ABS]  = { "STY", &CPU6502::sty, AddressingMode::Absolute, 4 };
+
+    table[OPCODE_TAX_IMP] = { "TAX", &CPU6502::tax, AddressingMode::Implied, 2 };
+    table[OPCODE_TAY_IMP] = { "TAY", &CPU6502::tay, AddressingMode::Implied, 2 };
+    table[OPCODE_TSX_IMP] = { "TSX", &CPU6502::tsx, AddressingMode::Implied, 2 };
+    table[OPCODE_TXA_IMP] = { "TXA", &CPU6502::txa, AddressingMode::Implied, 2 };
+    table[OPCODE_TXS_IMP] = { "TXS", &CPU6502::txs, AddressingMode::Implied, 2 };
+    table[OPCODE_TYA_IMP] = { "TYA", &CPU6502::tya, AddressingMode::Implied, 2 };
+
+    // Everything else about an instruction follows from its addressing mode. The table is built by comparing enums
+    // and names rather than member function pointers, which aren't constant expressions everywhere (GCC's
+    // -fsanitize=undefined instruments the comparison).
+    for (CPU6502::Instruction& instruction : table) {
+        instruction.bytes         = instruction_bytes(instruction.mode);
+        instruction.addressing_fn = addressing_fn(instruction.mode);
+        instruction.resolve_fn    = resolve_fn(instruction.mode);
+
+        // writes and read-modify-writes always take the extra cycle so it's already in their count
+        constexpr std::array<std::string_view, 9> only_reads = { "LDA", "LDX", "LDY", "AND", "ORA",
+                                                                 "EOR", "ADC", "SBC", "CMP" };
+        const bool reads = std::find(only_reads.begin(), only_reads.end(), instruction.name) != only_reads.end();
+        if (reads) instruction.page_cross_penalty = is_indexed(instruction.mode);
+    }
+
+    return table;
+}
+
+static constexpr std::array<CPU6502::Instruction, 256> instruction_table = make_instruction_table();
+
+const CPU6502::Instruction& CPU6502::instruction(uint8_t opcode)
+{
+    return instruction_table[opcode];
 }
 
 CPU6502::CPU6502()
@@ -73,226 +387,405 @@ CPU6502::CPU6502()
     registers.s = 0xFD;
     registers.p.set_int_disable_flag();
     registers.p.set_bflag();
-
-    m_InstructionMap[OPCODE_LDA_IMM]  = { "LDA", &CPU6502::lda, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_LDA_ZP]   = { "LDA", &CPU6502::lda, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_LDA_ZPX]  = { "LDA", &CPU6502::lda, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_LDA_ABS]  = { "LDA", &CPU6502::lda, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_LDA_ABSX] = { "LDA", &CPU6502::lda, &CPU6502::absx, 4 };
-    m_InstructionMap[OPCODE_LDA_ABSY] = { "LDA", &CPU6502::lda, &CPU6502::absy, 4 };
-    m_InstructionMap[OPCODE_LDA_INDX] = { "LDA", &CPU6502::lda, &CPU6502::indx, 6 };
-    m_InstructionMap[OPCODE_LDA_INDY] = { "LDA", &CPU6502::lda, &CPU6502::indy, 5 };
-
-    m_InstructionMap[OPCODE_LDX_IMM]  = { "LDX", &CPU6502::ldx, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_LDX_ZP]   = { "LDX", &CPU6502::ldx, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_LDX_ZPY]  = { "LDX", &CPU6502::ldx, &CPU6502::zpy, 4 };
-    m_InstructionMap[OPCODE_LDX_ABS]  = { "LDX", &CPU6502::ldx, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_LDX_ABSY] = { "LDX", &CPU6502::ldx, &CPU6502::absy, 4 };
-
-    m_InstructionMap[OPCODE_LDY_IMM]  = { "LDY", &CPU6502::ldy, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_LDY_ZP]   = { "LDY", &CPU6502::ldy, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_LDY_ZPX]  = { "LDY", &CPU6502::ldy, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_LDY_ABS]  = { "LDY", &CPU6502::ldy, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_LDY_ABSX] = { "LDY", &CPU6502::ldy, &CPU6502::absx, 4 };
-
-    m_InstructionMap[OPCODE_ADC_IMM]  = { "ADC", &CPU6502::adc, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_ADC_ZP]   = { "ADC", &CPU6502::adc, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_ADC_ZPX]  = { "ADC", &CPU6502::adc, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_ADC_ABS]  = { "ADC", &CPU6502::adc, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_ADC_ABSX] = { "ADC", &CPU6502::adc, &CPU6502::absx, 4 };
-    m_InstructionMap[OPCODE_ADC_ABSY] = { "ADC", &CPU6502::adc, &CPU6502::absy, 4 };
-    m_InstructionMap[OPCODE_ADC_INDX] = { "ADC", &CPU6502::adc, &CPU6502::indx, 6 };
-    m_InstructionMap[OPCODE_ADC_INDY] = { "ADC", &CPU6502::adc, &CPU6502::indy, 5 };
-
-    m_InstructionMap[OPCODE_AND_IMM]  = { "AND", &CPU6502::and_op, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_AND_ZP]   = { "AND", &CPU6502::and_op, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_AND_ZPX]  = { "AND", &CPU6502::and_op, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_AND_ABS]  = { "AND", &CPU6502::and_op, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_AND_ABSX] = { "AND", &CPU6502::and_op, &CPU6502::absx, 4 };
-    m_InstructionMap[OPCODE_AND_ABSY] = { "AND", &CPU6502::and_op, &CPU6502::absy, 4 };
-    m_InstructionMap[OPCODE_AND_INDX] = { "AND", &CPU6502::and_op, &CPU6502::indx, 6 };
-    m_InstructionMap[OPCODE_AND_INDY] = { "AND", &CPU6502::and_op, &CPU6502::indy, 5 };
-
-    m_InstructionMap[OPCODE_ASL_ACC]  = { "ASL", &CPU6502::asl_acc, nullptr, 2 };
-    m_InstructionMap[OPCODE_ASL_ZP]   = { "ASL", &CPU6502::asl, &CPU6502::zp, 5 };
-    m_InstructionMap[OPCODE_ASL_ZPX]  = { "ASL", &CPU6502::asl, &CPU6502::zpx, 6 };
-    m_InstructionMap[OPCODE_ASL_ABS]  = { "ASL", &CPU6502::asl, &CPU6502::abs, 6 };
-    m_InstructionMap[OPCODE_ASL_ABSX] = { "ASL", &CPU6502::asl, &CPU6502::absx, 7 };
-
-    m_InstructionMap[OPCODE_BCC_REL] = { "BCC", &CPU6502::bcc, &CPU6502::rel, 2 };
-
-    m_InstructionMap[OPCODE_BCS_REL] = { "BCS", &CPU6502::bcs, &CPU6502::rel, 2 };
-
-    m_InstructionMap[OPCODE_BEQ_REL] = { "BEQ", &CPU6502::beq, &CPU6502::rel, 2 };
-
-    m_InstructionMap[OPCODE_BNE_REL] = { "BNE", &CPU6502::bne, &CPU6502::rel, 2 };
-
-    m_InstructionMap[OPCODE_BIT_ZP]  = { "BIT", &CPU6502::bit, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_BIT_ABS] = { "BIT", &CPU6502::bit, &CPU6502::abs, 4 };
-
-    m_InstructionMap[OPCODE_BMI_REL] = { "BMI", &CPU6502::bmi, &CPU6502::rel, 2 };
-
-    m_InstructionMap[OPCODE_BPL_REL] = { "BPL", &CPU6502::bpl, &CPU6502::rel, 2 };
-
-    m_InstructionMap[OPCODE_BRK_IMP] = { "BRK", &CPU6502::brk, &CPU6502::imp, 7 };
-
-    m_InstructionMap[OPCODE_BVC_REL] = { "BVC", &CPU6502::bvc, &CPU6502::rel, 2 };
-
-    m_InstructionMap[OPCODE_BVS_REL] = { "BVS", &CPU6502::bvs, &CPU6502::rel, 2 };
-
-    m_InstructionMap[OPCODE_CLC_IMP] = { "CLC", &CPU6502::clc, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_CLD_IMP] = { "CLD", &CPU6502::cld, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_CLI_IMP] = { "CLI", &CPU6502::cli, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_CLV_IMP] = { "CLV", &CPU6502::clv, &CPU6502::imp, 2 };
-
-    m_InstructionMap[OPCODE_CMP_IMM]  = { "CMP", &CPU6502::cmp, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_CMP_ZP]   = { "CMP", &CPU6502::cmp, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_CMP_ZPX]  = { "CMP", &CPU6502::cmp, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_CMP_ABS]  = { "CMP", &CPU6502::cmp, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_CMP_ABSX] = { "CMP", &CPU6502::cmp, &CPU6502::absx, 4 };
-    m_InstructionMap[OPCODE_CMP_ABSY] = { "CMP", &CPU6502::cmp, &CPU6502::absy, 4 };
-    m_InstructionMap[OPCODE_CMP_INDX] = { "CMP", &CPU6502::cmp, &CPU6502::indx, 6 };
-    m_InstructionMap[OPCODE_CMP_INDY] = { "CMP", &CPU6502::cmp, &CPU6502::indy, 5 };
-
-    m_InstructionMap[OPCODE_CPX_IMM] = { "CPX", &CPU6502::cpx, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_CPX_ZP]  = { "CPX", &CPU6502::cpx, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_CPX_ABS] = { "CPX", &CPU6502::cpx, &CPU6502::abs, 4 };
-
-    m_InstructionMap[OPCODE_CPY_IMM] = { "CPY", &CPU6502::cpy, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_CPY_ZP]  = { "CPY", &CPU6502::cpy, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_CPY_ABS] = { "CPY", &CPU6502::cpy, &CPU6502::abs, 4 };
-
-    m_InstructionMap[OPCODE_DEC_ZP]   = { "DEC", &CPU6502::dec, &CPU6502::zp, 5 };
-    m_InstructionMap[OPCODE_DEC_ZPX]  = { "DEC", &CPU6502::dec, &CPU6502::zpx, 6 };
-    m_InstructionMap[OPCODE_DEC_ABS]  = { "DEC", &CPU6502::dec, &CPU6502::abs, 6 };
-    m_InstructionMap[OPCODE_DEC_ABSX] = { "DEC", &CPU6502::dec, &CPU6502::absx, 7 };
-
-    m_InstructionMap[OPCODE_DEX_IMP] = { "DEX", &CPU6502::dex, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_DEY_IMP] = { "DEY", &CPU6502::dey, &CPU6502::imp, 2 };
-
-    m_InstructionMap[OPCODE_EOR_IMM]  = { "EOR", &CPU6502::eor, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_EOR_ZP]   = { "EOR", &CPU6502::eor, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_EOR_ZPX]  = { "EOR", &CPU6502::eor, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_EOR_ABS]  = { "EOR", &CPU6502::eor, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_EOR_ABSX] = { "EOR", &CPU6502::eor, &CPU6502::indx, 4 };
-    m_InstructionMap[OPCODE_EOR_ABSY] = { "EOR", &CPU6502::eor, &CPU6502::absy, 4 };
-    m_InstructionMap[OPCODE_EOR_INDX] = { "EOR", &CPU6502::eor, &CPU6502::indx, 6 };
-    m_InstructionMap[OPCODE_EOR_INDY] = { "EOR", &CPU6502::eor, &CPU6502::indy, 5 };
-
-    m_InstructionMap[OPCODE_INC_ZP]   = { "INC", &CPU6502::inc, &CPU6502::zp, 5 };
-    m_InstructionMap[OPCODE_INC_ZPX]  = { "INC", &CPU6502::inc, &CPU6502::zpx, 6 };
-    m_InstructionMap[OPCODE_INC_ABS]  = { "INC", &CPU6502::inc, &CPU6502::abs, 6 };
-    m_InstructionMap[OPCODE_INC_ABSX] = { "INC", &CPU6502::inc, &CPU6502::absx, 7 };
-    m_InstructionMap[OPCODE_INX_IMP]  = { "INX", &CPU6502::inx, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_INY_IMP]  = { "INY", &CPU6502::iny, &CPU6502::imp, 2 };
-
-    m_InstructionMap[OPCODE_JMP_ABS] = { "JMP", &CPU6502::jmp, &CPU6502::abs, 3 };
-    m_InstructionMap[OPCODE_JMP_IND] = { "JMP", &CPU6502::jmp, &CPU6502::ind, 5 };
-    m_InstructionMap[OPCODE_JSR_ABS] = { "JSR", &CPU6502::jsr, &CPU6502::abs, 6 };
-
-    m_InstructionMap[OPCODE_LSR_ACC]  = { "LSR", &CPU6502::lsr_acc, nullptr, 2 };
-    m_InstructionMap[OPCODE_LSR_ZP]   = { "LSR", &CPU6502::lsr, &CPU6502::zp, 5 };
-    m_InstructionMap[OPCODE_LSR_ZPX]  = { "LSR", &CPU6502::lsr, &CPU6502::zpx, 6 };
-    m_InstructionMap[OPCODE_LSR_ABS]  = { "LSR", &CPU6502::lsr, &CPU6502::abs, 6 };
-    m_InstructionMap[OPCODE_LSR_ABSX] = { "LSR", &CPU6502::lsr, &CPU6502::absx, 7 };
-
-    m_InstructionMap[OPCODE_NOP_IMP] = { "NOP", &CPU6502::nop, &CPU6502::imp, 2 };
-
-    m_InstructionMap[OPCODE_ORA_IMM]  = { "ORA", &CPU6502::ora, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_ORA_ZP]   = { "ORA", &CPU6502::ora, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_ORA_ZPX]  = { "ORA", &CPU6502::ora, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_ORA_ABS]  = { "ORA", &CPU6502::ora, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_ORA_ABSX] = { "ORA", &CPU6502::ora, &CPU6502::absx, 4 };
-    m_InstructionMap[OPCODE_ORA_ABSY] = { "ORA", &CPU6502::ora, &CPU6502::absy, 4 };
-    m_InstructionMap[OPCODE_ORA_INDX] = { "ORA", &CPU6502::ora, &CPU6502::indx, 6 };
-    m_InstructionMap[OPCODE_ORA_INDY] = { "ORA", &CPU6502::ora, &CPU6502::indy, 5 };
-
-    m_InstructionMap[OPCODE_PHA_IMP] = { "PHA", &CPU6502::pha, &CPU6502::imp, 3 };
-    m_InstructionMap[OPCODE_PHP_IMP] = { "PHP", &CPU6502::php, &CPU6502::imp, 3 };
-    m_InstructionMap[OPCODE_PLA_IMP] = { "PLA", &CPU6502::pla, &CPU6502::imp, 4 };
-    m_InstructionMap[OPCODE_PLP_IMP] = { "PLP", &CPU6502::plp, &CPU6502::imp, 4 };
-
-    m_InstructionMap[OPCODE_ROL_ACC]  = { "ROL", &CPU6502::rol_acc, nullptr, 2 };
-    m_InstructionMap[OPCODE_ROL_ZP]   = { "ROL", &CPU6502::rol, &CPU6502::zp, 5 };
-    m_InstructionMap[OPCODE_ROL_ZPX]  = { "ROL", &CPU6502::rol, &CPU6502::zpx, 6 };
-    m_InstructionMap[OPCODE_ROL_ABS]  = { "ROL", &CPU6502::rol, &CPU6502::abs, 6 };
-    m_InstructionMap[OPCODE_ROL_ABSX] = { "ROL", &CPU6502::rol, &CPU6502::absx, 7 };
-
-    m_InstructionMap[OPCODE_ROR_ACC]  = { "ROR", &CPU6502::ror_acc, nullptr, 2 };
-    m_InstructionMap[OPCODE_ROR_ZP]   = { "ROR", &CPU6502::ror, &CPU6502::zp, 5 };
-    m_InstructionMap[OPCODE_ROR_ZPX]  = { "ROR", &CPU6502::ror, &CPU6502::zpx, 6 };
-    m_InstructionMap[OPCODE_ROR_ABS]  = { "ROR", &CPU6502::ror, &CPU6502::abs, 6 };
-    m_InstructionMap[OPCODE_ROR_ABSX] = { "ROR", &CPU6502::ror, &CPU6502::absx, 7 };
-
-    m_InstructionMap[OPCODE_RTI_IMP] = { "RTI", &CPU6502::rti, &CPU6502::imp, 6 };
-    m_InstructionMap[OPCODE_RTS_IMP] = { "RTS", &CPU6502::rts, &CPU6502::imp, 6 };
-
-    m_InstructionMap[OPCODE_SBC_IMM]  = { "SBC", &CPU6502::sbc, &CPU6502::imm, 2 };
-    m_InstructionMap[OPCODE_SBC_ZP]   = { "SBC", &CPU6502::sbc, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_SBC_ZPX]  = { "SBC", &CPU6502::sbc, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_SBC_ABS]  = { "SBC", &CPU6502::sbc, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_SBC_ABSX] = { "SBC", &CPU6502::sbc, &CPU6502::absx, 4 };
-    m_InstructionMap[OPCODE_SBC_ABSY] = { "SBC", &CPU6502::sbc, &CPU6502::absy, 4 };
-    m_InstructionMap[OPCODE_SBC_INDX] = { "SBC", &CPU6502::sbc, &CPU6502::indx, 6 };
-    m_InstructionMap[OPCODE_SBC_INDY] = { "SBC", &CPU6502::sbc, &CPU6502::indy, 5 };
-
-    m_InstructionMap[OPCODE_SEC_IMP] = { "SEC", &CPU6502::sec, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_SED_IMP] = { "SED", &CPU6502::sed, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_SEI_IMP] = { "SEI", &CPU6502::sei, &CPU6502::imp, 2 };
-
-    m_InstructionMap[OPCODE_STA_ZP]   = { "STA", &CPU6502::sta, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_STA_ZPX]  = { "STA", &CPU6502::sta, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_STA_ABS]  = { "STA", &CPU6502::sta, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_STA_ABSX] = { "STA", &CPU6502::sta, &CPU6502::absx, 5 };
-    m_InstructionMap[OPCODE_STA_ABSY] = { "STA", &CPU6502::sta, &CPU6502::absy, 5 };
-    m_InstructionMap[OPCODE_STA_INDX] = { "STA", &CPU6502::sta, &CPU6502::indx, 6 };
-    m_InstructionMap[OPCODE_STA_INDY] = { "STA", &CPU6502::sta, &CPU6502::indy, 6 };
-    m_InstructionMap[OPCODE_STX_ZP]   = { "STX", &CPU6502::stx, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_STX_ZPY]  = { "STX", &CPU6502::stx, &CPU6502::zpy, 4 };
-    m_InstructionMap[OPCODE_STX_ABS]  = { "STX", &CPU6502::stx, &CPU6502::abs, 4 };
-    m_InstructionMap[OPCODE_STY_ZP]   = { "STY", &CPU6502::sty, &CPU6502::zp, 3 };
-    m_InstructionMap[OPCODE_STY_ZPX]  = { "STY", &CPU6502::sty, &CPU6502::zpx, 4 };
-    m_InstructionMap[OPCODE_STY_ABS]  = { "STY", &CPU6502::sty, &CPU6502::abs, 4 };
-
-    m_InstructionMap[OPCODE_TAX_IMP] = { "TAX", &CPU6502::tax, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_TAY_IMP] = { "TAY", &CPU6502::tay, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_TSX_IMP] = { "TSX", &CPU6502::tsx, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_TXA_IMP] = { "TXA", &CPU6502::txa, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_TXS_IMP] = { "TXS", &CPU6502::txs, &CPU6502::imp, 2 };
-    m_InstructionMap[OPCODE_TYA_IMP] = { "TYA", &CPU6502::tya, &CPU6502::imp, 2 };
 }
 
 void CPU6502::next_cycle()
 {
-    if (cycles_remaining > 0) {
-        cycles_remaining--;
-        cycle_count++;
-        return;
+    if (cycles_remaining == 0) {
+        cycles_remaining = process_instruction();
     }
 
-    cycles_remaining = process_instruction() - 1;
+    cycles_remaining--;
     cycle_count++;
+    scheduler.run_due_events();
+    if (cycles_remaining == 0 && cycle_count >= interrupt_cycle) {
+        cycles_remaining = take_interrupt();
+    }
 }
 
-uint8_t CPU6502::process_instruction()
+void CPU6502::run_until(uint64_t target_cycle)
+{
+    if (cycle_count >= target_cycle) return;
+
+    // anything could have been written since the CPU last ran, so an idle loop has to be seen going round again
+    last_idle_loop_visit.valid = false;
+
+    // finish off any instruction that was started through next_cycle()
+    cycle_count += cycles_remaining;
+    cycles_remaining = 0;
+
+    // tracing goes an instruction at a time so every instruction can be recorded, profiling records them as it runs
+    // each block instead
+    const bool single_step = verbose_log || tracer || pair_histogram || !use_block_cache;
+
+    if (!single_step && !profiler && use_recompiler && !recompiler) {
+        recompiler = Recompiler::create(*this);
+        if (!recompiler) use_recompiler = false;
+    }
+
+    // events are run once the CPU has reached them, which can be part way through an instruction as instructions
+    // can't be split
+    scheduler.run_due_events();
+    if (cycle_count >= interrupt_cycle) cycle_count += take_interrupt();
+    while (cycle_count < target_cycle) {
+        stop_cycle = std::min({ target_cycle, scheduler.next_event_cycle(), interrupt_cycle });
+        if (single_step) [[unlikely]] {
+            while (cycle_count < stop_cycle) {
+                cycle_count += profiler ? process_profiled_instruction() : process_instruction();
+            }
+        } else if (profiler) [[unlikely]] {
+            run_blocks<true>();
+        } else if (static_program && use_static_program) {
+            run_static_program();
+        } else if (use_recompiler) {
+            run_native_blocks();
+        } else {
+            run_blocks<false>();
+        }
+        scheduler.run_due_events();
+        if (cycle_count >= interrupt_cycle) cycle_count += take_interrupt();
+    }
+}
+
+template <bool profiled>
+void CPU6502::run_blocks()
+{
+    while (cycle_count < stop_cycle) {
+        const std::span<const DecodedInstruction> block = block_cache.block_at(registers.pc);
+        if (block.empty()) [[unlikely]] {
+            cycle_count += profiled ? process_profiled_instruction() : process_instruction();
+            continue;
+        }
+        run_decoded_block<profiled>(block);
+    }
+}
+
+void CPU6502::run_native_blocks()
+{
+    while (cycle_count < stop_cycle) {
+        const std::span<const DecodedInstruction> block = block_cache.block_at(registers.pc);
+        if (block.empty()) [[unlikely]] {
+            cycle_count += process_instruction();
+            continue;
+        }
+
+        NativeBlock& native = block_cache.native_block(registers.pc);
+        if (!native.entry && ++native.hits == Recompiler::hot_block_runs) {
+            native = recompiler->compile(block, registers.pc);
+        }
+
+        // translated code runs the whole block without checking the cycle count, so the interpreter finishes off
+        // anything that would take it past stop_cycle
+        if (native.entry && stop_cycle - cycle_count > native.max_cycles) {
+            native.entry(*this);
+        } else {
+            run_decoded_block<false>(block);
+        }
+    }
+}
+
+void CPU6502::run_static_program()
+{
+    while (cycle_count < stop_cycle) {
+        if (static_program->run(*this)) continue;
+
+        // pc isn't code that was found in the ROM, most likely it's in RAM
+        const std::span<const DecodedInstruction> block = block_cache.block_at(registers.pc);
+        if (block.empty()) [[unlikely]] {
+            cycle_count += process_instruction();
+            continue;
+        }
+        run_decoded_block<false>(block);
+    }
+}
+
+int16_t CPU6502::prg_bank_at(uint16_t pc) const
+{
+    return mapper && pc >= 0x8000 ? (int16_t)mapper->prg_bank_8k_at(pc) : Profiler::not_prg;
+}
+
+// Returns the cycles taken like process_instruction
+uint8_t CPU6502::process_profiled_instruction()
+{
+    // looked at first so code that rewrites itself is counted as what actually ran
+    const uint16_t pc    = registers.pc;
+    const uint8_t opcode = memory.peek_byte(pc);
+    const uint8_t bytes  = instruction_table[opcode].bytes;
+    const uint16_t low   = bytes > 1 ? memory.peek_byte(pc + 1) : 0;
+    const uint16_t high  = bytes > 2 ? memory.peek_byte(pc + 2) : 0;
+    const uint8_t cycles = process_instruction();
+    profiler->record(pc, opcode, (uint16_t)(low | high << 8), prg_bank_at(pc), cycles);
+    return cycles;
+}
+
+template <bool profiled>
+void CPU6502::run_decoded_block(std::span<const DecodedInstruction> block)
+{
+    if constexpr (profiled) {
+        // one at a time through the plain handlers, not a fused pair's or an idle loop's, so each instruction is
+        // recorded and none are skipped over. A block never crosses a page, so it's all in the one bank
+        const int16_t bank = prg_bank_at(registers.pc);
+        for (const DecodedInstruction& decoded : block) {
+            const uint16_t pc = registers.pc;
+            registers.pc += decoded.bytes;
+            const uint8_t cycles = decoded_handler(decoded.opcode)(*this, decoded.operand);
+            cycle_count += cycles;
+            profiler->record(pc, decoded.opcode, (uint16_t)decoded.operand, bank, cycles);
+            if (cycle_count >= stop_cycle) [[unlikely]] break;
+        }
+    } else {
+        for (size_t i = 0; i < block.size(); i += block[i].length) {
+            const DecodedInstruction& decoded = block[i];
+            registers.pc += decoded.bytes;
+            cycle_count += decoded.handler(*this, decoded.operand);
+            if (cycle_count >= stop_cycle) [[unlikely]] break;
+        }
+    }
+}
+
+void CPU6502::run_for_cycles(uint64_t cycles)
+{
+    run_until(cycle_count + cycles);
+}
+
+// Runs until the PPU has finished drawing the next frame, which it has at the start of vblank
+void CPU6502::run_frame()
+{
+    ppu.catch_up();
+    run_until(ppu.next_vblank_cycle());
+}
+
+// page_crossed is only looked at by the opcodes it applies to, and is added rather than tested
+template <uint8_t opcode>
+static uint8_t instruction_cycles(const CPU6502& cpu)
+{
+    constexpr const CPU6502::Instruction& instruction = instruction_table[opcode];
+    if constexpr (instruction.page_cross_penalty) {
+        return (uint8_t)(instruction.cycles + cpu.page_crossed);
+    }
+    return instruction.cycles;
+}
+
+// Stamps out one handler per opcode with the addressing mode and operation called directly, so the compiler can
+// inline both rather than going through the member function pointers in the table
+template <uint8_t opcode>
+uint8_t CPU6502::execute_opcode()
 {
-    const uint8_t opcode  = memory.read_byte(registers.pc++);
-    const auto handler_it = m_InstructionMap.find(opcode);
-    if (handler_it == m_InstructionMap.end()) {
-        NOT_IMPLEMENTED();
+    constexpr const Instruction& instruction = instruction_table[opcode];
+    uint16_t data_addr                       = 0;
+    if constexpr (instruction.mode != AddressingMode::Accumulator) {
+        data_addr = (this->*instruction.addressing_fn)();
     }
+    if constexpr (can_reach_io(instruction.mode)) io_cycle = cycle_count + instruction_cycles<opcode>(*this) - 1;
+    return (this->*instruction.operation_fn)(data_addr) + instruction_cycles<opcode>(*this);
+}
 
-    if (verbose_log) {
-        fmt::print(stderr, "{:04X} {:4} {:02X}  ", registers.pc - 1, handler_it->second.name, opcode);
-        log_cpu_state(*this);
+// The same for an instruction from the block cache, pc has already been stepped over it
+template <uint8_t opcode>
+uint8_t CPU6502::execute_decoded([[maybe_unused]] uint16_t operand)
+{
+    constexpr const Instruction& instruction = instruction_table[opcode];
+    uint16_t data_addr                       = 0;
+    if constexpr (instruction_bytes(instruction.mode) > 1) {
+        data_addr = (this->*instruction.resolve_fn)(operand);
     }
+    if constexpr (can_reach_io(instruction.mode)) io_cycle = cycle_count + instruction_cycles<opcode>(*this) - 1;
+    return (this->*instruction.operation_fn)(data_addr) + instruction_cycles<opcode>(*this);
+}
+
+#define OPCODE_CASE(opcode)                                                                                            \
+    case opcode: return execute_opcode<opcode>();
+#define OPCODE_CASE_ROW(hi)                                                                                            \
+    OPCODE_CASE(hi##0)                                                                                                 \
+    OPCODE_CASE(hi##1)                                                                                                 \
+    OPCODE_CASE(hi##2)                                                                                                 \
+    OPCODE_CASE(hi##3)                                                                                                 \
+    OPCODE_CASE(hi##4)                                                                                                 \
+    OPCODE_CASE(hi##5)                                                                                                 \
+    OPCODE_CASE(hi##6)                                                                                                 \
+    OPCODE_CASE(hi##7)                                                                                                 \
+    OPCODE_CASE(hi##8)                                                                                                 \
+    OPCODE_CASE(hi##9)                                                                                                 \
+    OPCODE_CASE(hi##A)                                                                                                 \
+    OPCODE_CASE(hi##B)                                                                                                 \
+    OPCODE_CASE(hi##C)                                                                                                 \
+    OPCODE_CASE(hi##D)                                                                                                 \
+    OPCODE_CASE(hi##E)                                                                                                 \
+    OPCODE_CASE(hi##F)
+
+uint8_t CPU6502::dispatch(uint8_t opcode)
+{
+    switch (opcode) {
+        OPCODE_CASE_ROW(0x0)
+        OPCODE_CASE_ROW(0x1)
+        OPCODE_CASE_ROW(0x2)
+        OPCODE_CASE_ROW(0x3)
+        OPCODE_CASE_ROW(0x4)
+        OPCODE_CASE_ROW(0x5)
+        OPCODE_CASE_ROW(0x6)
+        OPCODE_CASE_ROW(0x7)
+        OPCODE_CASE_ROW(0x8)
+        OPCODE_CASE_ROW(0x9)
+        OPCODE_CASE_ROW(0xA)
+        OPCODE_CASE_ROW(0xB)
+        OPCODE_CASE_ROW(0xC)
+        OPCODE_CASE_ROW(0xD)
+        OPCODE_CASE_ROW(0xE)
+        OPCODE_CASE_ROW(0xF)
+    }
+    return 0;
+}
+
+#undef OPCODE_CASE_ROW
+#undef OPCODE_CASE
+
+// The block cache stores one of these with each instruction, calling it directly is cheaper than going back through
+// the switch in dispatch
+template <uint8_t opcode>
+static uint8_t run_decoded(CPU6502& cpu, uint32_t operand)
+{
+    return cpu.execute_decoded<opcode>((uint16_t)operand);
+}
+
+template <size_t... opcodes>
+static constexpr auto make_decoded_handlers(std::index_sequence<opcodes...>)
+{
+    return std::array<decltype(DecodedInstruction::handler), 256>{ &run_decoded<opcodes>... };
+}
+
+auto CPU6502::decoded_handler(uint8_t opcode) -> decltype(DecodedInstruction::handler)
+{
+    static constexpr auto handlers = make_decoded_handlers(std::make_index_sequence<256>());
+    return handlers[opcode];
+}
+
+// The handler BlockCache gives the branch at the end of an idle loop instead
+template <uint8_t opcode>
+static uint8_t run_idle_loop_branch(CPU6502& cpu, uint32_t operand)
+{
+    const uint16_t next_pc = cpu.registers.pc;
+    const uint8_t cycles   = cpu.execute_decoded<opcode>((uint16_t)operand);
+    if (cpu.skip_idle_loops) cpu.fast_forward_idle_loop(next_pc, cycles);
+    return cycles;
+}
+
+template <size_t... opcodes>
+static constexpr auto make_idle_loop_handlers(std::index_sequence<opcodes...>)
+{
+    return std::array<decltype(DecodedInstruction::handler), 256>{ &run_idle_loop_branch<opcodes>... };
+}
+
+auto CPU6502::idle_loop_handler(uint8_t opcode) -> decltype(DecodedInstruction::handler)
+{
+    static constexpr auto handlers = make_idle_loop_handlers(std::make_index_sequence<256>());
+    return handlers[opcode];
+}
 
-    auto op                  = handler_it->second.operation_fn;
-    auto addr                = handler_it->second.addressing_fn;
-    const uint16_t data_addr = addr ? (this->*addr)() : 0;
-    uint8_t cycles_required  = (this->*op)(data_addr) + handler_it->second.cycles;
-    page_crossed             = false;
-    return cycles_required;
+// The handler BlockCache gives the first of a pair of instructions from fused_pairs.h, which runs both in one go.
+// Everything about the pair is the same as running them one after the other, cycle_count included, down to stopping in
+// between when the first takes the CPU to stop_cycle (or lowers it, by requesting an interrupt or writing to code).
+template <uint8_t first, uint8_t second>
+static uint8_t run_fused_pair(CPU6502& cpu, uint32_t operands)
+{
+    cpu.cycle_count += cpu.execute_decoded<first>((uint16_t)operands);
+    if (cpu.cycle_count >= cpu.stop_cycle) [[unlikely]] return 0;
+
+    cpu.registers.pc += instruction_table[second].bytes;
+    return cpu.execute_decoded<second>((uint16_t)(operands >> 16));
+}
+
+template <size_t... indices>
+static constexpr auto make_fused_pair_handlers(std::index_sequence<indices...>)
+{
+    return std::array<decltype(DecodedInstruction::handler), sizeof...(indices)>{
+        &run_fused_pair<fused_opcode_pairs[indices].first, fused_opcode_pairs[indices].second>...
+    };
+}
+
+auto CPU6502::fused_pair_handler(uint8_t first, uint8_t second) -> decltype(DecodedInstruction::handler)
+{
+    static constexpr auto handlers = make_fused_pair_handlers(std::make_index_sequence<fused_opcode_pairs.size()>());
+    for (size_t i = 0; i < fused_opcode_pairs.size(); ++i) {
+        if (fused_opcode_pairs[i].first == first && fused_opcode_pairs[i].second == second) return handlers[i];
+    }
+    return nullptr;
+}
+
+static bool same_registers(const CpuRegisters& lhs, const CpuRegisters& rhs)
+{
+    return lhs.a == rhs.a && lhs.x == rhs.x && lhs.y == rhs.y && lhs.pc == rhs.pc && lhs.s == rhs.s && lhs.p == rhs.p;
+}
+
+// Called after the branch at the end of a loop that only reads memory. If it went back to the start with the
+// registers the same as the last time it did, exactly once round the loop ago, then every time round from here will
+// be the same again as long as the memory it reads doesn't change underneath it. Nothing else runs until the CPU
+// stops, so all the times round that would finish before stop_cycle are skipped by counting their cycles.
+void CPU6502::fast_forward_idle_loop(uint16_t next_pc, uint8_t branch_cycles)
+{
+    const IdleLoopVisit previous = last_idle_loop_visit;
+    const uint64_t now           = cycle_count + branch_cycles;
+    last_idle_loop_visit         = { registers, now, registers.pc != next_pc };
+    if (!previous.valid || !last_idle_loop_visit.valid) return;
+
+    const std::span<const DecodedInstruction> block = block_cache.cached_block_at(registers.pc);
+    if (block.empty()) return;
+
+    uint64_t loop_cycles = branch_cycles;
+    for (const DecodedInstruction& decoded : block.first(block.size() - 1)) {
+        const Instruction& instruction = instruction_table[decoded.opcode];
+        loop_cycles += instruction.cycles;
+        const bool reads_memory =
+            instruction.mode == AddressingMode::ZeroPage || instruction.mode == AddressingMode::Absolute;
+        if (reads_memory && !memory.read_repeatable(decoded.operand)) return;
+    }
+
+    if (previous.cycle + loop_cycles != now || !same_registers(previous.registers, registers) || now >= stop_cycle) {
+        return;
+    }
+
+    const uint64_t skipped = (stop_cycle - now - 1) / loop_cycles * loop_cycles;
+    cycle_count += skipped;
+    idle_cycles_skipped += skipped;
+    last_idle_loop_visit.cycle += skipped;
+}
+
+TraceRecord CPU6502::trace_record(uint16_t pc) const
+{
+    const uint8_t opcode = memory.peek_byte(pc);
+    const uint8_t bytes  = instruction_table[opcode].bytes;
+    TraceRecord record   = {};
+    record.cycle         = cycle_count;
+    record.pc            = pc;
+    record.opcode        = opcode;
+    record.operands[0]   = bytes > 1 ? memory.peek_byte(pc + 1) : 0;
+    record.operands[1]   = bytes > 2 ? memory.peek_byte(pc + 2) : 0;
+    record.a             = registers.a;
+    record.x             = registers.x;
+    record.y             = registers.y;
+    record.s             = registers.s;
+    record.p             = registers.p.value();
+    return record;
+}
+
+void CPU6502::trace_instruction(uint16_t pc)
+{
+    const TraceRecord record = trace_record(pc);
+    if (tracer) tracer->push(record);
+    if (verbose_log) info_message("{}", format_trace_record(record));
+}
+
+uint8_t CPU6502::process_instruction()
+{
+    if (verbose_log || tracer) [[unlikely]] {
+        trace_instruction(registers.pc);
+    }
+
+    const uint16_t pc    = registers.pc++;
+    const uint8_t opcode = memory.read_byte(pc);
+    if (pair_histogram) [[unlikely]] {
+        pair_histogram->record(pc, opcode);
+    }
+    return dispatch(opcode);
 }
 
 void CPU6502::load_prg_rom(std::span<const uint8_t> buf)
@@ -300,8 +793,74 @@ void CPU6502::load_prg_rom(std::span<const uint8_t> buf)
     // TODO: validate size of data passed in
     memory.write_rom(0x8000, buf);
     if (buf.size() == 16 * 1024) {
-        memory.write_rom(0xC000, buf);
+        memory.mirror_pages(0xC0, 0x40, 0x80);
     }
+    // writes to ROM are ignored
+    memory.map_write(0x80, 0x80, nullptr);
+}
+
+bool CPU6502::load_cartridge(std::shared_ptr<const Cartridge> cart)
+{
+    static_program = cart && cart->get_mapper_number() == 0 ? find_static_program(cart->get_program_data()) : nullptr;
+    mapper         = Mapper::create(std::move(cart));
+    if (!mapper) return false;
+
+    mapper->attach(memory, &ppu);
+    return true;
+}
+
+void CPU6502::trigger_nmi()
+{
+    nmi_pending = true;
+    request_interrupt();
+}
+
+void CPU6502::set_irq_line(IrqSource source, bool asserted)
+{
+    if (asserted) {
+        irq_lines |= (uint8_t)source;
+        if (!registers.p.int_disable_flag_set()) request_interrupt();
+    } else {
+        irq_lines &= (uint8_t)~(uint8_t)source;
+    }
+}
+
+// The CPU stops at the end of the instruction it's part way through (or straight away if it isn't running) to take it
+void CPU6502::request_interrupt()
+{
+    interrupt_cycle = std::min(interrupt_cycle, cycle_count);
+    stop_cycle      = std::min(stop_cycle, cycle_count);
+}
+
+// Called once cycle_count has reached interrupt_cycle, returns how many cycles were spent taking an interrupt
+uint8_t CPU6502::take_interrupt()
+{
+    interrupt_cycle = no_interrupt;
+    // writing to the mapper acknowledges its IRQ without telling the CPU
+    if (mapper && !mapper->irq_asserted()) set_irq_line(IrqSource::Mapper, false);
+    if (nmi_pending) {
+        nmi_pending = false;
+        enter_interrupt(0xFFFA, false);
+        return 7;
+    }
+    if (irq_lines && !registers.p.int_disable_flag_set()) {
+        enter_interrupt(0xFFFE, false);
+        return 7;
+    }
+    return 0;
+}
+
+void CPU6502::enter_interrupt(uint16_t vector, bool from_brk)
+{
+    stack_push_word(registers.pc);
+
+    // bit 5 is always pushed set, bit 4 only by BRK (and PHP) so the handler can tell it apart from an IRQ
+    uint8_t to_push = registers.p.value() | (1 << 5);
+    to_push         = from_brk ? (uint8_t)(to_push | (1 << 4)) : (uint8_t)(to_push & ~(1 << 4));
+    stack_push_byte(to_push);
+
+    registers.p.set_int_disable_flag();
+    registers.pc = memory.read_word(vector);
 }
 
 void CPU6502::reset()
@@ -350,19 +909,12 @@ uint16_t CPU6502::stack_pop_word()
 
 void CPU6502::adjust_zero_and_negative_flags(uint8_t data)
 {
-    if (data == 0) {
-        registers.p.set_zero_flag();
-    } else {
-        registers.p.clear_zero_flag();
-    }
-
-    if (is_negative(data)) {
-        registers.p.set_negative_flag();
-    } else {
-        registers.p.clear_negative_flag();
-    }
+    registers.p.set_zero_and_negative_from(data);
 }
 
+// Each addressing mode fetches its operand bytes from pc and then hands them to the matching resolve_ function to
+// work out the address, the block cache has already fetched the operand so it calls the resolve_ function directly
+
 uint16_t CPU6502::imm()
 {
     return registers.pc++;
@@ -370,69 +922,117 @@ uint16_t CPU6502::imm()
 
 uint16_t CPU6502::zp()
 {
-    return memory.read_byte(registers.pc++);
+    return resolve_zp(memory.read_byte(registers.pc++));
 }
 
 uint16_t CPU6502::zpx()
 {
-    const uint8_t instruction_offset = memory.read_byte(registers.pc++);
-    const uint8_t x                  = registers.x;
-
-    // Let this addition wrap on overflow as the NES did
-    const uint8_t byte_addr = instruction_offset + x;
-    return byte_addr;
+    return resolve_zpx(memory.read_byte(registers.pc++));
 }
 
 uint16_t CPU6502::zpy()
 {
-    const uint8_t operand = memory.read_byte(registers.pc++);
-    const uint8_t y       = registers.y;
-
-    // Let this addition wrap on overflow as the NES did
-    const uint8_t byte_addr = operand + y;
-    return byte_addr;
+    return resolve_zpy(memory.read_byte(registers.pc++));
 }
 
 uint16_t CPU6502::abs()
 {
-    const uint16_t ret = memory.read_word(registers.pc);
+    const uint16_t operand = memory.read_word(registers.pc);
     registers.pc += 2;
-    return ret;
+    return resolve_abs(operand);
 }
 
 uint16_t CPU6502::absx()
 {
-    const uint16_t instruction_offset = memory.read_word(registers.pc);
-    const uint8_t x                   = registers.x;
+    const uint16_t operand = memory.read_word(registers.pc);
+    registers.pc += 2;
+    return resolve_absx(operand);
+}
 
+uint16_t CPU6502::absy()
+{
+    const uint16_t operand = memory.read_word(registers.pc);
     registers.pc += 2;
+    return resolve_absy(operand);
+}
 
-    // Let it wrap on overflow - think that's correct behaviour
-    const uint16_t byte_addr = instruction_offset + (uint16_t)x;
-    return byte_addr;
+uint16_t CPU6502::indx()
+{
+    return resolve_indx(memory.read_byte(registers.pc++));
 }
 
-uint16_t CPU6502::absy()
+uint16_t CPU6502::indy()
 {
-    const uint16_t instruction_offset = memory.read_word(registers.pc);
-    const uint8_t y                   = registers.y;
+    return resolve_indy(memory.read_byte(registers.pc++));
+}
 
+uint16_t CPU6502::rel()
+{
+    return registers.pc++;
+}
+
+uint16_t CPU6502::imp()
+{
+    return 0;
+}
+
+uint16_t CPU6502::ind()
+{
+    const uint16_t operand = memory.read_word(registers.pc);
     registers.pc += 2;
+    return resolve_ind(operand);
+}
+
+// immediate and relative operations read their operand straight from the instruction, which is the byte before pc
+// once the instruction has been fetched
+uint16_t CPU6502::resolve_operand_byte(uint16_t)
+{
+    return registers.pc - 1;
+}
 
+uint16_t CPU6502::resolve_zp(uint16_t operand)
+{
+    return operand & 0xFF;
+}
+
+uint16_t CPU6502::resolve_zpx(uint16_t operand)
+{
+    // Let this addition wrap on overflow as the NES did
+    const uint8_t byte_addr = (uint8_t)(operand + registers.x);
+    return byte_addr;
+}
+
+uint16_t CPU6502::resolve_zpy(uint16_t operand)
+{
+    // Let this addition wrap on overflow as the NES did
+    const uint8_t byte_addr = (uint8_t)(operand + registers.y);
+    return byte_addr;
+}
+
+uint16_t CPU6502::resolve_abs(uint16_t operand)
+{
+    return operand;
+}
+
+uint16_t CPU6502::resolve_absx(uint16_t operand)
+{
     // Let it wrap on overflow - think that's correct behaviour
-    const uint16_t byte_addr = instruction_offset + (uint16_t)y;
-    if (byte_addr & 0xFF) {
-        page_crossed = true;
-    }
+    const uint16_t byte_addr = operand + (uint16_t)registers.x;
+    page_crossed             = (byte_addr ^ operand) > 0xFF;
     return byte_addr;
 }
 
-uint16_t CPU6502::indx()
+uint16_t CPU6502::resolve_absy(uint16_t operand)
 {
-    const uint8_t operand = memory.read_byte(registers.pc++);
-    const uint8_t x       = registers.x;
+    // Let it wrap on overflow - think that's correct behaviour
+    const uint16_t byte_addr = operand + (uint16_t)registers.y;
+    page_crossed             = (byte_addr ^ operand) > 0xFF;
+    return byte_addr;
+}
 
-    const uint8_t lsb_addr    = operand + x;
+uint16_t CPU6502::resolve_indx(uint16_t operand)
+{
+    const uint8_t lsb_addr    = (uint8_t)(operand + registers.x);
     const uint8_t msb_addr    = lsb_addr + (uint8_t)1;
     const uint8_t lsb         = memory.read_byte(lsb_addr);
     const uint8_t msb         = memory.read_byte(msb_addr);
@@ -440,41 +1040,26 @@ uint16_t CPU6502::indx()
     return final_addr;
 }
 
-uint16_t CPU6502::indy()
+uint16_t CPU6502::resolve_indy(uint16_t operand)
 {
-    const uint8_t operand            = memory.read_byte(registers.pc++);
-    const uint8_t lsb                = memory.read_byte(operand);
-    const uint8_t msb_addr           = operand + 1;
+    const uint8_t lsb                = memory.read_byte(operand & 0xFF);
+    const uint8_t msb_addr           = (uint8_t)(operand + 1);
     const uint8_t msb                = memory.read_byte(msb_addr);
     const uint16_t intermediate_addr = (uint16_t)((msb << 8) | lsb);
     const uint16_t final_addr        = intermediate_addr + registers.y;
-    if (final_addr & 0xFF) {
-        page_crossed = true;
-    }
+    page_crossed                     = (final_addr ^ intermediate_addr) > 0xFF;
     return final_addr;
 }
 
-uint16_t CPU6502::rel()
-{
-    return registers.pc++;
-}
-
-uint16_t CPU6502::imp()
-{
-    return 0;
-}
-
 static uint16_t next_byte_in_page(uint16_t addr)
 {
     return (addr & 0xFF00) + ((addr + 1) & 0xFF);
 }
 
-uint16_t CPU6502::ind()
+uint16_t CPU6502::resolve_ind(uint16_t operand)
 {
-    const uint16_t addr = memory.read_word(registers.pc);
-    registers.pc += 2;
-    const uint16_t lsb = memory.read_byte(addr);
-    const uint16_t msb = memory.read_byte(next_byte_in_page(addr));
+    const uint16_t lsb = memory.read_byte(operand);
+    const uint16_t msb = memory.read_byte(next_byte_in_page(operand));
     return (msb << 8) | lsb;
 }
 
@@ -482,7 +1067,7 @@ uint8_t CPU6502::lda(uint16_t data_addr)
 {
     registers.a = memory.read_byte(data_addr);
     adjust_zero_and_negative_flags(registers.a);
-    return (uint8_t)page_crossed;
+    return 0;
 }
 
 uint8_t CPU6502::ldx(uint16_t data_addr)
@@ -506,18 +1091,9 @@ uint8_t CPU6502::adc(uint16_t data_addr)
     const uint8_t old_acc = registers.a;
     registers.a           = res & 0xFF;
     adjust_zero_and_negative_flags(registers.a);
-    if (res & 0xFF00) {
-        registers.p.set_carry_bit();
-    } else {
-        registers.p.clear_carry_flag();
-    }
-    if (is_positive(data) && is_positive(old_acc) && is_negative(res)) {
-        registers.p.set_overflow_bit();
-    } else if (is_negative(data) && is_negative(old_acc) && is_positive(res)) {
-        registers.p.set_overflow_bit();
-    } else {
-        registers.p.clear_overflow_flag();
-    }
+    registers.p.assign_carry(res & 0xFF00);
+    // overflow when both inputs have the same sign and the result's sign is different
+    registers.p.assign_overflow(is_negative((uint8_t)(~(old_acc ^ data) & (old_acc ^ res))));
     return 0;
 }
 
@@ -531,11 +1107,7 @@ uint8_t CPU6502::and_op(uint16_t data_addr)
 
 uint8_t CPU6502::asl_impl(uint8_t data)
 {
-    if (data & BIT_7) {
-        registers.p.set_carry_bit();
-    } else {
-        registers.p.clear_carry_flag();
-    }
+    registers.p.assign_carry(data & BIT_7);
     data <<= 1;
     adjust_zero_and_negative_flags(data);
     return data;
@@ -606,20 +1178,9 @@ uint8_t CPU6502::bit(uint16_t data_addr)
 {
     const uint8_t data   = memory.read_byte(data_addr);
     const uint8_t result = data & registers.a;
-    if (result) {
-        registers.p.clear_zero_flag();
-    } else {
-        registers.p.set_zero_flag();
-    }
-
-    if (data & BIT_7)
-        registers.p.set_negative_flag();
-    else
-        registers.p.clear_negative_flag();
-    if (data & BIT_6)
-        registers.p.set_overflow_bit();
-    else
-        registers.p.clear_overflow_flag();
+    registers.p.set_zero_from(result);
+    registers.p.set_negative_from(data);
+    registers.p.assign_overflow(data & BIT_6);
     return 0;
 }
 
@@ -639,10 +1200,18 @@ uint8_t CPU6502::bpl(uint16_t data_addr)
     return 0;
 }
 
-uint8_t CPU6502::brk(uint16_t data_addr)
+// does nothing, see make_instruction_table
+uint8_t CPU6502::illegal_opcode(uint16_t data_addr)
 {
     (void)data_addr;
-    NOT_IMPLEMENTED();
+    return 0;
+}
+
+uint8_t CPU6502::brk(uint16_t)
+{
+    // BRK skips the byte after it, so returns past it
+    registers.pc++;
+    enter_interrupt(0xFFFE, true);
     return 0;
 }
 
@@ -679,6 +1248,7 @@ uint8_t CPU6502::cli(uint16_t data_addr)
 {
     (void)data_addr;
     registers.p.clear_int_disable_flag();
+    if (irq_lines) request_interrupt();
     return 0;
 }
 
@@ -691,22 +1261,8 @@ uint8_t CPU6502::clv(uint16_t data_addr)
 
 static void set_flags_from_compare(uint8_t reg, uint8_t mem_data, StatusRegister& flags)
 {
-    if (reg >= mem_data) {
-        flags.set_carry_bit();
-    } else {
-        flags.clear_carry_flag();
-    }
-    if (reg == mem_data) {
-        flags.set_zero_flag();
-    } else {
-        flags.clear_zero_flag();
-    }
-
-    if (is_negative(reg - mem_data)) {
-        flags.set_negative_flag();
-    } else {
-        flags.clear_negative_flag();
-    }
+    flags.assign_carry(reg >= mem_data);
+    flags.set_zero_and_negative_from((uint8_t)(reg - mem_data));
 }
 
 uint8_t CPU6502::cmp(uint16_t data_addr)
@@ -797,13 +1353,8 @@ uint8_t CPU6502::jsr(uint16_t data_addr)
 
 uint8_t CPU6502::lsr_impl(uint8_t data)
 {
-    const uint8_t carry = data & 1;
+    registers.p.assign_carry(data & 1);
     data >>= 1;
-    if (carry) {
-        registers.p.set_carry_bit();
-    } else {
-        registers.p.clear_carry_flag();
-    }
     adjust_zero_and_negative_flags(data);
     return data;
 }
@@ -849,7 +1400,7 @@ uint8_t CPU6502::php(uint16_t)
     StatusRegister to_push = registers.p;
     to_push.set_bflag();
     to_push.set_unused_flag();
-    stack_push_byte((uint8_t)to_push.reg);
+    stack_push_byte(to_push.value());
     return 0;
 }
 
@@ -866,7 +1417,7 @@ void CPU6502::pop_p_from_stack()
     // So restore these to whatever state they were in before this
     const bool bflag       = registers.p.bflag_flag_set();
     const bool unused_flag = registers.p.unused_flag_set();
-    registers.p.reg        = (StatusRegFlag)stack_pop_byte();
+    registers.p.set_value(stack_pop_byte());
     bflag ? registers.p.set_bflag() : registers.p.clear_bflag();
     unused_flag ? registers.p.set_unused_flag() : registers.p.clear_unused_flag();
 }
@@ -874,6 +1425,7 @@ void CPU6502::pop_p_from_stack()
 uint8_t CPU6502::plp(uint16_t)
 {
     pop_p_from_stack();
+    if (irq_lines && !registers.p.int_disable_flag_set()) request_interrupt();
     return 0;
 }
 
@@ -893,19 +1445,9 @@ uint8_t CPU6502::rol_acc(uint16_t)
 
 uint8_t CPU6502::rol_impl(uint8_t data)
 {
-    const uint8_t old_bit_7 = data & (1 << 7);
     const uint8_t old_carry = registers.p.carry_bit_set();
-    data <<= 1;
-    if (old_carry) {
-        data |= (uint8_t)1;
-    } else {
-        data &= ~((uint8_t)1);
-    }
-    if (old_bit_7) {
-        registers.p.set_carry_bit();
-    } else {
-        registers.p.clear_carry_flag();
-    }
+    registers.p.assign_carry(data & BIT_7);
+    data = (uint8_t)((data << 1) | old_carry);
     adjust_zero_and_negative_flags(data);
     return data;
 }
@@ -926,19 +1468,9 @@ uint8_t CPU6502::ror_acc(uint16_t)
 
 uint8_t CPU6502::ror_impl(uint8_t data)
 {
-    const uint8_t old_bit_0 = data & 1;
     const uint8_t old_carry = registers.p.carry_bit_set();
-    data >>= 1;
-    if (old_carry) {
-        data |= (uint8_t)(1 << 7);
-    } else {
-        data &= ~((uint8_t)(1 << 7));
-    }
-    if (old_bit_0) {
-        registers.p.set_carry_bit();
-    } else {
-        registers.p.clear_carry_flag();
-    }
+    registers.p.assign_carry(data & 1);
+    data = (uint8_t)((data >> 1) | (old_carry << 7));
     adjust_zero_and_negative_flags(data);
     return data;
 }
@@ -947,6 +1479,7 @@ uint8_t CPU6502::rti(uint16_t)
 {
     pop_p_from_stack();
     registers.pc = stack_pop_word();
+    if (irq_lines && !registers.p.int_disable_flag_set()) request_interrupt();
     return 0;
 }
 
@@ -963,18 +1496,10 @@ uint8_t CPU6502::sbc(uint16_t data_addr)
     const uint16_t res    = registers.a - data - ((uint8_t)1 - (uint8_t)registers.p.carry_bit_set());
     const uint8_t old_acc = registers.a;
     registers.a           = res & 0xFF;
-    if (res > 0xFF) {
-        registers.p.clear_carry_flag();
-    } else {
-        registers.p.set_carry_bit();
-    }
-    if (is_negative(old_acc) && is_positive(data) && is_positive(registers.a)) {
-        registers.p.set_overflow_bit();
-    } else if (is_positive(old_acc) && is_negative(data) && is_negative(registers.a)) {
-        registers.p.set_overflow_bit();
-    } else {
-        registers.p.clear_overflow_flag();
-    }
+    // carry is clear when the subtraction borrowed
+    registers.p.assign_carry(res <= 0xFF);
+    // overflow when the inputs have different signs and the result's sign differs from the accumulator's
+    registers.p.assign_overflow(is_negative((uint8_t)((old_acc ^ data) & (old_acc ^ registers.a))));
     adjust_zero_and_negative_flags(registers.a);
     return 0;
 }
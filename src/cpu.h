@@ -1,14 +1,48 @@
 #pragma once
 
+#include "block_cache.h"
+#include "io_registers.h"
+#include "mapper.h"
 #include "memory.h"
+#include "opcode_pairs.h"
+#include "ppu.h"
+#include "profiler.h"
+#include "recompiler.h"
+#include "scheduler.h"
+#include "static_recompiler.h"
+#include "trace.h"
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <span>
-#include <string>
-#include <unordered_map>
+
+enum class AddressingMode : uint8_t {
+    Implied,
+    Accumulator,
+    Immediate,
+    ZeroPage,
+    ZeroPageX,
+    ZeroPageY,
+    Absolute,
+    AbsoluteX,
+    AbsoluteY,
+    Indirect,
+    IndirectX,
+    IndirectY,
+    Relative
+};
+
+// The modes that read or write data outside the zero page, which can be a register rather than RAM (JMP ($xxxx) only
+// reads its pointer, but that can't be a register either)
+constexpr bool can_reach_io(AddressingMode mode)
+{
+    return mode == AddressingMode::Absolute || mode == AddressingMode::AbsoluteX || mode == AddressingMode::AbsoluteY ||
+           mode == AddressingMode::IndirectX || mode == AddressingMode::IndirectY;
+}
 
 enum class StatusRegFlag : uint8_t {
     Carry      = (1 << 0),
@@ -26,41 +60,76 @@ bool operator&(StatusRegFlag a, StatusRegFlag b);
 StatusRegFlag operator|(StatusRegFlag a, StatusRegFlag b);
 StatusRegFlag operator~(StatusRegFlag a);
 
+// N and Z are set by almost every instruction but only read by branches, php and whoever is inspecting the CPU, so
+// rather than working them out every time the register keeps the results they were last set from and only derives the
+// flags when they're read. The rest of the flags are stored as they are.
 struct StatusRegister
 {
-    StatusRegFlag reg;
+    StatusRegister(StatusRegFlag flags = {}) { set_value((uint8_t)flags); }
+
+    uint8_t value() const
+    {
+        const uint8_t zero = m_ZeroResult == 0 ? (uint8_t)StatusRegFlag::Zero : 0;
+        return (uint8_t)(m_Flags | (m_NegativeResult & (uint8_t)StatusRegFlag::Negative) | zero);
+    }
+    void set_value(uint8_t value)
+    {
+        m_Flags          = value & (uint8_t)~((uint8_t)StatusRegFlag::Negative | (uint8_t)StatusRegFlag::Zero);
+        m_NegativeResult = value;
+        m_ZeroResult     = (uint8_t)(~value & (uint8_t)StatusRegFlag::Zero);
+    }
+
+    // Z is set when result is zero and N when its top bit is set
+    void set_zero_and_negative_from(uint8_t result) { m_ZeroResult = m_NegativeResult = result; }
+    void set_zero_from(uint8_t result) { m_ZeroResult = result; }
+    void set_negative_from(uint8_t result) { m_NegativeResult = result; }
+
+    void set_zero_flag() { m_ZeroResult = 0; }
+    void clear_zero_flag() { m_ZeroResult = 1; }
+    bool zero_flag_set() const { return m_ZeroResult == 0; }
+
+    void set_negative_flag() { m_NegativeResult = (uint8_t)StatusRegFlag::Negative; }
+    void clear_negative_flag() { m_NegativeResult = 0; }
+    bool negative_flag_set() const { return m_NegativeResult & (uint8_t)StatusRegFlag::Negative; }
 
-    void set_zero_flag() { reg |= StatusRegFlag::Zero; }
-    void clear_zero_flag() { reg &= ~StatusRegFlag::Zero; }
-    bool zero_flag_set() const { return reg & StatusRegFlag::Zero; }
+    void set_carry_bit() { assign(StatusRegFlag::Carry, true); }
+    void clear_carry_flag() { assign(StatusRegFlag::Carry, false); }
+    void assign_carry(bool carry) { assign(StatusRegFlag::Carry, carry); }
+    bool carry_bit_set() const { return is_set(StatusRegFlag::Carry); }
 
-    void set_negative_flag() { reg |= StatusRegFlag::Negative; }
-    void clear_negative_flag() { reg &= ~StatusRegFlag::Negative; }
-    bool negative_flag_set() const { return reg & StatusRegFlag::Negative; }
+    void set_overflow_bit() { assign(StatusRegFlag::Overflow, true); }
+    void clear_overflow_flag() { assign(StatusRegFlag::Overflow, false); }
+    void assign_overflow(bool overflow) { assign(StatusRegFlag::Overflow, overflow); }
+    bool overflow_flag_set() const { return is_set(StatusRegFlag::Overflow); }
 
-    void set_carry_bit() { reg |= StatusRegFlag::Carry; }
-    void clear_carry_flag() { reg &= ~StatusRegFlag::Carry; }
-    bool carry_bit_set() const { return reg & StatusRegFlag::Carry; }
+    void set_int_disable_flag() { assign(StatusRegFlag::IntDisable, true); }
+    void clear_int_disable_flag() { assign(StatusRegFlag::IntDisable, false); }
+    bool int_disable_flag_set() const { return is_set(StatusRegFlag::IntDisable); }
 
-    void set_overflow_bit() { reg |= StatusRegFlag::Overflow; }
-    void clear_overflow_flag() { reg &= ~StatusRegFlag::Overflow; }
-    bool overflow_flag_set() const { return reg & StatusRegFlag::Overflow; }
+    void set_decimal_flag() { assign(StatusRegFlag::Decimal, true); }
+    void clear_decimal_flag() { assign(StatusRegFlag::Decimal, false); }
+    bool decimal_flag_set() const { return is_set(StatusRegFlag::Decimal); }
 
-    void set_int_disable_flag() { reg |= StatusRegFlag::IntDisable; }
-    void clear_int_disable_flag() { reg &= ~StatusRegFlag::IntDisable; }
-    bool int_disable_flag_set() const { return reg & StatusRegFlag::IntDisable; }
+    bool bflag_flag_set() const { return is_set(StatusRegFlag::BFlag); }
+    void clear_bflag() { assign(StatusRegFlag::BFlag, false); }
+    void set_bflag() { assign(StatusRegFlag::BFlag, true); }
 
-    void set_decimal_flag() { reg |= StatusRegFlag::Decimal; }
-    void clear_decimal_flag() { reg &= ~StatusRegFlag::Decimal; }
-    bool decimal_flag_set() const { return reg & StatusRegFlag::Decimal; }
+    bool unused_flag_set() const { return is_set(StatusRegFlag::UnusedBit); }
+    void clear_unused_flag() { assign(StatusRegFlag::UnusedBit, false); }
+    void set_unused_flag() { assign(StatusRegFlag::UnusedBit, true); }
 
-    bool bflag_flag_set() const { return reg & StatusRegFlag::BFlag; }
-    void clear_bflag() { reg &= ~StatusRegFlag::BFlag; }
-    void set_bflag() { reg |= StatusRegFlag::BFlag; }
+private:
+    friend struct CpuOffsets; // for the recompiler's generated code
 
-    bool unused_flag_set() const { return reg & StatusRegFlag::UnusedBit; }
-    void clear_unused_flag() { reg &= ~StatusRegFlag::UnusedBit; }
-    void set_unused_flag() { reg |= StatusRegFlag::UnusedBit; }
+    bool is_set(StatusRegFlag flag) const { return m_Flags & (uint8_t)flag; }
+    void assign(StatusRegFlag flag, bool set)
+    {
+        m_Flags = (uint8_t)((m_Flags & ~(uint8_t)flag) | ((uint8_t)set * (uint8_t)flag));
+    }
+
+    uint8_t m_Flags;          // everything but N and Z
+    uint8_t m_NegativeResult; // N is bit 7 of this
+    uint8_t m_ZeroResult;     // Z is set when this is zero
 };
 bool operator==(StatusRegister lhs, StatusRegister rhs);
 
@@ -94,7 +163,13 @@ struct CpuRegisters
     StatusRegister p; // the status register
 };
 
-// TODO: implement extra cycle for page boundary being crossed
+// Each bit of CPU6502::irq_lines is held by one of these
+enum class IrqSource : uint8_t {
+    Mapper          = (1 << 0),
+    ApuFrameCounter = (1 << 1),
+    ApuDmc          = (1 << 2)
+};
+
 class CPU6502
 {
 public:
@@ -102,15 +177,81 @@ public:
 
     CpuRegisters registers = {};
     Memory memory;
+    std::unique_ptr<Mapper> mapper;
 
+    // next_cycle() steps a single cycle, the run_* functions execute whole instructions until the cycle count has
+    // reached the target and so can overshoot it by the length of the last instruction
     void next_cycle();
+    void run_until(uint64_t target_cycle);
+    void run_for_cycles(uint64_t cycles);
+    void run_frame();
 
     uint8_t cycles_remaining = 0;
     uint64_t cycle_count     = 0;
 
+    // cycle_count stays at the start of an instruction while it runs, but it reads or writes memory on its last cycle.
+    // Instructions that can reach a register (see can_reach_io) set io_cycle to that before they do, so anything
+    // catching up to the CPU goes to access_cycle(), which outside of one of those is just cycle_count.
+    uint64_t io_cycle = 0;
+    uint64_t access_cycle() const { return std::max(cycle_count, io_cycle); }
+
+    // The run_* functions run blocks from the block cache until cycle_count reaches stop_cycle, anything that needs
+    // the CPU to stop sooner (the block cache dropping code that might be running, an event being scheduled) lowers it
+    uint64_t stop_cycle = 0;
+    Scheduler scheduler{ cycle_count, stop_cycle };
+    BlockCache block_cache{ memory, stop_cycle };
+    bool use_block_cache = true;
+
+    // Maps itself over $2000-$3FFF and schedules its events, so it has to come after memory and the scheduler
+    Ppu ppu{ *this };
+    IoRegisters io_registers{ *this };
+
+    // Interrupts are taken between instructions. Asserting one lowers interrupt_cycle, which the run_* functions fold
+    // into stop_cycle, so nothing has to be checked after every instruction. The NMI is edge triggered and latched
+    // until it's taken. IRQ is level triggered, held while any bit of irq_lines is set, and waits for I to be clear.
+    static constexpr uint64_t no_interrupt = UINT64_MAX;
+    uint64_t interrupt_cycle               = no_interrupt;
+    bool nmi_pending                       = false;
+    uint8_t irq_lines                      = 0;
+
+    void trigger_nmi();
+    void set_irq_line(IrqSource source, bool asserted);
+    uint8_t take_interrupt();
+
+    // Loops that only poll memory are skipped ahead to just before stop_cycle once going round has been seen to change
+    // nothing, see fast_forward_idle_loop. Turning this off steps through them instead.
+    bool skip_idle_loops         = true;
+    uint64_t idle_cycles_skipped = 0;
+
+    struct IdleLoopVisit
+    {
+        CpuRegisters registers;
+        uint64_t cycle;
+        bool valid;
+    };
+    IdleLoopVisit last_idle_loop_visit = {}; // the last time an idle loop went back to its start
+
+    // Hot blocks are translated to machine code and run natively, when the platform supports it
+    bool use_recompiler = false;
+    std::unique_ptr<Recompiler> recompiler;
+
+    // Used instead of all of the above for NROM games with a StaticProgram linked in, which load_cartridge finds
+    bool use_static_program             = true;
+    const StaticProgram* static_program = nullptr;
+
     uint8_t process_instruction();
+    // profiled records every instruction into the profiler, which the others leave out
+    template <bool profiled>
+    void run_blocks();
+    void run_native_blocks();
+    void run_static_program();
+    uint8_t process_profiled_instruction();
+    template <bool profiled>
+    void run_decoded_block(std::span<const DecodedInstruction> block);
+    int16_t prg_bank_at(uint16_t pc) const;
 
     void load_prg_rom(std::span<const uint8_t> buf);
+    bool load_cartridge(std::shared_ptr<const Cartridge> cart);
     void reset();
 
     // addressing modes
@@ -127,6 +268,18 @@ public:
     uint16_t imp();
     uint16_t ind();
 
+    // addressing modes given operand bytes that have already been fetched
+    uint16_t resolve_operand_byte(uint16_t operand);
+    uint16_t resolve_zp(uint16_t operand);
+    uint16_t resolve_zpx(uint16_t operand);
+    uint16_t resolve_zpy(uint16_t operand);
+    uint16_t resolve_abs(uint16_t operand);
+    uint16_t resolve_absx(uint16_t operand);
+    uint16_t resolve_absy(uint16_t operand);
+    uint16_t resolve_indx(uint16_t operand);
+    uint16_t resolve_indy(uint16_t operand);
+    uint16_t resolve_ind(uint16_t operand);
+
     // generic instructions
     uint8_t lda(uint16_t data_addr);
     uint8_t ldx(uint16_t data_data);
@@ -184,6 +337,7 @@ public:
     uint8_t txa(uint16_t data_addr);
     uint8_t txs(uint16_t data_addr);
     uint8_t tya(uint16_t data_addr);
+    uint8_t illegal_opcode(uint16_t data_addr);
 
     // helpers
     uint8_t asl_acc(uint16_t data_addr);
@@ -198,6 +352,8 @@ public:
     uint8_t displace_pc_from_data_addr(uint16_t data_addr);
     void adjust_zero_and_negative_flags(uint8_t data);
     void pop_p_from_stack();
+    void request_interrupt();
+    void enter_interrupt(uint16_t vector, bool from_brk);
 
     void stack_push_byte(uint8_t data);
     void stack_push_word(uint16_t data);
@@ -206,18 +362,46 @@ public:
     uint8_t stack_pop_byte();
     uint16_t stack_pop_word();
 
-    // TODO: Move this to a lookup table once we can
     using operation_fn_t  = uint8_t (CPU6502::*)(uint16_t);
     using addressing_fn_t = uint16_t (CPU6502::*)();
+    using resolve_fn_t    = uint16_t (CPU6502::*)(uint16_t);
     struct Instruction
     {
-        std::string name;
+        const char* name;
         operation_fn_t operation_fn;
-        addressing_fn_t addressing_fn;
+        AddressingMode mode;
         uint8_t cycles;
+        // the rest is filled in from the addressing mode
+        uint8_t bytes                 = 0;       // opcode plus operands
+        addressing_fn_t addressing_fn = nullptr; // nullptr for the accumulator
+        resolve_fn_t resolve_fn       = nullptr; // the addressing mode for operands that have already been fetched
+        bool page_cross_penalty       = false;   // takes page_crossed extra cycles
     };
-    std::unordered_map<uint8_t, Instruction> m_InstructionMap;
+    static const Instruction& instruction(uint8_t opcode);
+
+    uint8_t dispatch(uint8_t opcode);
+    template <uint8_t opcode>
+    uint8_t execute_opcode();
+    static auto decoded_handler(uint8_t opcode) -> decltype(DecodedInstruction::handler);
+    template <uint8_t opcode>
+    uint8_t execute_decoded(uint16_t operand);
+    static auto idle_loop_handler(uint8_t opcode) -> decltype(DecodedInstruction::handler);
+    // nullptr when the pair isn't one of fused_opcode_pairs
+    static auto fused_pair_handler(uint8_t first, uint8_t second) -> decltype(DecodedInstruction::handler);
+    void fast_forward_idle_loop(uint16_t next_pc, uint8_t branch_cycles);
+
+    TraceRecord trace_record(uint16_t pc) const;
+    void trace_instruction(uint16_t pc);
+
+    // verbose_log prints every instruction to stderr, tracer (when set) receives a binary record of each instead
+    bool verbose_log    = false;
+    TraceWriter* tracer = nullptr;
+    // when set, counts which opcodes follow which, see nes-opcode-pairs
+    OpcodePairHistogram* pair_histogram = nullptr;
+    // when set, counts the instructions run and their cycles by opcode and address
+    Profiler* profiler = nullptr;
 
-    bool verbose_log  = false;
+    // Set by the indexed addressing modes when indexing carried into the high byte of the address, which makes
+    // instructions that only read from it take a cycle longer
     bool page_crossed = false;
 };
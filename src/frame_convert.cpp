@@ -0,0 +1,308 @@
+#include "frame_convert.h"
+
+#include "ppu.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+// The lookups use pshufb when the CPU has it, checked at runtime so the build doesn't need to ask for it
+#if defined(__x86_64__) && defined(__GNUC__)
+#    define FRAME_CONVERT_SSSE3 1
+#    include <tmmintrin.h>
+#else
+#    define FRAME_CONVERT_SSSE3 0
+#endif
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
+bool frame_convert_use_ssse3 = true;
+
+namespace
+{
+
+// The 2C02's 64 colours as 0xRRGGBB
+constexpr std::array<uint32_t, 64> system_palette = {
+    0x666666, 0x002A88, 0x1412A7, 0x3B00A4, 0x5C007E, 0x6E0040, 0x6C0600, 0x561D00, //
+    0x333500, 0x0B4800, 0x005200, 0x004F08, 0x00404D, 0x000000, 0x000000, 0x000000, //
+    0xADADAD, 0x155FD9, 0x4240FF, 0x7527FE, 0xA01ACC, 0xB71E7B, 0xB53120, 0x994E00, //
+    0x6B6D00, 0x388700, 0x0C9300, 0x008F32, 0x007C8D, 0x000000, 0x000000, 0x000000, //
+    0xFFFEFF, 0x64B0FF, 0x9290FF, 0xC676FF, 0xF36AFF, 0xFE6ECC, 0xFE8170, 0xEA9E22, //
+    0xBCBE00, 0x88D800, 0x5CE430, 0x45E082, 0x48CDDE, 0x4F4F4F, 0x000000, 0x000000, //
+    0xFFFEFF, 0xC0DFFF, 0xD3D2FF, 0xE8C8FF, 0xFBC2FF, 0xFEC4EA, 0xFECCC5, 0xF7D8A5, //
+    0xE4E594, 0xCFEF96, 0xBDF4AB, 0xB3F3CC, 0xB5EBF2, 0xB8B8B8, 0x000000, 0x000000, //
+};
+
+template <typename Pixel>
+using ColourTable = std::array<std::array<Pixel, 64>, 8>; // by emphasis bits, then palette entry
+
+struct ColourTables
+{
+    ColourTable<uint32_t> rgba;
+    ColourTable<uint16_t> rgb565;
+    ColourTable<uint8_t> gray;
+};
+
+uint32_t rgba(uint32_t r, uint32_t g, uint32_t b)
+{
+    return r | g << 8 | b << 16 | 0xFF000000;
+}
+
+uint16_t to_rgb565(uint32_t rgba)
+{
+    const uint32_t r = rgba & 0xFF;
+    const uint32_t g = (rgba >> 8) & 0xFF;
+    const uint32_t b = (rgba >> 16) & 0xFF;
+    return (uint16_t)((r >> 3) << 11 | (g >> 2) << 5 | b >> 3);
+}
+
+uint8_t to_gray(uint32_t rgba)
+{
+    const uint32_t r = rgba & 0xFF;
+    const uint32_t g = (rgba >> 8) & 0xFF;
+    const uint32_t b = (rgba >> 16) & 0xFF;
+    return (uint8_t)((r * 77 + g * 150 + b * 29) >> 8);
+}
+
+// Each emphasis bit darkens the other two channels
+ColourTables make_colour_tables()
+{
+    ColourTables tables;
+    for (size_t emphasis = 0; emphasis < 8; ++emphasis) {
+        for (size_t entry = 0; entry < 64; ++entry) {
+            const uint32_t colour = system_palette[entry];
+            double channels[3]    = { (double)(colour >> 16), (double)((colour >> 8) & 0xFF), (double)(colour & 0xFF) };
+            for (size_t bit = 0; bit < 3; ++bit) {
+                if (!(emphasis & (1u << bit))) continue;
+                for (size_t channel = 0; channel < 3; ++channel) {
+                    if (channel != bit) channels[channel] *= 0.816;
+                }
+            }
+
+            const uint32_t pixel          = rgba((uint32_t)channels[0], (uint32_t)channels[1], (uint32_t)channels[2]);
+            tables.rgba[emphasis][entry]   = pixel;
+            tables.rgb565[emphasis][entry] = to_rgb565(pixel);
+            tables.gray[emphasis][entry]   = to_gray(pixel);
+        }
+    }
+    return tables;
+}
+
+const ColourTables& colour_tables()
+{
+    static const ColourTables tables = make_colour_tables();
+    return tables;
+}
+
+// Looks up count palette entries from in in colours, a pixel at a time
+template <typename Pixel>
+void convert_run_scalar(const uint8_t* in, size_t count, const std::array<Pixel, 64>& colours, uint8_t* out)
+{
+    for (size_t i = 0; i < count; ++i, out += sizeof(Pixel)) {
+        const Pixel pixel = colours[in[i] & 0x3F];
+        std::memcpy(out, &pixel, sizeof(pixel));
+    }
+}
+
+#if FRAME_CONVERT_SSSE3
+// The same 16 pixels at a time. The table is split into a 64 byte table for each byte of the pixel, each of which is
+// four registers of 16 entries for pshufb. It only looks at the bottom four bits of the index and gives 0 when the top
+// one is set, so each register is looked up with an index that has the top bit set unless the entry is in it, and the
+// four are ORed together. A byte that's the same for every colour (RGBA's alpha) isn't looked up at all.
+template <typename Pixel>
+__attribute__((target("ssse3"))) void convert_run_ssse3(const uint8_t* in,
+                                                        size_t count,
+                                                        const std::array<Pixel, 64>& colours,
+                                                        uint8_t* out)
+{
+    constexpr size_t bytes = sizeof(Pixel);
+    __m128i planes[bytes][4];
+    bool constant[bytes];
+    for (size_t byte = 0; byte < bytes; ++byte) {
+        alignas(16) uint8_t plane[64];
+        for (size_t entry = 0; entry < 64; ++entry) {
+            plane[entry] = (uint8_t)(colours[entry] >> (byte * 8));
+        }
+        for (size_t quarter = 0; quarter < 4; ++quarter) {
+            planes[byte][quarter] = _mm_load_si128((const __m128i*)(plane + quarter * 16));
+        }
+        constant[byte] = std::all_of(plane, plane + 64, [&](uint8_t value) { return value == plane[0]; });
+    }
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16, out += 16 * bytes) {
+        const __m128i index = _mm_and_si128(_mm_loadu_si128((const __m128i*)(in + i)), _mm_set1_epi8(0x3F));
+        __m128i in_quarter[4];
+        for (size_t q = 0; q < 4; ++q) {
+            // bits 4 and 5 are 0 only in the quarter's own entries, adding 0x70 carries anything else into bit 7
+            const __m128i relative = _mm_xor_si128(index, _mm_set1_epi8((char)(q * 16)));
+            in_quarter[q]          = _mm_adds_epu8(relative, _mm_set1_epi8(0x70));
+        }
+
+        __m128i looked_up[bytes];
+        for (size_t byte = 0; byte < bytes; ++byte) {
+            if (constant[byte]) {
+                looked_up[byte] = planes[byte][0];
+                continue;
+            }
+            looked_up[byte] = _mm_shuffle_epi8(planes[byte][0], in_quarter[0]);
+            for (size_t q = 1; q < 4; ++q) {
+                looked_up[byte] = _mm_or_si128(looked_up[byte], _mm_shuffle_epi8(planes[byte][q], in_quarter[q]));
+            }
+        }
+
+        // back into pixels, the bytes in memory order
+        __m128i* to = (__m128i*)out;
+        if constexpr (bytes == 1) {
+            _mm_storeu_si128(to, looked_up[0]);
+        } else if constexpr (bytes == 2) {
+            _mm_storeu_si128(to, _mm_unpacklo_epi8(looked_up[0], looked_up[1]));
+            _mm_storeu_si128(to + 1, _mm_unpackhi_epi8(looked_up[0], looked_up[1]));
+        } else {
+            const __m128i low_halves[2]  = { _mm_unpacklo_epi8(looked_up[0], looked_up[1]),
+                                             _mm_unpackhi_epi8(looked_up[0], looked_up[1]) };
+            const __m128i high_halves[2] = { _mm_unpacklo_epi8(looked_up[2], looked_up[3]),
+                                             _mm_unpackhi_epi8(looked_up[2], looked_up[3]) };
+            for (size_t half = 0; half < 2; ++half) {
+                _mm_storeu_si128(to + half * 2, _mm_unpacklo_epi16(low_halves[half], high_halves[half]));
+                _mm_storeu_si128(to + half * 2 + 1, _mm_unpackhi_epi16(low_halves[half], high_halves[half]));
+            }
+        }
+    }
+    convert_run_scalar(in + i, count - i, colours, out);
+}
+
+bool cpu_has_ssse3()
+{
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+    return has_ssse3;
+}
+#endif
+
+template <typename Pixel>
+void convert_run(const uint8_t* in, size_t count, const std::array<Pixel, 64>& colours, uint8_t* out)
+{
+#if FRAME_CONVERT_SSSE3
+    if (frame_convert_use_ssse3 && cpu_has_ssse3()) {
+        convert_run_ssse3(in, count, colours, out);
+        return;
+    }
+#endif
+    convert_run_scalar(in, count, colours, out);
+}
+
+// Converts count pixels of the frame from first, each with the table for the emphasis it was drawn with
+template <typename Pixel>
+void convert_pixels(const Ppu& ppu, const ColourTable<Pixel>& table, size_t first, size_t count, uint8_t* out)
+{
+    const std::span<const Ppu::EmphasisSpan> spans = ppu.emphasis_spans();
+    const size_t end                               = first + count;
+    for (size_t i = 0; i < spans.size(); ++i) {
+        const size_t span_end = i + 1 < spans.size() ? spans[i + 1].first_pixel : end;
+        const size_t from     = std::max<size_t>(first, spans[i].first_pixel);
+        const size_t to       = std::min(end, span_end);
+        if (from >= to) continue;
+        const std::array<Pixel, 64>& colours = table[spans[i].emphasis & 7];
+        convert_run(ppu.frame().data() + from, to - from, colours, out + (from - first) * sizeof(Pixel));
+    }
+}
+
+// Rounds down, a byte at a time without carrying into the next
+uint32_t average(uint32_t lhs, uint32_t rhs)
+{
+    return (lhs & rhs) + (((lhs ^ rhs) & 0xFEFEFEFE) >> 1);
+}
+
+#if defined(__SSE2__)
+__m128i average(__m128i lhs, __m128i rhs)
+{
+    const __m128i halves = _mm_and_si128(_mm_srli_epi16(_mm_xor_si128(lhs, rhs), 1), _mm_set1_epi8(0x7F));
+    return _mm_add_epi8(_mm_and_si128(lhs, rhs), halves);
+}
+#endif
+
+// Each pair of rows goes through the RGBA tables and then each 2x2 block is averaged, across and then down
+template <typename Pixel, typename Pack>
+void convert_half_size(const Ppu& ppu, Pack pack, uint8_t* out)
+{
+    std::array<uint32_t, Ppu::width * 2> rows;
+    std::array<uint32_t, Ppu::width / 2> averaged;
+    for (size_t y = 0; y < Ppu::height; y += 2) {
+        convert_pixels(ppu, colour_tables().rgba, y * Ppu::width, Ppu::width * 2, (uint8_t*)rows.data());
+        const uint32_t* top    = rows.data();
+        const uint32_t* bottom = top + Ppu::width;
+
+        size_t x = 0;
+#if defined(__SSE2__)
+        for (; x + 8 <= Ppu::width; x += 8) {
+            const auto across = [](const uint32_t* row) {
+                const __m128i left  = _mm_loadu_si128((const __m128i*)row);
+                const __m128i right = _mm_loadu_si128((const __m128i*)(row + 4));
+                const __m128 evens  = _mm_shuffle_ps(_mm_castsi128_ps(left), _mm_castsi128_ps(right), 0x88);
+                const __m128 odds   = _mm_shuffle_ps(_mm_castsi128_ps(left), _mm_castsi128_ps(right), 0xDD);
+                return average(_mm_castps_si128(evens), _mm_castps_si128(odds));
+            };
+            _mm_storeu_si128((__m128i*)(averaged.data() + x / 2), average(across(top + x), across(bottom + x)));
+        }
+#endif
+        for (; x < Ppu::width; x += 2) {
+            averaged[x / 2] = average(average(top[x], top[x + 1]), average(bottom[x], bottom[x + 1]));
+        }
+
+        for (const uint32_t rgba : averaged) {
+            const Pixel pixel = pack(rgba);
+            std::memcpy(out, &pixel, sizeof(pixel));
+            out += sizeof(pixel);
+        }
+    }
+}
+
+} // namespace
+
+size_t pixel_size(PixelFormat format)
+{
+    switch (format) {
+        case PixelFormat::Rgba8888: return 4;
+        case PixelFormat::Rgb565: return 2;
+        case PixelFormat::Gray8: return 1;
+    }
+    return 0;
+}
+
+size_t converted_frame_size(PixelFormat format, bool half_size)
+{
+    const size_t scale = half_size ? 2 : 1;
+    return (Ppu::width / scale) * (Ppu::height / scale) * pixel_size(format);
+}
+
+bool convert_frame(const Ppu& ppu, PixelFormat format, bool half_size, std::span<uint8_t> out)
+{
+    if (out.size() < converted_frame_size(format, half_size)) return false;
+
+    const ColourTables& tables = colour_tables();
+    switch (format) {
+        case PixelFormat::Rgba8888:
+            if (half_size) {
+                convert_half_size<uint32_t>(ppu, [](uint32_t pixel) { return pixel; }, out.data());
+            } else {
+                convert_pixels(ppu, tables.rgba, 0, Ppu::width * Ppu::height, out.data());
+            }
+            break;
+        case PixelFormat::Rgb565:
+            if (half_size) {
+                convert_half_size<uint16_t>(ppu, to_rgb565, out.data());
+            } else {
+                convert_pixels(ppu, tables.rgb565, 0, Ppu::width * Ppu::height, out.data());
+            }
+            break;
+        case PixelFormat::Gray8:
+            if (half_size) {
+                convert_half_size<uint8_t>(ppu, to_gray, out.data());
+            } else {
+                convert_pixels(ppu, tables.gray, 0, Ppu::width * Ppu::height, out.data());
+            }
+            break;
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+class Ppu;
+
+enum class PixelFormat {
+    Rgba8888, // bytes R, G, B, A
+    Rgb565,   // native endian uint16_t
+    Gray8     // luma
+};
+
+size_t pixel_size(PixelFormat format);
+// How many bytes convert_frame writes
+size_t converted_frame_size(PixelFormat format, bool half_size);
+
+// The PPU only records palette entries, this turns its last frame into colours for something that wants them. Each
+// run of pixels drawn with the same emphasis bits is a lookup into the table for them, 16 pixels at a time with SSSE3.
+// half_size averages each 2x2 block of pixels into one. out gets rows of pixels with nothing between them, false if
+// it's too small for the frame.
+bool convert_frame(const Ppu& ppu, PixelFormat format, bool half_size, std::span<uint8_t> out);
+
+// Lets the SSSE3 lookups be turned off to check them against the plain ones, they're only used if the CPU has them
+extern bool frame_convert_use_ssse3;
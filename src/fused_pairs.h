@@ -0,0 +1,44 @@
+// Generated by nes-opcode-pairs from 358773 pairs of instructions, the 32 most frequent that can be fused
+// (with their share of all the pairs). The block cache runs each as a single superinstruction.
+// Made with: nes-opcode-pairs fused_pairs.h static_test.nes --frames 60 --pairs 32
+#pragma once
+
+#include "opcode_pairs.h"
+#include "opcodes.h"
+
+#include <array>
+
+inline constexpr std::array<OpcodePair, 32> fused_opcode_pairs = { {
+    { OPCODE_EOR_INDY, OPCODE_LDA_INDX }, // (12.81%)
+    { OPCODE_ADC_ABSY, OPCODE_STA_ABSY }, // (12.81%)
+    { OPCODE_STA_ABSY, OPCODE_EOR_INDY }, // (12.81%)
+    { OPCODE_LDA_INDX, OPCODE_INY_IMP }, // (12.81%)
+    { OPCODE_LDA_ABSY, OPCODE_ADC_ABSY }, // (12.81%)
+    { OPCODE_INY_IMP, OPCODE_BNE_REL }, // (12.81%)
+    { OPCODE_LDA_ABSX, OPCODE_STA_ZP }, // (1.60%)
+    { OPCODE_INC_ZP, OPCODE_LDA_ZP }, // (1.00%)
+    { OPCODE_CLC_IMP, OPCODE_ADC_IMM }, // (0.80%)
+    { OPCODE_BIT_ZP, OPCODE_BMI_REL }, // (0.80%)
+    { OPCODE_SEC_IMP, OPCODE_SBC_ZP }, // (0.80%)
+    { OPCODE_EOR_ZP, OPCODE_STA_ZPX }, // (0.80%)
+    { OPCODE_LSR_ACC, OPCODE_ROR_ZP }, // (0.80%)
+    { OPCODE_ROR_ZP, OPCODE_BIT_ZP }, // (0.80%)
+    { OPCODE_ADC_IMM, OPCODE_STA_ZP }, // (0.80%)
+    { OPCODE_STA_ZP, OPCODE_LSR_ACC }, // (0.80%)
+    { OPCODE_STA_ZP, OPCODE_LDX_ZP }, // (0.80%)
+    { OPCODE_STA_ZPX, OPCODE_SEC_IMP }, // (0.80%)
+    { OPCODE_LDY_IMM, OPCODE_LDA_ABSY }, // (0.80%)
+    { OPCODE_LDA_ZP, OPCODE_CLC_IMP }, // (0.80%)
+    { OPCODE_LDX_ZP, OPCODE_LDA_ZPX }, // (0.80%)
+    { OPCODE_LDA_ZPX, OPCODE_EOR_ZP }, // (0.80%)
+    { OPCODE_SBC_ZP, OPCODE_STA_ZP }, // (0.80%)
+    { OPCODE_ASL_ACC, OPCODE_TAX_IMP }, // (0.80%)
+    { OPCODE_AND_IMM, OPCODE_ASL_ACC }, // (0.80%)
+    { OPCODE_STA_ZP, OPCODE_JMP_IND }, // (0.80%)
+    { OPCODE_STA_ZP, OPCODE_LDA_ABSX }, // (0.80%)
+    { OPCODE_LDA_ZP, OPCODE_AND_IMM }, // (0.80%)
+    { OPCODE_TAX_IMP, OPCODE_LDA_ABSX }, // (0.80%)
+    { OPCODE_DEC_ZP, OPCODE_RTS_IMP }, // (0.47%)
+    { OPCODE_LDA_IMM, OPCODE_PHA_IMP }, // (0.40%)
+    { OPCODE_INC_ZP, OPCODE_JMP_ABS }, // (0.40%)
+} };
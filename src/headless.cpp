@@ -0,0 +1,219 @@
+#include "headless.h"
+
+#include "cpu.h"
+#include "log.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+
+constexpr uint64_t prime1 = 0x9E3779B185EBCA87;
+constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4F;
+constexpr uint64_t prime3 = 0x165667B19E3779F9;
+constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63;
+constexpr uint64_t prime5 = 0x27D4EB2F165667C5;
+
+uint64_t read64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t read32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t stripe_round(uint64_t acc, uint64_t input)
+{
+    acc += input * prime2;
+    return std::rotl(acc, 31) * prime1;
+}
+
+uint64_t merge_round(uint64_t hash, uint64_t acc)
+{
+    hash ^= stripe_round(0, acc);
+    return hash * prime1 + prime4;
+}
+
+// RLDUTSBA, the order FCEUX's movies write the buttons in
+constexpr std::array<char, 8> button_letters = { 'R', 'L', 'D', 'U', 'T', 'S', 'B', 'A' };
+
+std::optional<uint8_t> parse_buttons(std::string_view text)
+{
+    if (text.size() != button_letters.size()) return std::nullopt;
+    uint8_t buttons = 0;
+    for (size_t i = 0; i < button_letters.size(); ++i) {
+        // R is the top bit of the mask and A the bottom, see Button
+        if (text[i] == button_letters[i]) buttons |= (uint8_t)(0x80 >> i);
+    }
+    return buttons;
+}
+
+std::string_view next_field(std::string_view& line)
+{
+    const size_t start = std::min(line.find_first_not_of(" \t"), line.size());
+    line.remove_prefix(start);
+    const size_t end             = std::min(line.find_first_of(" \t"), line.size());
+    const std::string_view field = line.substr(0, end);
+    line.remove_prefix(end);
+    return field;
+}
+
+} // namespace
+
+// The reads assume a little endian host, like the rest of the emulator's memory handling
+uint64_t xxhash64(std::span<const uint8_t> data, uint64_t seed)
+{
+    const uint8_t* p   = data.data();
+    const uint8_t* end = p + data.size();
+    uint64_t hash;
+
+    if (data.size() >= 32) {
+        uint64_t v1 = seed + prime1 + prime2;
+        uint64_t v2 = seed + prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime1;
+        for (; end - p >= 32; p += 32) {
+            v1 = stripe_round(v1, read64(p));
+            v2 = stripe_round(v2, read64(p + 8));
+            v3 = stripe_round(v3, read64(p + 16));
+            v4 = stripe_round(v4, read64(p + 24));
+        }
+        hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        hash = merge_round(hash, v1);
+        hash = merge_round(hash, v2);
+        hash = merge_round(hash, v3);
+        hash = merge_round(hash, v4);
+    } else {
+        hash = seed + prime5;
+    }
+    hash += data.size();
+
+    for (; end - p >= 8; p += 8) {
+        hash ^= stripe_round(0, read64(p));
+        hash = std::rotl(hash, 27) * prime1 + prime4;
+    }
+    if (end - p >= 4) {
+        hash ^= read32(p) * prime1;
+        hash = std::rotl(hash, 23) * prime2 + prime3;
+        p += 4;
+    }
+    for (; p != end; ++p) {
+        hash ^= *p * prime5;
+        hash = std::rotl(hash, 11) * prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t frame_hash(const Ppu& ppu)
+{
+    // a field at a time, the padding in the spans isn't anything
+    std::vector<uint8_t> spans;
+    for (const Ppu::EmphasisSpan& span : ppu.emphasis_spans()) {
+        for (size_t byte = 0; byte < sizeof(span.first_pixel); ++byte) {
+            spans.push_back((uint8_t)(span.first_pixel >> (byte * 8)));
+        }
+        spans.push_back(span.emphasis);
+    }
+    return xxhash64(ppu.frame(), xxhash64(spans));
+}
+
+uint64_t ram_hash(const Memory& memory)
+{
+    return xxhash64(memory.m_InternalRam);
+}
+
+std::optional<InputScript> InputScript::parse(std::string_view text)
+{
+    InputScript script;
+    size_t line_number = 1;
+    for (; !text.empty(); ++line_number) {
+        const size_t line_end = std::min(text.find('\n'), text.size());
+        std::string_view line = text.substr(0, line_end);
+        text.remove_prefix(std::min(line_end + 1, text.size()));
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+        const std::string_view frame_field = next_field(line);
+        if (frame_field.empty() || frame_field.front() == '#') continue;
+
+        Change change = {};
+        const auto [frame_end, error] =
+            std::from_chars(frame_field.data(), frame_field.data() + frame_field.size(), change.frame);
+        bool valid = error == std::errc() && frame_end == frame_field.data() + frame_field.size() && change.frame > 0;
+        valid      = valid && (script.m_Changes.empty() || script.m_Changes.back().frame < change.frame);
+        for (size_t port = 0; valid && port < change.buttons.size(); ++port) {
+            const std::string_view field = next_field(line);
+            if (field.empty() && port > 0) break;
+            const std::optional<uint8_t> buttons = parse_buttons(field);
+            valid                                = buttons.has_value();
+            change.buttons[port]                 = buttons.value_or(0);
+        }
+        if (!valid || !next_field(line).empty()) {
+            info_message("input line {}: expected <frame> <RLDUTSBA> [<RLDUTSBA>] after the previous frame",
+                         line_number);
+            return std::nullopt;
+        }
+        script.m_Changes.push_back(change);
+    }
+    return script;
+}
+
+std::optional<InputScript> InputScript::from_file(const char* file_name)
+{
+    FILE* file = fopen(file_name, "r");
+    if (!file) {
+        info_message("fopen failed: {}", strerror(errno));
+        return std::nullopt;
+    }
+
+    std::string text;
+    char buffer[4096];
+    size_t read = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, read);
+    }
+    fclose(file);
+    return parse(text);
+}
+
+std::array<uint8_t, 2> InputScript::buttons(uint64_t frame) const
+{
+    const auto after = std::upper_bound(m_Changes.begin(), m_Changes.end(), frame, [](uint64_t f, const Change& c) {
+        return f < c.frame;
+    });
+    return after == m_Changes.begin() ? std::array<uint8_t, 2>{} : std::prev(after)->buttons;
+}
+
+void run_headless(CPU6502& cpu, const InputScript& input, const HeadlessOptions& options, FILE* out)
+{
+    for (uint64_t frame = 1; frame <= options.frames; ++frame) {
+        const std::array<uint8_t, 2> buttons = input.buttons(frame);
+        cpu.io_registers.set_buttons(0, buttons[0]);
+        cpu.io_registers.set_buttons(1, buttons[1]);
+        cpu.run_frame();
+
+        if (options.frame_hash_interval && frame % options.frame_hash_interval == 0) {
+            fmt::print(out, "frame {} {:016x}\n", frame, frame_hash(cpu.ppu));
+        }
+        if (options.ram_hash_interval && frame % options.ram_hash_interval == 0) {
+            fmt::print(out, "ram {} {:016x}\n", frame, ram_hash(cpu.memory));
+        }
+    }
+}
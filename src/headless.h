@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class CPU6502;
+class Memory;
+class Ppu;
+
+// XXH64, so the hashes can be checked with any other xxHash implementation
+uint64_t xxhash64(std::span<const uint8_t> data, uint64_t seed = 0);
+// The PPU's last frame as it recorded it, the palette entries and each row's emphasis bits
+uint64_t frame_hash(const Ppu& ppu);
+// The console's 2KiB of RAM
+uint64_t ram_hash(const Memory& memory);
+
+// The buttons held on each frame of a headless run, a line for each change:
+//   <frame> <port 0 buttons> [<port 1 buttons>]
+// Frames count from 1 and the buttons are 8 characters in the order RLDUTSBA (T is Start, S is Select), the letter
+// where it's held and anything else where it isn't, so "...T...." is Start. A line's buttons are held from its frame
+// until the next line's. Blank lines and lines starting with # are skipped.
+class InputScript
+{
+public:
+    static std::optional<InputScript> parse(std::string_view text);
+    static std::optional<InputScript> from_file(const char* file_name);
+
+    // the masks of Button for both ports on frame
+    std::array<uint8_t, 2> buttons(uint64_t frame) const;
+
+private:
+    struct Change {
+        uint64_t frame;
+        std::array<uint8_t, 2> buttons;
+    };
+    std::vector<Change> m_Changes; // in frame order
+};
+
+struct HeadlessOptions {
+    uint64_t frames              = 0;
+    uint64_t frame_hash_interval = 1; // 0 for never
+    uint64_t ram_hash_interval   = 0; // 0 for never
+};
+
+// Runs options.frames frames from where cpu is, each up to the start of vblank, with the buttons from input. Writes a
+// line to out for each hash as it's taken, "frame <n> <hash>" and "ram <n> <hash>" after every frame n that's a
+// multiple of the interval, with the hash in hex. Nothing is drawn or played, the only cost on top of running the game
+// is the hashing.
+void run_headless(CPU6502& cpu, const InputScript& input, const HeadlessOptions& options, FILE* out);
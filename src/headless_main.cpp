@@ -0,0 +1,78 @@
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "headless.h"
+#include "log.h"
+
+static std::optional<uint64_t> parse_count(std::string_view text)
+{
+    uint64_t value                = 0;
+    const auto [end, error]       = std::from_chars(text.data(), text.data() + text.size(), value);
+    const bool consumed_all_input = error == std::errc() && end == text.data() + text.size();
+    return consumed_all_input ? std::optional<uint64_t>(value) : std::nullopt;
+}
+
+// Runs a rom for a number of frames with no window or audio and prints hashes of the frames and of RAM, so runs can
+// be compared against known good ones. Built without SDL so it runs anywhere the tests do.
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fmt::print("usage: <program_name> <path_to_rom> <frames> [--input <input_file>] [--frame-hash-every <n>] "
+                   "[--ram-hash-every <n>] [--jit]");
+        return -1;
+    }
+
+    HeadlessOptions options;
+    const std::optional<uint64_t> frames = parse_count(argv[2]);
+    if (!frames.has_value()) {
+        info_message("bad frame count: {}", argv[2]);
+        return -1;
+    }
+    options.frames = *frames;
+
+    InputScript input;
+    bool use_recompiler = false;
+    for (int i = 3; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--jit") {
+            use_recompiler = true;
+        } else if (arg == "--input" && i + 1 < argc) {
+            std::optional<InputScript> script = InputScript::from_file(argv[++i]);
+            if (!script.has_value()) return EXIT_FAILURE;
+            input = std::move(*script);
+        } else if ((arg == "--frame-hash-every" || arg == "--ram-hash-every") && i + 1 < argc) {
+            const std::optional<uint64_t> interval = parse_count(argv[++i]);
+            if (!interval.has_value()) {
+                info_message("bad interval: {}", argv[i]);
+                return -1;
+            }
+            (arg == "--frame-hash-every" ? options.frame_hash_interval : options.ram_hash_interval) = *interval;
+        } else {
+            info_message("unknown argument: {}", arg);
+            return -1;
+        }
+    }
+
+    std::optional<Cartridge> cart = Cartridge::from_file(argv[1]);
+    if (!cart.has_value()) {
+        info_message("failed to load cart");
+        return EXIT_FAILURE;
+    }
+
+    CPU6502 cpu;
+    cpu.use_recompiler = use_recompiler;
+    if (!cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*cart)))) {
+        info_message("failed to load cart");
+        return EXIT_FAILURE;
+    }
+    cpu.reset();
+
+    run_headless(cpu, input, options, stdout);
+}
@@ -0,0 +1,51 @@
+#include "io_registers.h"
+
+#include "cpu.h"
+
+IoRegisters::IoRegisters(CPU6502& cpu) : m_Cpu(cpu)
+{
+    m_Cpu.memory.map_io(0x40, 1, this);
+}
+
+// A controller read gives the next button in bit 0, the rest is open bus which is usually the $40 of the address.
+// Once all eight buttons are out an official controller keeps giving 1s.
+uint8_t IoRegisters::io_read(uint16_t addr)
+{
+    if (addr == 0x4016 || addr == 0x4017) {
+        const size_t port = addr & 1;
+        if (m_Strobe) m_Shift[port] = m_Buttons[port];
+        const uint8_t bit = m_Shift[port] & 1;
+        if (!m_Strobe) m_Shift[port] = (uint8_t)((m_Shift[port] >> 1) | 0x80);
+        return 0x40 | bit;
+    }
+
+    const uint8_t* byte = m_Cpu.memory.default_io_byte(addr);
+    return byte ? *byte : 0;
+}
+
+// Reading a controller moves it on to the next button
+bool IoRegisters::io_read_repeatable(uint16_t addr) const
+{
+    return addr != 0x4016 && addr != 0x4017;
+}
+
+// The copy takes 513 cycles, plus one to line up with a read cycle when it starts on an odd one
+void IoRegisters::io_write(uint16_t addr, uint8_t data)
+{
+    if (addr != 0x4014) {
+        if (addr == 0x4016) {
+            // both controllers keep loading their buttons while the strobe is high
+            m_Strobe = data & 1;
+            if (m_Strobe) m_Shift = m_Buttons;
+        }
+        if (uint8_t* byte = m_Cpu.memory.default_io_byte(addr)) *byte = data;
+        return;
+    }
+
+    m_Cpu.ppu.catch_up();
+    const uint16_t page = (uint16_t)(data << 8);
+    for (uint16_t i = 0; i < 0x100; ++i) {
+        m_Cpu.ppu.write_oam_data(m_Cpu.memory.read_byte(page | i));
+    }
+    m_Cpu.cycle_count += 513 + (m_Cpu.cycle_count & 1);
+}
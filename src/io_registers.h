@@ -0,0 +1,50 @@
+#pragma once
+
+#include "memory.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class CPU6502;
+
+// Standard controller buttons, in the order the controller shifts them out
+enum class Button : uint8_t {
+    A      = (1 << 0),
+    B      = (1 << 1),
+    Select = (1 << 2),
+    Start  = (1 << 3),
+    Up     = (1 << 4),
+    Down   = (1 << 5),
+    Left   = (1 << 6),
+    Right  = (1 << 7)
+};
+
+// The 2A03's own registers at $4000-$40FF that do something: $4014 copies a page of CPU memory to OAM through
+// OAMDATA, stalling the CPU while it does, and $4016/$4017 read a standard controller in each port. The rest keep the
+// plain register bytes Memory gives them.
+class IoRegisters : public IoHandler
+{
+public:
+    // Maps itself into cpu's memory
+    explicit IoRegisters(CPU6502& cpu);
+    IoRegisters(const IoRegisters&)            = delete;
+    IoRegisters& operator=(const IoRegisters&) = delete;
+
+    uint8_t io_read(uint16_t addr) override;
+    void io_write(uint16_t addr, uint8_t data) override;
+    bool io_read_repeatable(uint16_t addr) const override;
+
+    // The buttons held on the controller in port (0 or 1), a mask of Button. The game sees them the next time it
+    // strobes the controllers.
+    void set_buttons(size_t port, uint8_t buttons) { m_Buttons[port] = buttons; }
+    uint8_t buttons(size_t port) const { return m_Buttons[port]; }
+
+private:
+    CPU6502& m_Cpu;
+
+    std::array<uint8_t, 2> m_Buttons = {};
+    // what's left to shift out of each controller, refilled from m_Buttons while the strobe is high
+    std::array<uint8_t, 2> m_Shift = {};
+    bool m_Strobe                  = false;
+};
@@ -1,18 +1,43 @@
 #include <SDL2/SDL.h>
 #include <cstdlib>
+#include <memory>
 #include <optional>
+#include <string_view>
+#include <utility>
 
 #include "cartridge.h"
 #include "cpu.h"
 #include "log.h"
+#include "trace.h"
 
 int main(int argc, char* argv[])
 {
     if (argc < 2) {
-        fmt::print("usage: <program_name> <path_to_rom>");
+        fmt::print("usage: <program_name> <path_to_rom> [--verbose] [--trace <trace_file>] [--jit] [--profile]");
         return -1;
     }
 
+    bool verbose_log                    = false;
+    bool use_recompiler                 = false;
+    std::unique_ptr<TraceWriter> tracer = nullptr;
+    std::unique_ptr<Profiler> profiler  = nullptr;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--verbose") {
+            verbose_log = true;
+        } else if (arg == "--jit") {
+            use_recompiler = true;
+        } else if (arg == "--profile") {
+            profiler = std::make_unique<Profiler>();
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracer = TraceWriter::open(argv[++i]);
+            if (!tracer) return EXIT_FAILURE;
+        } else {
+            info_message("unknown argument: {}", arg);
+            return -1;
+        }
+    }
+
     std::optional<Cartridge> cart = Cartridge::from_file(argv[1]);
     if (!cart.has_value()) {
         info_message("failed to load cart");
@@ -20,13 +45,18 @@ int main(int argc, char* argv[])
     }
 
     CPU6502 cpu;
-    cpu.verbose_log = true;
-    cpu.load_prg_rom(cart->get_program_data());
+    cpu.verbose_log    = verbose_log;
+    cpu.tracer         = tracer.get();
+    cpu.use_recompiler = use_recompiler;
+    cpu.profiler       = profiler.get();
+    if (!cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*cart)))) {
+        info_message("failed to load cart");
+        return EXIT_FAILURE;
+    }
     cpu.reset();
 
-    for (size_t i = 0; i < 10000; ++i) {
-        cpu.next_cycle();
-    }
+    cpu.run_for_cycles(10000);
+    if (profiler) fmt::print("{}", profiler->report(40));
 
 #if 0
     SDL_Init(SDL_INIT_VIDEO);
@@ -0,0 +1,334 @@
+#include "mapper.h"
+
+#include "log.h"
+#include "ppu.h"
+
+#include <utility>
+
+namespace
+{
+
+// Mapper 0: 16 or 32KiB of fixed PRG and 8KiB of fixed CHR
+class Nrom : public Mapper
+{
+public:
+    explicit Nrom(std::shared_ptr<const Cartridge> cart) : Mapper(std::move(cart))
+    {
+        map_prg_32k(0);
+        map_chr_8k(0);
+    }
+
+protected:
+    void write_register(uint16_t, uint8_t) override {}
+};
+
+// Mapper 1: registers are loaded a bit at a time through a serial shift register
+class Mmc1 : public Mapper
+{
+public:
+    explicit Mmc1(std::shared_ptr<const Cartridge> cart) : Mapper(std::move(cart)) { update_banks(); }
+
+protected:
+    void write_register(uint16_t addr, uint8_t data) override
+    {
+        if (data & 0x80) {
+            m_Shift = 0x10;
+            m_Control |= 0x0C;
+            update_banks();
+            return;
+        }
+
+        // the shift register is full once the marker bit it was reset with reaches bit 0
+        const bool complete = m_Shift & 1;
+        m_Shift             = (uint8_t)((m_Shift >> 1) | ((data & 1) << 4));
+        if (!complete) return;
+
+        switch ((addr >> 13) & 3) {
+            case 0: m_Control = m_Shift; break;
+            case 1: m_ChrBank0 = m_Shift; break;
+            case 2: m_ChrBank1 = m_Shift; break;
+            case 3: m_PrgBank = m_Shift; break;
+        }
+        m_Shift = 0x10;
+        update_banks();
+    }
+
+private:
+    void update_banks()
+    {
+        switch (m_Control & 3) {
+            case 0: set_mirroring(Mirroring::SingleScreenLow); break;
+            case 1: set_mirroring(Mirroring::SingleScreenHigh); break;
+            case 2: set_mirroring(Mirroring::Vertical); break;
+            case 3: set_mirroring(Mirroring::Horizontal); break;
+        }
+
+        // boards with 512KiB of PRG (SUROM) use the top CHR bank bit to pick which 256KiB half is in use
+        const size_t prg_outer = prg_bank_count_8k() > 32 ? (m_ChrBank0 & 0x10) : 0;
+        const size_t prg_bank  = prg_outer | (m_PrgBank & 0x0F);
+        switch ((m_Control >> 2) & 3) {
+            case 0:
+            case 1: map_prg_32k(prg_bank >> 1); break;
+            case 2:
+                map_prg_16k(0, prg_outer);
+                map_prg_16k(1, prg_bank);
+                break;
+            case 3:
+                map_prg_16k(0, prg_bank);
+                map_prg_16k(1, prg_outer | 0x0F);
+                break;
+        }
+
+        if (m_Control & 0x10) {
+            map_chr_4k(0, m_ChrBank0);
+            map_chr_4k(1, m_ChrBank1);
+        } else {
+            map_chr_8k(m_ChrBank0 >> 1);
+        }
+    }
+
+    uint8_t m_Shift    = 0x10;
+    uint8_t m_Control  = 0x0C;
+    uint8_t m_ChrBank0 = 0;
+    uint8_t m_ChrBank1 = 0;
+    uint8_t m_PrgBank  = 0;
+};
+
+// Mapper 2: switchable 16KiB PRG bank at $8000, the last bank is fixed at $C000
+class UxRom : public Mapper
+{
+public:
+    explicit UxRom(std::shared_ptr<const Cartridge> cart) : Mapper(std::move(cart))
+    {
+        map_prg_16k(0, 0);
+        map_prg_16k(1, prg_bank_count_8k() / 2 - 1);
+        map_chr_8k(0);
+    }
+
+protected:
+    void write_register(uint16_t, uint8_t data) override { map_prg_16k(0, data); }
+};
+
+// Mapper 3: fixed PRG with a switchable 8KiB CHR bank
+class CnRom : public Mapper
+{
+public:
+    explicit CnRom(std::shared_ptr<const Cartridge> cart) : Mapper(std::move(cart))
+    {
+        map_prg_32k(0);
+        map_chr_8k(0);
+    }
+
+protected:
+    void write_register(uint16_t, uint8_t data) override { map_chr_8k(data); }
+};
+
+// Mapper 4: 8KiB PRG and 1/2KiB CHR banks plus a scanline counter that raises an IRQ
+class Mmc3 : public Mapper
+{
+public:
+    explicit Mmc3(std::shared_ptr<const Cartridge> cart) : Mapper(std::move(cart)) { update_banks(); }
+
+    bool counts_scanlines() const override { return true; }
+    void clock_scanline() override
+    {
+        if (m_IrqCounter == 0 || m_IrqReload) {
+            m_IrqCounter = m_IrqLatch;
+            m_IrqReload  = false;
+        } else {
+            m_IrqCounter--;
+        }
+
+        if (m_IrqCounter == 0 && m_IrqEnabled) {
+            m_IrqAsserted = true;
+        }
+    }
+
+protected:
+    void write_register(uint16_t addr, uint8_t data) override
+    {
+        const bool even = (addr & 1) == 0;
+        switch (addr & 0xE000) {
+            case 0x8000:
+                if (even) {
+                    m_BankSelect = data;
+                } else {
+                    m_Registers[m_BankSelect & 7] = data;
+                }
+                update_banks();
+                break;
+            case 0xA000:
+                // odd addresses are PRG-RAM protect which isn't emulated
+                if (even && mirroring() != Mirroring::FourScreen) {
+                    set_mirroring((data & 1) ? Mirroring::Horizontal : Mirroring::Vertical);
+                }
+                break;
+            case 0xC000:
+                if (even) {
+                    m_IrqLatch = data;
+                } else {
+                    m_IrqCounter = 0;
+                    m_IrqReload  = true;
+                }
+                break;
+            case 0xE000:
+                if (even) {
+                    m_IrqEnabled  = false;
+                    m_IrqAsserted = false;
+                } else {
+                    m_IrqEnabled = true;
+                }
+                break;
+        }
+    }
+
+private:
+    void update_banks()
+    {
+        const size_t second_last_bank = prg_bank_count_8k() - 2;
+        if (m_BankSelect & 0x40) {
+            map_prg_8k(0, second_last_bank);
+            map_prg_8k(2, m_Registers[6]);
+        } else {
+            map_prg_8k(0, m_Registers[6]);
+            map_prg_8k(2, second_last_bank);
+        }
+        map_prg_8k(1, m_Registers[7]);
+        map_prg_8k(3, prg_bank_count_8k() - 1);
+
+        // the two 2KiB banks and four 1KiB banks swap halves of the pattern tables when bit 7 is set
+        const size_t inversion = (m_BankSelect & 0x80) ? 4 : 0;
+        map_chr_1k(0 ^ inversion, m_Registers[0] & 0xFE);
+        map_chr_1k(1 ^ inversion, m_Registers[0] | 1);
+        map_chr_1k(2 ^ inversion, m_Registers[1] & 0xFE);
+        map_chr_1k(3 ^ inversion, m_Registers[1] | 1);
+        map_chr_1k(4 ^ inversion, m_Registers[2]);
+        map_chr_1k(5 ^ inversion, m_Registers[3]);
+        map_chr_1k(6 ^ inversion, m_Registers[4]);
+        map_chr_1k(7 ^ inversion, m_Registers[5]);
+    }
+
+    uint8_t m_BankSelect               = 0;
+    std::array<uint8_t, 8> m_Registers = { 0, 2, 4, 5, 6, 7, 0, 1 };
+    uint8_t m_IrqLatch                 = 0;
+    uint8_t m_IrqCounter               = 0;
+    bool m_IrqReload                   = false;
+    bool m_IrqEnabled                  = false;
+};
+
+} // namespace
+
+std::unique_ptr<Mapper> Mapper::create(std::shared_ptr<const Cartridge> cart)
+{
+    if (cart->get_program_data().size() < 0x4000) {
+        info_message("cartridge has no program data");
+        return nullptr;
+    }
+
+    const uint8_t mapper_number = cart->get_mapper_number();
+    switch (mapper_number) {
+        case 0: return std::make_unique<Nrom>(std::move(cart));
+        case 1: return std::make_unique<Mmc1>(std::move(cart));
+        case 2: return std::make_unique<UxRom>(std::move(cart));
+        case 3: return std::make_unique<CnRom>(std::move(cart));
+        case 4: return std::make_unique<Mmc3>(std::move(cart));
+    }
+
+    info_message("mapper {} is not supported", mapper_number);
+    return nullptr;
+}
+
+Mapper::Mapper(std::shared_ptr<const Cartridge> cart)
+    : m_Cartridge(std::move(cart)),
+      m_Mirroring(m_Cartridge->get_mirroring()),
+      m_Prg(m_Cartridge->get_program_data()),
+      m_Chr(m_Cartridge->get_video_data())
+{
+    if (m_Chr.empty()) {
+        m_ChrRam.resize(0x2000);
+        m_Chr = m_ChrRam;
+    }
+}
+
+void Mapper::attach(Memory& memory, Ppu* ppu)
+{
+    m_Memory = &memory;
+    m_Ppu    = ppu;
+
+    // $4100-$5FFF is open bus, $6000-$7FFF is PRG-RAM and writes to $8000-$FFFF are register writes
+    memory.map_io(0x41, 0xBF, this);
+    memory.map_read(0x41, 0x1F, nullptr);
+    memory.map_write(0x41, 0x1F, nullptr);
+    memory.map_read(0x60, 0x20, m_PrgRam.data());
+    memory.map_write(0x60, 0x20, m_PrgRam.data());
+    memory.map_write(0x80, 0x80, nullptr);
+    for (size_t slot = 0; slot < m_PrgSlots.size(); ++slot) {
+        memory.map_read((uint8_t)(0x80 + slot * 0x20), 0x20, m_PrgSlots[slot]);
+    }
+}
+
+uint8_t Mapper::io_read(uint16_t)
+{
+    return 0;
+}
+
+void Mapper::io_write(uint16_t addr, uint8_t data)
+{
+    if (addr >= 0x8000) {
+        if (m_Ppu) m_Ppu->catch_up();
+        write_register(addr, data);
+    }
+}
+
+void Mapper::map_prg_8k(size_t slot, size_t bank)
+{
+    m_PrgSlots[slot] = m_Prg.data() + (bank % prg_bank_count_8k()) * 0x2000;
+    if (m_Memory) {
+        m_Memory->map_read((uint8_t)(0x80 + slot * 0x20), 0x20, m_PrgSlots[slot]);
+    }
+}
+
+void Mapper::map_prg_16k(size_t slot, size_t bank)
+{
+    map_prg_8k(slot * 2, bank * 2);
+    map_prg_8k(slot * 2 + 1, bank * 2 + 1);
+}
+
+void Mapper::map_prg_32k(size_t bank)
+{
+    map_prg_16k(0, bank * 2);
+    map_prg_16k(1, bank * 2 + 1);
+}
+
+void Mapper::map_chr_1k(size_t slot, size_t bank)
+{
+    const size_t offset = (bank % chr_bank_count_1k()) * 0x400;
+    if (m_ChrPages[slot] != m_Chr.data() + offset) {
+        m_ChrPages[slot] = m_Chr.data() + offset;
+        m_TileCache.invalidate(slot * 64, 64);
+    }
+    if (!m_ChrRam.empty()) {
+        m_ChrWritePages[slot] = m_ChrRam.data() + offset;
+    }
+}
+
+// The same 1KiB of CHR-RAM can be mapped into more than one slot
+void Mapper::chr_ram_written(const uint8_t* page, uint16_t addr)
+{
+    for (size_t slot = 0; slot < m_ChrWritePages.size(); ++slot) {
+        if (m_ChrWritePages[slot] == page) m_TileCache.invalidate(slot * 64 + ((addr & 0x3FF) >> 4));
+    }
+}
+
+void Mapper::map_chr_4k(size_t slot, size_t bank)
+{
+    for (size_t i = 0; i < 4; ++i) {
+        map_chr_1k(slot * 4 + i, bank * 4 + i);
+    }
+}
+
+void Mapper::map_chr_8k(size_t bank)
+{
+    map_chr_4k(0, bank * 2);
+    map_chr_4k(1, bank * 2 + 1);
+}
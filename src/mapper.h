@@ -0,0 +1,96 @@
+#pragma once
+
+#include "cartridge.h"
+#include "memory.h"
+#include "tile_cache.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+class Ppu;
+
+// A mapper owns the cartridge's view of PRG and CHR and switches banks by repointing pages in the CPU memory map
+// (and its own 1KiB CHR page table) rather than copying bank data around. It sits behind $4100-$5FFF and the
+// $8000-$FFFF write pages to receive register writes, while $6000-$7FFF is mapped straight to PRG-RAM.
+// The cartridge is immutable and shared, so any number of mappers (one per emulated console) can point into the same
+// ROM image and only the RAM and register state is per instance.
+class Mapper : public IoHandler
+{
+public:
+    static std::unique_ptr<Mapper> create(std::shared_ptr<const Cartridge> cart);
+
+    explicit Mapper(std::shared_ptr<const Cartridge> cart);
+
+    // The PPU (if there is one) is brought up to date before a register write so a bank switch part way through a
+    // frame only changes what's drawn after it
+    void attach(Memory& memory, Ppu* ppu = nullptr);
+
+    uint8_t chr_read(uint16_t addr) const { return m_ChrPages[(addr >> 10) & 7][addr & 0x3FF]; }
+    void chr_write(uint16_t addr, uint8_t data)
+    {
+        if (uint8_t* page = m_ChrWritePages[(addr >> 10) & 7]) {
+            page[addr & 0x3FF] = data;
+            chr_ram_written(page, addr);
+        }
+    }
+    // Row addr & 7 of the tile at addr, a byte per pixel, see TileCache
+    uint64_t chr_row(uint16_t addr)
+    {
+        const size_t tile = (addr >> 4) & 0x1FF;
+        return m_TileCache.rows(tile, m_ChrPages[tile >> 6] + (tile & 63) * 16)[addr & 7];
+    }
+    Mirroring mirroring() const { return m_Mirroring; }
+
+    // Called by the PPU once per rendered scanline when counts_scanlines() says the mapper cares, which only MMC3 does
+    virtual bool counts_scanlines() const { return false; }
+    virtual void clock_scanline() {}
+    bool irq_asserted() const { return m_IrqAsserted; }
+
+    // Which 8KiB bank of PRG-ROM is mapped at addr, which has to be in $8000-$FFFF
+    size_t prg_bank_8k_at(uint16_t addr) const
+    {
+        return (size_t)(m_PrgSlots[(addr >> 13) & 3] - m_Prg.data()) / 0x2000;
+    }
+
+    uint8_t io_read(uint16_t addr) override;
+    void io_write(uint16_t addr, uint8_t data) override;
+    bool io_read_repeatable(uint16_t) const override { return true; }
+
+protected:
+    virtual void write_register(uint16_t addr, uint8_t data) = 0;
+
+    size_t prg_bank_count_8k() const { return m_Prg.size() / 0x2000; }
+    size_t chr_bank_count_1k() const { return m_Chr.size() / 0x400; }
+
+    // slot is which 8KiB (PRG, $8000 + slot * $2000) or 1KiB (CHR, slot * $400) window to map
+    void map_prg_8k(size_t slot, size_t bank);
+    void map_prg_16k(size_t slot, size_t bank);
+    void map_prg_32k(size_t bank);
+    void map_chr_1k(size_t slot, size_t bank);
+    void map_chr_4k(size_t slot, size_t bank);
+    void map_chr_8k(size_t bank);
+    void set_mirroring(Mirroring new_mirroring) { m_Mirroring = new_mirroring; }
+
+    bool m_IrqAsserted = false;
+
+private:
+    void chr_ram_written(const uint8_t* page, uint16_t addr);
+
+    std::shared_ptr<const Cartridge> m_Cartridge;
+    Memory* m_Memory = nullptr;
+    Ppu* m_Ppu       = nullptr;
+    Mirroring m_Mirroring;
+
+    std::span<const uint8_t> m_Prg;
+    std::array<const uint8_t*, 4> m_PrgSlots = {};
+    std::array<uint8_t, 0x2000> m_PrgRam     = {};
+
+    std::span<const uint8_t> m_Chr;
+    std::vector<uint8_t> m_ChrRam; // used instead of CHR-ROM when the cartridge has none
+    std::array<const uint8_t*, 8> m_ChrPages = {};
+    std::array<uint8_t*, 8> m_ChrWritePages  = {};
+    TileCache m_TileCache; // decoded from whatever m_ChrPages points at
+};
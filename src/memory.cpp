@@ -1,41 +1,146 @@
 #include "memory.h"
 
-#include "log.h"
+#include <cstring>
 
-uint8_t& Memory::access_byte(uint16_t addr)
+Memory::Memory()
+{
+    // 2KiB of internal RAM mirrored up to $2000
+    map_read(0x00, 0x08, m_InternalRam.data());
+    map_write(0x00, 0x08, m_InternalRam.data());
+    mirror_pages(0x08, 0x08, 0x00);
+    mirror_pages(0x10, 0x10, 0x00);
+
+    // $2000-$40FF are registers and everything above is cartridge space, all of which starts out unmapped
+}
+
+void Memory::map_open_cartridge_space()
+{
+    m_OpenCartridgeSpace = std::make_unique<uint8_t[]>(0xBF00);
+    for (size_t page = 0x41; page <= 0xFF; ++page) {
+        if (m_IoHandlers[page] || m_ReadPages[page] || m_WritePages[page]) continue;
+
+        uint8_t* data      = m_OpenCartridgeSpace.get() + (page - 0x41) * 0x100;
+        m_ReadPages[page]  = data;
+        m_WritePages[page] = data;
+    }
+    pages_remapped(0x41, 0xBF);
+}
+
+void Memory::pages_remapped(uint8_t first_page, size_t page_count)
+{
+    if (m_Watcher) m_Watcher->pages_remapped(first_page, page_count);
+}
+
+void Memory::map_read(uint8_t first_page, size_t page_count, const uint8_t* data)
+{
+    for (size_t i = 0; i < page_count; ++i) {
+        m_ReadPages[first_page + i] = data ? data + i * 0x100 : nullptr;
+    }
+    pages_remapped(first_page, page_count);
+}
+
+void Memory::map_write(uint8_t first_page, size_t page_count, uint8_t* data)
+{
+    for (size_t i = 0; i < page_count; ++i) {
+        m_WritePages[first_page + i]   = data ? data + i * 0x100 : nullptr;
+        m_WatchedPages[first_page + i] = nullptr;
+    }
+    pages_remapped(first_page, page_count);
+}
+
+void Memory::map_io(uint8_t first_page, size_t page_count, IoHandler* handler)
+{
+    for (size_t i = 0; i < page_count; ++i) {
+        m_IoHandlers[first_page + i] = handler;
+    }
+    pages_remapped(first_page, page_count);
+}
+
+void Memory::mirror_pages(uint8_t first_page, size_t page_count, uint8_t source_page)
+{
+    for (size_t i = 0; i < page_count; ++i) {
+        m_ReadPages[first_page + i]    = m_ReadPages[source_page + i];
+        m_WritePages[first_page + i]   = m_WritePages[source_page + i];
+        m_WatchedPages[first_page + i] = m_WatchedPages[source_page + i];
+        m_IoHandlers[first_page + i]   = m_IoHandlers[source_page + i];
+    }
+    pages_remapped(first_page, page_count);
+}
+
+void Memory::watch_writes(uint8_t page)
+{
+    if (!m_WritePages[page]) return;
+    m_WatchedPages[page] = m_WritePages[page];
+    m_WritePages[page]   = nullptr;
+}
+
+void Memory::unwatch_writes(uint8_t page)
+{
+    if (!m_WatchedPages[page]) return;
+    m_WritePages[page]   = m_WatchedPages[page];
+    m_WatchedPages[page] = nullptr;
+}
+
+// With no handler installed the registers are plain bytes and writes to unmapped cartridge space are dropped
+uint8_t* Memory::default_io_byte(uint16_t addr)
 {
     if (addr < 0x2000) {
-        return m_InternalRam[addr % 0x800];
-    } else if (addr < 0x4008) {
-        return m_PpuRegisters[(addr - 0x2000) % 0x08];
+        return nullptr;
+    } else if (addr < 0x4000) {
+        return &m_PpuRegisters[(addr - 0x2000) % 0x08];
     } else if (addr < 0x4018) {
-        return m_ApuIoRegisters[addr - 0x4000];
+        return &m_ApuIoRegisters[addr - 0x4000];
     } else if (addr < 0x4020) {
-        return m_ApuIoExtended[addr - 0x4018];
+        return &m_ApuIoExtended[addr - 0x4018];
+    } else if (addr < 0x4100) {
+        return &m_CartridgeExpansion[addr - 0x4020];
     }
 
-    return m_Rom[addr - 0x4020];
+    return nullptr;
 }
 
-const uint8_t& Memory::access_byte(uint16_t addr) const
+bool Memory::read_repeatable(uint16_t addr) const
 {
-    return const_cast<Memory*>(this)->access_byte(addr);
+    if (m_ReadPages[addr >> 8]) return true;
+    if (const IoHandler* handler = m_IoHandlers[addr >> 8]) return handler->io_read_repeatable(addr);
+    return true;
 }
 
-uint8_t Memory::read_byte(uint16_t addr) const
+uint8_t Memory::read_io(uint16_t addr) const
 {
-    return access_byte(addr);
+    if (IoHandler* handler = m_IoHandlers[addr >> 8]) {
+        return handler->io_read(addr);
+    }
+
+    const uint8_t* byte = const_cast<Memory*>(this)->default_io_byte(addr);
+    return byte ? *byte : 0;
 }
 
-void Memory::write_byte(uint16_t addr, uint8_t data)
+void Memory::write_io(uint16_t addr, uint8_t data)
 {
-    access_byte(addr) = data;
+    if (uint8_t* page = m_WatchedPages[addr >> 8]) [[unlikely]] {
+        page[addr & 0xFF] = data;
+        m_Watcher->watched_write(page);
+        return;
+    }
+
+    if (IoHandler* handler = m_IoHandlers[addr >> 8]) {
+        handler->io_write(addr, data);
+        return;
+    }
+
+    if (uint8_t* byte = default_io_byte(addr)) {
+        *byte = data;
+    } else if (addr >= 0x4100 && !m_OpenCartridgeSpace && !m_ReadPages[addr >> 8]) {
+        map_open_cartridge_space();
+        write_byte(addr, data);
+    }
 }
 
 uint16_t Memory::read_word(uint16_t addr) const
 {
-    const uint8_t lo_byte = access_byte(addr);
-    const uint8_t hi_byte = access_byte(addr + 1);
+    const uint8_t lo_byte = read_byte(addr);
+    const uint8_t hi_byte = read_byte(addr + 1);
     return (uint16_t)((hi_byte << 8) | lo_byte);
 }
 
@@ -43,12 +148,18 @@ void Memory::write_word(uint16_t addr, uint16_t data)
 {
     const uint8_t hi_byte = (uint8_t)((data & 0xFF00) >> 8);
     const uint8_t lo_byte = data & 0xFFU;
-    access_byte(addr)     = lo_byte;
-    access_byte(addr + 1) = hi_byte;
+    write_byte(addr, lo_byte);
+    write_byte(addr + 1, hi_byte);
 }
 
 void Memory::write_rom(uint16_t start_addr, std::span<const uint8_t> buf)
 {
-    const uint16_t rom_start_addr = start_addr - 0x4020;
-    memcpy(m_Rom.data() + rom_start_addr, buf.data(), buf.size());
+    if (!m_OpenCartridgeSpace) map_open_cartridge_space();
+    memcpy(m_OpenCartridgeSpace.get() + (start_addr - 0x4100), buf.data(), buf.size());
+
+    // anything decoded from what was there before is out of date
+    if (!m_Watcher || buf.empty()) return;
+    for (size_t page = start_addr >> 8; page <= (start_addr + buf.size() - 1) >> 8; ++page) {
+        m_Watcher->watched_write(m_OpenCartridgeSpace.get() + (page - 0x41) * 0x100);
+    }
 }
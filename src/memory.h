@@ -2,25 +2,115 @@
 
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <span>
 
+// Implemented by anything that sits behind memory mapped registers rather than plain memory
+class IoHandler
+{
+public:
+    virtual ~IoHandler() = default;
+
+    virtual uint8_t io_read(uint16_t addr)             = 0;
+    virtual void io_write(uint16_t addr, uint8_t data) = 0;
+
+    // Whether reading addr again, with nothing written in between, gives the same value and has no further effect,
+    // which lets the CPU skip ahead through loops polling it
+    virtual bool io_read_repeatable(uint16_t) const { return false; }
+};
+
+// Told about changes to memory that code may have been decoded from: a write to a page passed to
+// Memory::watch_writes, or pages being mapped to something else
+class MemoryWatcher
+{
+public:
+    virtual ~MemoryWatcher() = default;
+
+    // backing is the memory the written page is mapped to, which may be shared with other (mirror) pages
+    virtual void watched_write(const uint8_t* backing)                  = 0;
+    virtual void pages_remapped(uint8_t first_page, size_t page_count) = 0;
+};
+
+// The CPU address space is split into 256 byte pages. A page that is backed by plain memory has a pointer to it in
+// the read/write tables so an access is a single indexed load, anything else (a null pointer) goes through the page's
+// IoHandler. Mirrors are free as several pages can point at the same backing memory.
 class Memory
 {
 public:
-    uint8_t read_byte(uint16_t addr) const;
-    void write_byte(uint16_t addr, uint8_t data);
+    Memory();
+    Memory(const Memory&)            = delete;
+    Memory& operator=(const Memory&) = delete;
+
+    uint8_t read_byte(uint16_t addr) const
+    {
+        const uint8_t* page = m_ReadPages[addr >> 8];
+        if (page) return page[addr & 0xFF];
+        return read_io(addr);
+    }
+
+    void write_byte(uint16_t addr, uint8_t data)
+    {
+        uint8_t* page = m_WritePages[addr >> 8];
+        if (page) {
+            page[addr & 0xFF] = data;
+            return;
+        }
+        write_io(addr, data);
+    }
+
+    // reads without going through an IoHandler so it has no side effects, registers read as 0
+    uint8_t peek_byte(uint16_t addr) const
+    {
+        const uint8_t* page = m_ReadPages[addr >> 8];
+        return page ? page[addr & 0xFF] : 0;
+    }
+
+    // true for plain memory and for registers whose IoHandler says so, see IoHandler::io_read_repeatable
+    bool read_repeatable(uint16_t addr) const;
+
     uint16_t read_word(uint16_t addr) const;
     void write_word(uint16_t addr, uint16_t data);
 
     void write_rom(uint16_t start_addr, std::span<const uint8_t> buf);
 
+    // Point page_count pages starting at first_page at consecutive 256 byte pages of data. A null pointer sends
+    // accesses to those pages through the page's IoHandler instead.
+    void map_read(uint8_t first_page, size_t page_count, const uint8_t* data);
+    void map_write(uint8_t first_page, size_t page_count, uint8_t* data);
+    void map_io(uint8_t first_page, size_t page_count, IoHandler* handler);
+    // Makes the pages starting at first_page mirror whatever is mapped at the pages starting at source_page
+    void mirror_pages(uint8_t first_page, size_t page_count, uint8_t source_page);
+
+    const uint8_t* read_page(uint8_t page) const { return m_ReadPages[page]; }
+    uint8_t* write_page(uint8_t page) const { return m_WritePages[page]; }
+
+    // A watched page has its write pointer moved aside so writes take the slow path, which does the write and then
+    // tells the watcher. Mapping the page again stops it being watched.
+    void set_watcher(MemoryWatcher* watcher) { m_Watcher = watcher; }
+    void watch_writes(uint8_t page);
+    void unwatch_writes(uint8_t page);
+    const uint8_t* watched_page(uint8_t page) const { return m_WatchedPages[page]; }
+
     // private:
-    uint8_t& access_byte(uint16_t addr);
-    const uint8_t& access_byte(uint16_t addr) const;
+    uint8_t read_io(uint16_t addr) const;
+    void write_io(uint16_t addr, uint8_t data);
+    uint8_t* default_io_byte(uint16_t addr);
+    void map_open_cartridge_space();
+    void pages_remapped(uint8_t first_page, size_t page_count);
+
+    std::array<const uint8_t*, 0x100> m_ReadPages = {};
+    std::array<uint8_t*, 0x100> m_WritePages     = {};
+    std::array<IoHandler*, 0x100> m_IoHandlers   = {};
+    std::array<uint8_t*, 0x100> m_WatchedPages   = {}; // write pointers of watched pages, null in m_WritePages
+    MemoryWatcher* m_Watcher                     = nullptr;
 
     std::array<uint8_t, 0x800> m_InternalRam   = {};
     std::array<uint8_t, 0x08> m_PpuRegisters   = {};
     std::array<uint8_t, 0x18> m_ApuIoRegisters = {};
     std::array<uint8_t, 0x08> m_ApuIoExtended  = {};
-    std::array<uint8_t, 0xBFE0> m_Rom          = {};
+    std::array<uint8_t, 0xE0> m_CartridgeExpansion = {}; // $4020-$40FF
+
+    // Plain read/write memory for $4100-$FFFF when there's no cartridge, only allocated once something writes there
+    // so CPUs running a cartridge don't carry it around
+    std::unique_ptr<uint8_t[]> m_OpenCartridgeSpace;
 };
@@ -0,0 +1,104 @@
+#include "opcode_pairs.h"
+
+#include "cpu.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+bool can_fuse(OpcodePair pair)
+{
+    const CPU6502::Instruction& first  = CPU6502::instruction(pair.first);
+    const CPU6502::Instruction& second = CPU6502::instruction(pair.second);
+    if (first.operation_fn == &CPU6502::illegal_opcode || second.operation_fn == &CPU6502::illegal_opcode) {
+        return false;
+    }
+
+    constexpr CPU6502::operation_fn_t changes_pc[] = {
+        &CPU6502::bcc, &CPU6502::bcs, &CPU6502::beq, &CPU6502::bne, &CPU6502::bmi, &CPU6502::bpl, &CPU6502::bvc,
+        &CPU6502::bvs, &CPU6502::jmp, &CPU6502::jsr, &CPU6502::rts, &CPU6502::rti, &CPU6502::brk,
+    };
+    return std::find(std::begin(changes_pc), std::end(changes_pc), first.operation_fn) == std::end(changes_pc);
+}
+
+void OpcodePairHistogram::record(uint16_t pc, uint8_t opcode)
+{
+    if (pc == m_NextPc) {
+        m_Counts[m_LastOpcode << 8 | opcode]++;
+        m_Total++;
+    }
+    m_NextPc     = pc + CPU6502::instruction(opcode).bytes;
+    m_LastOpcode = opcode;
+}
+
+std::vector<OpcodePairHistogram::Entry> OpcodePairHistogram::most_frequent(size_t limit) const
+{
+    std::vector<Entry> entries;
+    for (size_t i = 0; i < m_Counts.size(); ++i) {
+        const OpcodePair pair = { (uint8_t)(i >> 8), (uint8_t)i };
+        if (m_Counts[i] && can_fuse(pair)) entries.push_back({ pair, m_Counts[i] });
+    }
+
+    // ties go by opcode so the same histogram always gives the same header
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.count > rhs.count;
+    });
+    if (entries.size() > limit) entries.resize(limit);
+    return entries;
+}
+
+bool count_opcode_pairs(std::shared_ptr<const Cartridge> cart, uint64_t frames, OpcodePairHistogram& histogram)
+{
+    CPU6502 cpu;
+    cpu.pair_histogram = &histogram;
+    if (!cpu.load_cartridge(std::move(cart))) return false;
+    cpu.reset();
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        cpu.run_frame();
+    }
+    return true;
+}
+
+// The name opcodes.h gives the opcode
+static std::string opcode_name(uint8_t opcode)
+{
+    const CPU6502::Instruction& instruction = CPU6502::instruction(opcode);
+    const AddressingMode mode               = instruction.mode;
+    const char* suffix                      = "ACC";
+    if (mode == AddressingMode::Implied) suffix = "IMP";
+    if (mode == AddressingMode::Immediate) suffix = "IMM";
+    if (mode == AddressingMode::ZeroPage) suffix = "ZP";
+    if (mode == AddressingMode::ZeroPageX) suffix = "ZPX";
+    if (mode == AddressingMode::ZeroPageY) suffix = "ZPY";
+    if (mode == AddressingMode::Absolute) suffix = "ABS";
+    if (mode == AddressingMode::AbsoluteX) suffix = "ABSX";
+    if (mode == AddressingMode::AbsoluteY) suffix = "ABSY";
+    if (mode == AddressingMode::IndirectX) suffix = "INDX";
+    if (mode == AddressingMode::IndirectY) suffix = "INDY";
+    if (mode == AddressingMode::Relative) suffix = "REL";
+    if (mode == AddressingMode::Indirect) suffix = "IND";
+    return fmt::format("OPCODE_{}_{}", instruction.name, suffix);
+}
+
+std::string write_fused_pairs_header(std::span<const OpcodePairHistogram::Entry> pairs,
+                                     uint64_t total,
+                                     std::string_view command)
+{
+    std::string out = fmt::format("// Generated by nes-opcode-pairs from {} pairs of instructions, the {} most "
+                                  "frequent that can be fused\n",
+                                  total,
+                                  pairs.size());
+    out += "// (with their share of all the pairs). The block cache runs each as a single superinstruction.\n";
+    out += fmt::format("// Made with: {}\n", command);
+    out += "#pragma once\n\n#include \"opcode_pairs.h\"\n#include \"opcodes.h\"\n\n#include <array>\n\n";
+    out += fmt::format("inline constexpr std::array<OpcodePair, {}> fused_opcode_pairs = {{ {{\n", pairs.size());
+    for (const OpcodePairHistogram::Entry& entry : pairs) {
+        const double share = total ? (double)entry.count * 100.0 / (double)total : 0.0;
+        out += fmt::format("    {{ {}, {} }}, // ({:.2f}%)\n",
+                           opcode_name(entry.pair.first),
+                           opcode_name(entry.pair.second),
+                           share);
+    }
+    out += "} };\n";
+    return out;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Cartridge;
+
+struct OpcodePair
+{
+    uint8_t first;
+    uint8_t second;
+};
+
+// Whether the block cache could run the pair as one superinstruction: both have to be legal and the first has to carry
+// on to the second rather than possibly going somewhere else
+bool can_fuse(OpcodePair pair);
+
+// Counts how often each opcode runs straight after another, which nes-opcode-pairs uses to pick the pairs in
+// fused_pairs.h. The CPU records every instruction it runs into one while pair_histogram is set.
+class OpcodePairHistogram
+{
+public:
+    // A pair is only counted when pc is straight after the last instruction recorded, so a jump or a taken branch
+    // doesn't count as being followed by wherever it went
+    void record(uint16_t pc, uint8_t opcode);
+
+    uint64_t count(OpcodePair pair) const { return m_Counts[pair.first << 8 | pair.second]; }
+    uint64_t total() const { return m_Total; }
+
+    struct Entry
+    {
+        OpcodePair pair;
+        uint64_t count;
+    };
+    // Up to limit of the pairs that can be fused, most frequent first
+    std::vector<Entry> most_frequent(size_t limit) const;
+
+private:
+    std::array<uint64_t, 0x10000> m_Counts = {};
+    uint64_t m_Total     = 0;
+    uint32_t m_NextPc    = 0x10000; // never matches a pc, nothing's been recorded yet
+    uint8_t m_LastOpcode = 0;
+};
+
+// Runs cart from reset for frames frames, counting its pairs into histogram. False if the cartridge can't be loaded.
+bool count_opcode_pairs(std::shared_ptr<const Cartridge> cart, uint64_t frames, OpcodePairHistogram& histogram);
+
+// The contents of fused_pairs.h for the given pairs, with command (how to make it again) in the comment at the top
+std::string write_fused_pairs_header(std::span<const OpcodePairHistogram::Entry> pairs,
+                                     uint64_t total,
+                                     std::string_view command);
@@ -0,0 +1,86 @@
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "log.h"
+#include "opcode_pairs.h"
+
+// Runs each rom for a while counting which opcodes follow which, then writes the most frequent pairs that can be
+// fused out as a new fused_pairs.h
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fmt::print("usage: <program_name> <output_header> <path_to_rom>... [--frames <n>] [--pairs <n>]");
+        return -1;
+    }
+
+    uint64_t frames = 3600;
+    size_t pair_count = 32;
+    std::vector<const char*> roms;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if ((arg == "--frames" || arg == "--pairs") && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            uint64_t number              = 0;
+            const auto result            = std::from_chars(value.data(), value.data() + value.size(), number);
+            if (result.ec != std::errc() || result.ptr != value.data() + value.size()) {
+                info_message("{} isn't a number", value);
+                return -1;
+            }
+            if (arg == "--frames") frames = number;
+            if (arg == "--pairs") pair_count = number;
+        } else {
+            roms.push_back(argv[i]);
+        }
+    }
+
+    auto histogram = std::make_unique<OpcodePairHistogram>();
+    for (const char* rom : roms) {
+        std::optional<Cartridge> cart = Cartridge::from_file(rom);
+        if (!cart.has_value() ||
+            !count_opcode_pairs(std::make_shared<const Cartridge>(std::move(*cart)), frames, *histogram)) {
+            info_message("failed to load {}", rom);
+            return EXIT_FAILURE;
+        }
+    }
+
+    const std::vector<OpcodePairHistogram::Entry> pairs = histogram->most_frequent(pair_count);
+    for (const OpcodePairHistogram::Entry& entry : pairs) {
+        fmt::print("{} {:02X} {} {:02X} {}\n",
+                   CPU6502::instruction(entry.pair.first).name,
+                   entry.pair.first,
+                   CPU6502::instruction(entry.pair.second).name,
+                   entry.pair.second,
+                   entry.count);
+    }
+
+    // Written into the header with just the file names, so it comes out the same wherever the roms are kept
+    std::string command = fmt::format("nes-opcode-pairs {}", std::filesystem::path(argv[1]).filename().string());
+    for (const char* rom : roms) {
+        command += fmt::format(" {}", std::filesystem::path(rom).filename().string());
+    }
+    command += fmt::format(" --frames {} --pairs {}", frames, pair_count);
+
+    const std::string header = write_fused_pairs_header(pairs, histogram->total(), command);
+    FILE* file               = fopen(argv[1], "w");
+    if (!file) {
+        info_message("fopen failed: {}", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    const bool written = fwrite(header.data(), 1, header.size(), file) == header.size();
+    if (fclose(file) != 0 || !written) {
+        info_message("couldn't write {}", argv[1]);
+        return EXIT_FAILURE;
+    }
+}
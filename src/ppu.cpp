@@ -0,0 +1,494 @@
+#include "ppu.h"
+
+#include "cpu.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
+namespace
+{
+
+// PPUCTRL, PPUMASK and PPUSTATUS bits
+constexpr uint8_t ctrl_increment_32        = 0x04;
+constexpr uint8_t ctrl_sprite_table        = 0x08;
+constexpr uint8_t ctrl_background_table    = 0x10;
+constexpr uint8_t ctrl_tall_sprites        = 0x20;
+constexpr uint8_t ctrl_nmi                 = 0x80;
+constexpr uint8_t mask_grayscale           = 0x01;
+constexpr uint8_t mask_left_background     = 0x02;
+constexpr uint8_t mask_left_sprites        = 0x04;
+constexpr uint8_t mask_background          = 0x08;
+constexpr uint8_t mask_sprites             = 0x10;
+constexpr int mask_emphasis_shift          = 5;
+constexpr uint8_t status_sprite_overflow   = 0x20;
+constexpr uint8_t status_sprite_zero_hit   = 0x40;
+constexpr uint8_t status_vblank            = 0x80;
+constexpr uint8_t sprite_palette           = 0x03;
+constexpr uint8_t sprite_behind_background = 0x20;
+constexpr uint8_t sprite_flip_horizontal   = 0x40;
+constexpr uint8_t sprite_flip_vertical     = 0x80;
+constexpr uint8_t sprite_unused_bits       = 0x1C;
+
+// Ppu::m_SpriteLine bits above the palette entry
+constexpr uint8_t sprite_zero_pixel       = 0x40;
+constexpr uint8_t behind_background_pixel = 0x80;
+
+// The sprite palettes' first entries are mirrors of the background ones
+size_t palette_offset(uint16_t addr)
+{
+    addr &= 0x1F;
+    if ((addr & 0x13) == 0x10) addr &= 0x0F;
+    return addr;
+}
+
+// Mirrors a row of pixels from TileCache
+uint64_t reverse_pixels(uint64_t row)
+{
+    row = (row & 0x00000000FFFFFFFF) << 32 | row >> 32;
+    row = (row & 0x0000FFFF0000FFFF) << 16 | (row >> 16 & 0x0000FFFF0000FFFF);
+    return (row & 0x00FF00FF00FF00FF) << 8 | (row >> 8 & 0x00FF00FF00FF00FF);
+}
+
+uint8_t row_pixel(uint64_t row, int x)
+{
+    return (uint8_t)(row >> (x * 8));
+}
+
+// Bit n is set if sprite n covers line, which is one less than the scanline being drawn
+#if defined(__SSE2__)
+uint64_t sprites_on_line(const std::array<uint8_t, 64>& y, int line, int sprite_height)
+{
+    const __m128i line_y   = _mm_set1_epi8((char)line);
+    const __m128i last_row = _mm_set1_epi8((char)(sprite_height - 1));
+    uint64_t on_line       = 0;
+    for (size_t i = 0; i < y.size(); i += 16) {
+        // there's no unsigned byte compare, a <= b is min(a, b) == a
+        const __m128i top      = _mm_loadu_si128((const __m128i*)(y.data() + i));
+        const __m128i row      = _mm_sub_epi8(line_y, top);
+        const __m128i started  = _mm_cmpeq_epi8(_mm_min_epu8(top, line_y), top);
+        const __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(row, last_row), row);
+        on_line |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_and_si128(started, in_range)) << i;
+    }
+    return on_line;
+}
+#else
+uint64_t sprites_on_line(const std::array<uint8_t, 64>& y, int line, int sprite_height)
+{
+    uint64_t on_line = 0;
+    for (size_t i = 0; i < y.size(); ++i) {
+        const int row = line - y[i];
+        if (row >= 0 && row < sprite_height) on_line |= (uint64_t)1 << i;
+    }
+    return on_line;
+}
+#endif
+
+// An event for dot fires once the PPU has been run past it
+uint64_t cycle_for_dot(uint64_t dot)
+{
+    return dot / 3 + 1;
+}
+
+} // namespace
+
+Ppu::Ppu(CPU6502& cpu) : m_Cpu(cpu), m_Frame(width * height, 0)
+{
+    m_Cpu.memory.map_io(0x20, 0x20, this);
+    schedule_next_event();
+}
+
+uint8_t Ppu::io_read(uint16_t addr)
+{
+    catch_up();
+    switch (addr & 7) {
+        case 2: {
+            const uint8_t value = (uint8_t)((m_Status & 0xE0) | (m_IoLatch & 0x1F));
+            m_Status &= (uint8_t)~status_vblank;
+            m_W = false;
+            return value;
+        }
+        case 4: return oam_read(m_OamAddr);
+        case 7: {
+            uint8_t value = m_ReadBuffer;
+            if ((m_V & 0x3FFF) >= 0x3F00) {
+                // the palette is read straight away, the buffer gets the nametable byte underneath it
+                value        = (uint8_t)((vram_read(m_V) & 0x3F) | (m_IoLatch & 0xC0));
+                m_ReadBuffer = vram_read(m_V - 0x1000);
+            } else {
+                m_ReadBuffer = vram_read(m_V);
+            }
+            m_V = (m_V + ((m_Ctrl & ctrl_increment_32) ? 32 : 1)) & 0x7FFF;
+            return value;
+        }
+        default: return m_IoLatch;
+    }
+}
+
+void Ppu::io_write(uint16_t addr, uint8_t data)
+{
+    catch_up();
+    m_IoLatch = data;
+    switch (addr & 7) {
+        case 0: {
+            const bool nmi_enabled = !(m_Ctrl & ctrl_nmi) && (data & ctrl_nmi);
+            m_Ctrl                 = data;
+            m_T                    = (uint16_t)((m_T & 0xF3FF) | ((data & 3) << 10));
+            if (nmi_enabled && (m_Status & status_vblank)) m_Cpu.trigger_nmi();
+            break;
+        }
+        case 1:
+            m_Mask = data;
+            // turning rendering on or off changes when the scanline counter is clocked and how long the frame is
+            schedule_next_event();
+            break;
+        case 3: m_OamAddr = data; break;
+        case 4: write_oam_data(data); break;
+        case 5:
+            if (!m_W) {
+                m_FineX = data & 7;
+                m_T     = (uint16_t)((m_T & 0xFFE0) | (data >> 3));
+            } else {
+                m_T = (uint16_t)((m_T & 0x8C1F) | ((data & 7) << 12) | ((data & 0xF8) << 2));
+            }
+            m_W = !m_W;
+            break;
+        case 6:
+            if (!m_W) {
+                m_T = (uint16_t)((m_T & 0x00FF) | ((data & 0x3F) << 8));
+            } else {
+                m_T = (uint16_t)((m_T & 0xFF00) | data);
+                m_V = m_T;
+            }
+            m_W = !m_W;
+            break;
+        case 7:
+            vram_write(m_V, data);
+            m_V = (m_V + ((m_Ctrl & ctrl_increment_32) ? 32 : 1)) & 0x7FFF;
+            break;
+        default: break;
+    }
+}
+
+// PPUSTATUS and OAMDATA only change at a scheduled event outside of rendering, which is as far as an idle loop can
+// skip. Reading PPUDATA moves the address on.
+bool Ppu::io_read_repeatable(uint16_t addr) const
+{
+    switch (addr & 7) {
+        case 2:
+        case 4: return !rendering_enabled() || (m_Scanline >= vblank_scanline && m_Scanline < prerender_scanline);
+        case 7: return false;
+        default: return true;
+    }
+}
+
+void Ppu::run_event(uint64_t)
+{
+    catch_up();
+    schedule_next_event();
+}
+
+void Ppu::catch_up()
+{
+    const uint64_t target = m_Cpu.access_cycle() * 3;
+    while (m_Dot < target) {
+        const int line_end = scanline_length(m_Scanline, m_OddFrame);
+        const int to       = (int)std::min<uint64_t>(line_end, m_LineDot + (target - m_Dot));
+        run_scanline(m_LineDot, to);
+        m_Dot += (uint64_t)(to - m_LineDot);
+        m_LineDot = to;
+        if (m_LineDot == line_end) {
+            m_LineDot = 0;
+            if (++m_Scanline == scanlines) {
+                m_Scanline = 0;
+                m_OddFrame = !m_OddFrame;
+            }
+        }
+    }
+}
+
+uint64_t Ppu::next_vblank_cycle() const
+{
+    return cycle_for_dot(m_Dot + dots_until(vblank_scanline, 1));
+}
+
+// The pre-render scanline is a dot short every other frame while rendering
+int Ppu::scanline_length(int scanline, bool odd_frame) const
+{
+    return scanline == prerender_scanline && odd_frame && rendering_enabled() ? dots_per_scanline - 1
+                                                                               : dots_per_scanline;
+}
+
+// How many dots from where the PPU has got to until it reaches dot on scanline, 0 if it's about to run it
+uint64_t Ppu::dots_until(int scanline, int dot) const
+{
+    uint64_t dots  = 0;
+    int line       = m_Scanline;
+    int line_dot   = m_LineDot;
+    bool odd_frame = m_OddFrame;
+    while (line != scanline || line_dot > dot) {
+        dots += (uint64_t)(scanline_length(line, odd_frame) - line_dot);
+        line_dot = 0;
+        if (++line == scanlines) {
+            line      = 0;
+            odd_frame = !odd_frame;
+        }
+    }
+    return dots + (uint64_t)(dot - line_dot);
+}
+
+// The start and end of vblank, and the point in each rendered scanline where a mapper counting them is clocked
+void Ppu::schedule_next_event()
+{
+    uint64_t dots = std::min(dots_until(vblank_scanline, 1), dots_until(prerender_scanline, 1));
+    if (rendering_enabled() && m_Cpu.mapper && m_Cpu.mapper->counts_scanlines()) {
+        int line = m_LineDot <= 260 ? m_Scanline : m_Scanline + 1;
+        if (line >= height && line != prerender_scanline) line = prerender_scanline;
+        if (line == scanlines) line = 0;
+        dots = std::min(dots, dots_until(line, 260));
+    }
+    m_Cpu.scheduler.schedule(this, cycle_for_dot(m_Dot + dots));
+}
+
+// Runs dots [from, to) of the current scanline
+void Ppu::run_scanline(int from, int to)
+{
+    const auto reaches = [&](int dot) { return from <= dot && dot < to; };
+
+    const bool visible = m_Scanline < height;
+    if (visible && from < 257 && to > 1) draw_pixels(std::max(from, 1) - 1, std::min(to, 257) - 1);
+
+    if (m_Scanline == vblank_scanline && reaches(1)) {
+        m_Status |= status_vblank;
+        m_FrameCount++;
+        if (m_Ctrl & ctrl_nmi) m_Cpu.trigger_nmi();
+    }
+    if (m_Scanline == prerender_scanline && reaches(1)) {
+        m_Status &= (uint8_t)~(status_vblank | status_sprite_zero_hit | status_sprite_overflow);
+    }
+
+    if (!rendering_enabled() || (!visible && m_Scanline != prerender_scanline)) return;
+    if (reaches(256)) increment_y();
+    if (reaches(257)) m_V = (uint16_t)((m_V & ~0x041F) | (m_T & 0x041F));
+    if (reaches(260) && m_Cpu.mapper && m_Cpu.mapper->counts_scanlines()) {
+        m_Cpu.mapper->clock_scanline();
+        m_Cpu.set_irq_line(IrqSource::Mapper, m_Cpu.mapper->irq_asserted());
+    }
+    if (m_Scanline == prerender_scanline && reaches(280)) m_V = (uint16_t)((m_V & ~0x7BE0) | (m_T & 0x7BE0));
+}
+
+// Draws pixels [from, to) of the current scanline. v only moves on to the next tile while rendering.
+void Ppu::draw_pixels(int from, int to)
+{
+    // pixels are drawn up to a write to PPUMASK before it changes, so this is where the emphasis changes
+    const auto first_pixel = (uint32_t)(m_Scanline * width + from);
+    const auto emphasis    = (uint8_t)(m_Mask >> mask_emphasis_shift);
+    if (first_pixel == 0) m_EmphasisSpans.clear();
+    if (m_EmphasisSpans.empty() || m_EmphasisSpans.back().emphasis != emphasis) {
+        m_EmphasisSpans.push_back({ first_pixel, emphasis });
+    }
+
+    if (from == 0) {
+        evaluate_sprites();
+        m_TilePixel = m_FineX;
+        fetch_tile();
+    }
+
+    uint8_t* line                = m_Frame.data() + m_Scanline * width;
+    const uint8_t grayscale_mask = (m_Mask & mask_grayscale) ? 0x30 : 0x3F;
+    if (!rendering_enabled()) {
+        // the backdrop, unless v points into the palette in which case it's that entry
+        const uint8_t backdrop = (m_V & 0x3F00) == 0x3F00 ? m_Palette[palette_offset(m_V)] : m_Palette[0];
+        std::fill(line + from, line + to, backdrop & grayscale_mask);
+        return;
+    }
+
+    for (int x = from; x < to; ++x) {
+        uint8_t background = row_pixel(m_TileRow, m_TilePixel);
+        uint8_t palette    = (uint8_t)(m_TilePalette << 2 | background);
+        if (++m_TilePixel == 8) {
+            m_TilePixel = 0;
+            increment_x();
+            fetch_tile();
+        }
+        if (!(m_Mask & mask_background) || (x < 8 && !(m_Mask & mask_left_background))) background = 0;
+        if (!background) palette = 0;
+
+        const uint8_t sprite = m_SpriteLine[(size_t)x];
+        if (sprite && (m_Mask & mask_sprites) && (x >= 8 || (m_Mask & mask_left_sprites))) {
+            if ((sprite & sprite_zero_pixel) && background && x != 255) m_Status |= status_sprite_zero_hit;
+            if (!background || !(sprite & behind_background_pixel)) palette = sprite & 0x1F;
+        }
+        line[x] = m_Palette[palette] & grayscale_mask;
+    }
+}
+
+// Finds the first eight sprites on the current scanline and draws them into m_SpriteLine. A sprite's Y is one less
+// than the first scanline it's on, so none are drawn on the first.
+void Ppu::evaluate_sprites()
+{
+    if (!m_SpriteLineEmpty) {
+        m_SpriteLine.fill(0);
+        m_SpriteLineEmpty = true;
+    }
+    if (!rendering_enabled() || m_Scanline == 0) return;
+
+    const int sprite_height = (m_Ctrl & ctrl_tall_sprites) ? 16 : 8;
+    uint64_t on_line        = sprites_on_line(m_SpriteY, m_Scanline - 1, sprite_height);
+    std::array<uint8_t, 8> drawn;
+    size_t drawn_count = 0;
+    for (; on_line; on_line &= on_line - 1) {
+        if (drawn_count == drawn.size()) {
+            m_Status |= status_sprite_overflow;
+            break;
+        }
+        drawn[drawn_count++] = (uint8_t)std::countr_zero(on_line);
+    }
+
+    // the lowest numbered sprite with a pixel somewhere wins even if it's behind the background, so they're drawn
+    // highest first
+    while (drawn_count) {
+        composite_sprite(drawn[--drawn_count]);
+        m_SpriteLineEmpty = false;
+    }
+}
+
+// Draws 8 pixels of a sprite over m_SpriteLine at once, leaving what's there wherever the sprite is transparent
+void Ppu::composite_sprite(size_t sprite)
+{
+    const int sprite_height  = (m_Ctrl & ctrl_tall_sprites) ? 16 : 8;
+    const uint8_t tile       = m_SpriteTile[sprite];
+    const uint8_t attributes = m_SpriteAttributes[sprite];
+    int row                  = m_Scanline - 1 - m_SpriteY[sprite];
+    if (attributes & sprite_flip_vertical) row = sprite_height - 1 - row;
+
+    uint16_t addr = 0;
+    if (sprite_height == 16) {
+        // 8x16 sprites take their pattern table from bit 0 of the tile, the bottom half is the next tile
+        addr = (uint16_t)((tile & 1) * 0x1000 + (tile & 0xFE) * 16 + (row & 8) * 2 + (row & 7));
+    } else {
+        addr = (uint16_t)(((m_Ctrl & ctrl_sprite_table) ? 0x1000 : 0) + tile * 16 + row);
+    }
+    uint64_t pixels = pattern_row(addr);
+    if (attributes & sprite_flip_horizontal) pixels = reverse_pixels(pixels);
+
+    uint8_t flags = (uint8_t)(0x10 | (attributes & sprite_palette) << 2);
+    if (attributes & sprite_behind_background) flags |= behind_background_pixel;
+    if (sprite == 0) flags |= sprite_zero_pixel;
+
+    constexpr uint64_t every_byte = 0x0101010101010101;
+    const uint64_t opaque         = ((pixels | pixels >> 1) & every_byte) * 0xFF;
+    uint8_t* const at             = m_SpriteLine.data() + m_SpriteX[sprite];
+    uint64_t line;
+    std::memcpy(&line, at, sizeof(line));
+    line = (line & ~opaque) | ((pixels | flags * every_byte) & opaque);
+    std::memcpy(at, &line, sizeof(line));
+}
+
+void Ppu::fetch_tile()
+{
+    const uint8_t tile     = m_Nametables[nametable_offset(0x2000 | (m_V & 0x0FFF))];
+    const uint16_t pattern = (uint16_t)(((m_Ctrl & ctrl_background_table) ? 0x1000 : 0) + tile * 16 + (m_V >> 12));
+    m_TileRow              = pattern_row(pattern);
+
+    const uint16_t attribute_addr = 0x23C0 | (m_V & 0x0C00) | ((m_V >> 4) & 0x38) | ((m_V >> 2) & 0x07);
+    const uint8_t attribute       = m_Nametables[nametable_offset(attribute_addr)];
+    m_TilePalette                 = (attribute >> (((m_V >> 4) & 4) | (m_V & 2))) & 3;
+}
+
+// Coarse X, wrapping into the horizontally adjacent nametable
+void Ppu::increment_x()
+{
+    if ((m_V & 0x001F) == 31) {
+        m_V = (uint16_t)((m_V & ~0x001F) ^ 0x0400);
+    } else {
+        m_V++;
+    }
+}
+
+// Fine Y, then coarse Y, wrapping into the vertically adjacent nametable after row 29
+void Ppu::increment_y()
+{
+    if ((m_V & 0x7000) != 0x7000) {
+        m_V += 0x1000;
+        return;
+    }
+
+    m_V &= 0x0FFF;
+    uint16_t coarse_y = (m_V & 0x03E0) >> 5;
+    if (coarse_y == 29) {
+        coarse_y = 0;
+        m_V ^= 0x0800;
+    } else if (coarse_y == 31) {
+        coarse_y = 0;
+    } else {
+        coarse_y++;
+    }
+    m_V = (uint16_t)((m_V & ~0x03E0) | (coarse_y << 5));
+}
+
+uint64_t Ppu::pattern_row(uint16_t addr) const
+{
+    return m_Cpu.mapper ? m_Cpu.mapper->chr_row(addr) : 0;
+}
+
+uint8_t Ppu::vram_read(uint16_t addr) const
+{
+    addr &= 0x3FFF;
+    if (addr < 0x2000) return m_Cpu.mapper ? m_Cpu.mapper->chr_read(addr) : 0;
+    if (addr < 0x3F00) return m_Nametables[nametable_offset(addr)];
+    return m_Palette[palette_offset(addr)];
+}
+
+void Ppu::vram_write(uint16_t addr, uint8_t data)
+{
+    addr &= 0x3FFF;
+    if (addr < 0x2000) {
+        if (m_Cpu.mapper) m_Cpu.mapper->chr_write(addr, data);
+    } else if (addr < 0x3F00) {
+        m_Nametables[nametable_offset(addr)] = data;
+    } else {
+        m_Palette[palette_offset(addr)] = data & 0x3F;
+    }
+}
+
+uint8_t Ppu::oam_read(uint8_t addr) const
+{
+    const size_t sprite = addr >> 2;
+    switch (addr & 3) {
+        case 0: return m_SpriteY[sprite];
+        case 1: return m_SpriteTile[sprite];
+        case 2: return m_SpriteAttributes[sprite];
+        default: return m_SpriteX[sprite];
+    }
+}
+
+void Ppu::oam_write(uint8_t addr, uint8_t data)
+{
+    const size_t sprite = addr >> 2;
+    switch (addr & 3) {
+        case 0: m_SpriteY[sprite] = data; break;
+        case 1: m_SpriteTile[sprite] = data; break;
+        case 2: m_SpriteAttributes[sprite] = data & (uint8_t)~sprite_unused_bits; break;
+        default: m_SpriteX[sprite] = data; break;
+    }
+}
+
+// The four nametables are mapped onto the console's 2KiB by the cartridge
+size_t Ppu::nametable_offset(uint16_t addr) const
+{
+    const size_t table = (addr >> 10) & 3;
+    size_t mapped      = 0;
+    switch (m_Cpu.mapper ? m_Cpu.mapper->mirroring() : Mirroring::Horizontal) {
+        case Mirroring::Horizontal: mapped = table >> 1; break;
+        case Mirroring::Vertical: mapped = table & 1; break;
+        case Mirroring::SingleScreenLow: mapped = 0; break;
+        case Mirroring::SingleScreenHigh: mapped = 1; break;
+        case Mirroring::FourScreen: mapped = table; break;
+    }
+    return mapped * 0x400 + (addr & 0x3FF);
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "memory.h"
+#include "scheduler.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class CPU6502;
+
+// The 2C02 behind $2000-$3FFF. It runs three dots for every CPU cycle but isn't stepped along with the CPU, it works
+// out what it's been doing since it last ran whenever the CPU touches one of its registers and at the events it
+// schedules (the start and end of vblank, and every scanline while a mapper is counting them). Scanlines are drawn
+// whole except when a register is touched part way through one, in which case the dots up to then are drawn first so
+// the write only affects what comes after it, like it would on the real thing.
+class Ppu : public IoHandler, public EventHandler
+{
+public:
+    static constexpr int width  = 256;
+    static constexpr int height = 240;
+
+    static constexpr int dots_per_scanline  = 341;
+    static constexpr int scanlines          = 262;
+    static constexpr int vblank_scanline    = 241;
+    static constexpr int prerender_scanline = 261;
+
+    // Maps itself into cpu's memory
+    explicit Ppu(CPU6502& cpu);
+    Ppu(const Ppu&)            = delete;
+    Ppu& operator=(const Ppu&) = delete;
+
+    uint8_t io_read(uint16_t addr) override;
+    void io_write(uint16_t addr, uint8_t data) override;
+    bool io_read_repeatable(uint16_t addr) const override;
+    void run_event(uint64_t cycle) override;
+
+    // Brings the PPU up to the CPU's cycle count, or to the cycle the instruction running touches memory on while there
+    // is one, so a register sees the PPU as it is when the access happens
+    void catch_up();
+
+    // PPUMASK's colour emphasis bits (red, green, blue from bit 0) from first_pixel (y * width + x) of the frame up to
+    // the next span's
+    struct EmphasisSpan
+    {
+        uint32_t first_pixel;
+        uint8_t emphasis;
+    };
+
+    // The frame as a byte per pixel, the palette entry (0-63, with PPUMASK's grayscale applied), in rows of width. It's
+    // complete once the PPU has reached vblank. Turning it into colours is left to whatever wants them, see
+    // convert_frame.
+    const std::vector<uint8_t>& frame() const { return m_Frame; }
+    // The emphasis the frame was drawn with, a new span starting on the pixel where a write to PPUMASK changed it. The
+    // first span starts at pixel 0 so there's always at least one.
+    std::span<const EmphasisSpan> emphasis_spans() const { return m_EmphasisSpans; }
+    uint64_t frame_count() const { return m_FrameCount; }
+    int scanline() const { return m_Scanline; }
+    int dot() const { return m_LineDot; }
+
+    // The CPU cycle the next frame's vblank starts on
+    uint64_t next_vblank_cycle() const;
+
+    // The PPU's own address space: pattern tables through the mapper, nametables and palette RAM
+    uint8_t vram_read(uint16_t addr) const;
+    void vram_write(uint16_t addr, uint8_t data);
+
+    // OAM as OAMDATA sees it, four bytes per sprite: Y, tile, attributes, X
+    uint8_t oam_read(uint8_t addr) const;
+    void oam_write(uint8_t addr, uint8_t data);
+    // Writes to OAMDATA, what OAM DMA does
+    void write_oam_data(uint8_t data) { oam_write(m_OamAddr++, data); }
+
+private:
+    bool rendering_enabled() const { return m_Mask & 0x18; }
+    int scanline_length(int scanline, bool odd_frame) const;
+    uint64_t dots_until(int scanline, int dot) const;
+    void schedule_next_event();
+
+    void run_scanline(int from, int to);
+    void draw_pixels(int from, int to);
+    void evaluate_sprites();
+    void composite_sprite(size_t sprite);
+    void fetch_tile();
+    void increment_x();
+    void increment_y();
+    uint64_t pattern_row(uint16_t addr) const;
+    size_t nametable_offset(uint16_t addr) const;
+
+    CPU6502& m_Cpu;
+
+    // registers
+    uint8_t m_Ctrl       = 0;
+    uint8_t m_Mask       = 0;
+    uint8_t m_Status     = 0;
+    uint8_t m_OamAddr    = 0;
+    uint8_t m_ReadBuffer = 0; // $2007 reads are a read behind, except for the palette
+    uint8_t m_IoLatch    = 0; // what reading a write only register gives, the last value written to any of them
+
+    // The internal scroll registers: v is the VRAM address (and, while drawing, the tile being drawn), t is the one
+    // v is reloaded from, x is the fine horizontal scroll and w toggles between the two writes to $2005 or $2006
+    uint16_t m_V    = 0;
+    uint16_t m_T    = 0;
+    uint8_t m_FineX = 0;
+    bool m_W        = false;
+
+    std::array<uint8_t, 0x1000> m_Nametables = {}; // only four screen mirroring uses more than the first 2KiB
+    std::array<uint8_t, 0x20> m_Palette      = {};
+
+    // OAM split up by field so all 64 Ys can be compared against a scanline at once
+    std::array<uint8_t, 64> m_SpriteY          = {};
+    std::array<uint8_t, 64> m_SpriteTile       = {};
+    std::array<uint8_t, 64> m_SpriteAttributes = {};
+    std::array<uint8_t, 64> m_SpriteX          = {};
+
+    // where the PPU has got to, m_Dot counts dots since power on
+    uint64_t m_Dot        = 0;
+    int m_Scanline        = 0;
+    int m_LineDot         = 0;
+    bool m_OddFrame       = false;
+    uint64_t m_FrameCount = 0;
+
+    // the background tile being drawn and which of its pixels is next
+    uint64_t m_TileRow    = 0; // a byte per pixel, from TileCache
+    uint8_t m_TilePalette = 0;
+    uint8_t m_TilePixel   = 0;
+
+    // The sprites on the current scanline drawn over each other, a byte per pixel: the palette entry, or 0 where
+    // they're all transparent, with sprite_zero_pixel and behind_background_pixel. The 8 past the end are for sprites
+    // hanging off the right.
+    std::array<uint8_t, width + 8> m_SpriteLine = {};
+    bool m_SpriteLineEmpty                      = true;
+
+    std::vector<uint8_t> m_Frame;
+    std::vector<EmphasisSpan> m_EmphasisSpans = { { 0, 0 } };
+};
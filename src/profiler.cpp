@@ -0,0 +1,96 @@
+#include "profiler.h"
+
+#include "cpu.h"
+
+#include <algorithm>
+#include <numeric>
+#include <span>
+#include <vector>
+
+auto Profiler::location(uint16_t pc, int16_t prg_bank) const -> const Location&
+{
+    static const Location never_ran;
+    if (prg_bank == not_prg) return m_Locations[pc];
+    const size_t index = (size_t)prg_bank * 0x2000 + (pc & 0x1FFF);
+    return index < m_PrgLocations.size() ? m_PrgLocations[index] : never_ran;
+}
+
+void Profiler::clear()
+{
+    m_Opcodes.fill({});
+    m_Locations.fill({});
+    m_PrgLocations.clear();
+    m_Total = {};
+}
+
+std::string disassemble(uint16_t pc, uint8_t opcode, uint16_t operand)
+{
+    const CPU6502::Instruction& instruction = CPU6502::instruction(opcode);
+    const AddressingMode mode               = instruction.mode;
+    const char* name                        = instruction.name;
+    if (mode == AddressingMode::Accumulator) return fmt::format("{} A", name);
+    if (mode == AddressingMode::Immediate) return fmt::format("{} #${:02X}", name, operand);
+    if (mode == AddressingMode::ZeroPage) return fmt::format("{} ${:02X}", name, operand);
+    if (mode == AddressingMode::ZeroPageX) return fmt::format("{} ${:02X},X", name, operand);
+    if (mode == AddressingMode::ZeroPageY) return fmt::format("{} ${:02X},Y", name, operand);
+    if (mode == AddressingMode::Absolute) return fmt::format("{} ${:04X}", name, operand);
+    if (mode == AddressingMode::AbsoluteX) return fmt::format("{} ${:04X},X", name, operand);
+    if (mode == AddressingMode::AbsoluteY) return fmt::format("{} ${:04X},Y", name, operand);
+    if (mode == AddressingMode::IndirectX) return fmt::format("{} (${:02X},X)", name, operand);
+    if (mode == AddressingMode::IndirectY) return fmt::format("{} (${:02X}),Y", name, operand);
+    if (mode == AddressingMode::Indirect) return fmt::format("{} (${:04X})", name, operand);
+    if (mode == AddressingMode::Relative) return fmt::format("{} ${:04X}", name, (uint16_t)(pc + 2 + (int8_t)operand));
+    return name;
+}
+
+static double share(uint64_t cycles, uint64_t total)
+{
+    return total ? (double)cycles * 100.0 / (double)total : 0.0;
+}
+
+std::string Profiler::report(size_t limit) const
+{
+    std::string out = fmt::format("{} instructions, {} cycles\n", m_Total.executions, m_Total.cycles);
+
+    std::vector<const Location*> locations;
+    for (const std::span<const Location> span : { std::span<const Location>(m_Locations), std::span(m_PrgLocations) }) {
+        for (const Location& location : span) {
+            if (location.counts.executions) locations.push_back(&location);
+        }
+    }
+    const auto location_end = locations.begin() + (ptrdiff_t)std::min(limit, locations.size());
+    std::partial_sort(locations.begin(), location_end, locations.end(), [](const Location* lhs, const Location* rhs) {
+        return lhs->counts.cycles > rhs->counts.cycles;
+    });
+
+    out += "\n    cycles   share    executions  pc    bank  instruction\n";
+    for (auto it = locations.begin(); it != location_end; ++it) {
+        const Location& location = **it;
+        const std::string bank   = location.prg_bank == not_prg ? "--" : fmt::format("{:02X}", location.prg_bank);
+        out += fmt::format("{:>10} {:6.2f}% {:>12}  {:04X}  {:>4}  {}\n",
+                           location.counts.cycles,
+                           share(location.counts.cycles, m_Total.cycles),
+                           location.counts.executions,
+                           location.pc,
+                           bank,
+                           disassemble(location.pc, location.opcode, location.operand));
+    }
+
+    std::vector<uint32_t> opcodes(m_Opcodes.size());
+    std::iota(opcodes.begin(), opcodes.end(), 0);
+    const auto opcode_end = opcodes.begin() + (ptrdiff_t)std::min(limit, opcodes.size());
+    std::partial_sort(opcodes.begin(), opcode_end, opcodes.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return m_Opcodes[lhs].cycles > m_Opcodes[rhs].cycles;
+    });
+
+    out += "\n    cycles   share    executions  opcode\n";
+    for (auto it = opcodes.begin(); it != opcode_end && m_Opcodes[*it].executions; ++it) {
+        out += fmt::format("{:>10} {:6.2f}% {:>12}  {:02X} {}\n",
+                           m_Opcodes[*it].cycles,
+                           share(m_Opcodes[*it].cycles, m_Total.cycles),
+                           m_Opcodes[*it].executions,
+                           *it,
+                           CPU6502::instruction((uint8_t)*it).name);
+    }
+    return out;
+}
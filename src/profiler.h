@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Counts how many times each instruction runs and how many cycles it takes, by opcode and by address. Addresses in
+// PRG-ROM are counted by bank and where they are in it, so code at the same pc in two banks is kept apart. The CPU
+// records every instruction it runs into one while its profiler is set, through the block cache as it runs each block
+// but without fusing pairs or skipping idle loops, so the counts are the same as stepping would give. Leaving it unset
+// costs the block cache and the recompiler nothing, the profiled interpreter loop is a separate instantiation.
+class Profiler
+{
+public:
+    static constexpr int16_t not_prg = -1;
+
+    struct Counts
+    {
+        uint64_t executions = 0;
+        uint64_t cycles     = 0;
+    };
+
+    // What was at an address the last time it ran, for the report
+    struct Location
+    {
+        Counts counts;
+        uint16_t pc      = 0;
+        uint16_t operand = 0;
+        uint8_t opcode   = 0;
+        int16_t prg_bank = not_prg; // the 8KiB bank of PRG-ROM, not_prg for RAM or without a mapper
+    };
+
+    void record(uint16_t pc, uint8_t opcode, uint16_t operand, int16_t prg_bank, uint8_t cycles)
+    {
+        Location& location = location_at(pc, prg_bank);
+        location.counts.executions++;
+        location.counts.cycles += cycles;
+        location.pc       = pc;
+        location.operand  = operand;
+        location.opcode   = opcode;
+        location.prg_bank = prg_bank;
+
+        m_Opcodes[opcode].executions++;
+        m_Opcodes[opcode].cycles += cycles;
+        m_Total.executions++;
+        m_Total.cycles += cycles;
+    }
+
+    const Counts& opcode_counts(uint8_t opcode) const { return m_Opcodes[opcode]; }
+    // prg_bank is the bank pc was in when it ran, not_prg for anything that isn't PRG-ROM
+    const Location& location(uint16_t pc, int16_t prg_bank = not_prg) const;
+    const Counts& total() const { return m_Total; }
+    void clear();
+
+    // The limit addresses and opcodes that took the most cycles, with the instruction at each address disassembled
+    std::string report(size_t limit) const;
+
+private:
+    Location& location_at(uint16_t pc, int16_t prg_bank)
+    {
+        if (prg_bank == not_prg) return m_Locations[pc];
+        const size_t index = (size_t)prg_bank * 0x2000 + (pc & 0x1FFF);
+        if (index >= m_PrgLocations.size()) [[unlikely]] m_PrgLocations.resize(((size_t)prg_bank + 1) * 0x2000);
+        return m_PrgLocations[index];
+    }
+
+    std::array<Counts, 0x100> m_Opcodes = {};
+    std::array<Location, 0x10000> m_Locations;
+    std::vector<Location> m_PrgLocations; // 8KiB for each bank up to the highest that has run
+    Counts m_Total;
+};
+
+// The instruction in assembler syntax, "LDA $0300,X", pc is where it is for working out branch targets
+std::string disassemble(uint16_t pc, uint8_t opcode, uint16_t operand);
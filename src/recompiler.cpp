@@ -0,0 +1,717 @@
+#include "recompiler.h"
+
+#include "cpu.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define RECOMPILER_SUPPORTED 1
+#include <sys/mman.h>
+#else
+#define RECOMPILER_SUPPORTED 0
+#endif
+
+#if RECOMPILER_SUPPORTED
+
+// 4MiB holds a few thousand blocks, when it fills up everything is thrown away and translated again as it's run
+static constexpr size_t default_arena_size = 4 * 1024 * 1024;
+
+// Where everything the generated code touches lives relative to the CPU, which it keeps in rbx
+struct CpuOffsets
+{
+    static CpuOffsets of(const CPU6502& cpu);
+
+    int32_t a;
+    int32_t x;
+    int32_t y;
+    int32_t s;
+    int32_t pc;
+    int32_t flags;
+    int32_t negative_result;
+    int32_t zero_result;
+    int32_t cycle_count;
+    int32_t io_cycle;
+    int32_t stop_cycle;
+    int32_t read_pages;
+    int32_t write_pages;
+};
+
+static int32_t offset_in(const CPU6502& cpu, const void* member)
+{
+    return (int32_t)((const uint8_t*)member - (const uint8_t*)&cpu);
+}
+
+CpuOffsets CpuOffsets::of(const CPU6502& cpu)
+{
+    return CpuOffsets{
+        .a               = offset_in(cpu, &cpu.registers.a),
+        .x               = offset_in(cpu, &cpu.registers.x),
+        .y               = offset_in(cpu, &cpu.registers.y),
+        .s               = offset_in(cpu, &cpu.registers.s),
+        .pc              = offset_in(cpu, &cpu.registers.pc),
+        .flags           = offset_in(cpu, &cpu.registers.p.m_Flags),
+        .negative_result = offset_in(cpu, &cpu.registers.p.m_NegativeResult),
+        .zero_result     = offset_in(cpu, &cpu.registers.p.m_ZeroResult),
+        .cycle_count     = offset_in(cpu, &cpu.cycle_count),
+        .io_cycle        = offset_in(cpu, &cpu.io_cycle),
+        .stop_cycle      = offset_in(cpu, &cpu.stop_cycle),
+        .read_pages      = offset_in(cpu, cpu.memory.m_ReadPages.data()),
+        .write_pages     = offset_in(cpu, cpu.memory.m_WritePages.data()),
+    };
+}
+
+// Called from generated code for anything that isn't plain memory
+static uint8_t read_byte_slow(CPU6502* cpu, uint32_t addr)
+{
+    return cpu->memory.read_byte((uint16_t)addr);
+}
+
+static void write_byte_slow(CPU6502* cpu, uint32_t addr, uint32_t data)
+{
+    cpu->memory.write_byte((uint16_t)addr, (uint8_t)data);
+}
+
+enum class Condition : uint8_t {
+    Below    = 0x2,
+    NotBelow = 0x3,
+    Zero     = 0x4,
+    NotZero  = 0x5,
+};
+
+// The handful of x86-64 instructions the translator needs. Registers are fixed by what they're used for: rbx holds the
+// CPU, r12d the effective address of the current instruction, eax/ecx/edx are scratch and the data byte being
+// read/written goes in al/dl.
+class Assembler
+{
+public:
+    explicit Assembler(std::vector<uint8_t>& code) : m_Code(code) {}
+
+    void emit(std::initializer_list<uint8_t> bytes) { m_Code.insert(m_Code.end(), bytes); }
+    void emit32(uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i) {
+            m_Code.push_back((uint8_t)(value >> (i * 8)));
+        }
+    }
+    void emit64(uint64_t value)
+    {
+        emit32((uint32_t)value);
+        emit32((uint32_t)(value >> 32));
+    }
+
+    // [rbx + disp32] with reg in the modrm reg field
+    void cpu_operand(uint8_t reg, int32_t disp)
+    {
+        emit({ (uint8_t)(0x80 | ((reg & 7) << 3) | 3) });
+        emit32((uint32_t)disp);
+    }
+
+    void prologue()
+    {
+        emit({ 0x53 });                   // push rbx
+        emit({ 0x41, 0x54 });             // push r12
+        emit({ 0x48, 0x83, 0xEC, 0x08 }); // sub rsp, 8 to keep calls 16 byte aligned
+        emit({ 0x48, 0x89, 0xFB });       // mov rbx, rdi
+    }
+
+    void epilogue()
+    {
+        emit({ 0x48, 0x83, 0xC4, 0x08 }); // add rsp, 8
+        emit({ 0x41, 0x5C });             // pop r12
+        emit({ 0x5B });                   // pop rbx
+        emit({ 0xC3 });                   // ret
+    }
+
+    // movzx r32, byte [rbx + disp], reg is eax, ecx or edx
+    void load_byte(uint8_t reg, int32_t disp)
+    {
+        emit({ 0x0F, 0xB6 });
+        cpu_operand(reg, disp);
+    }
+    // mov byte [rbx + disp], r8
+    void store_byte(uint8_t reg, int32_t disp)
+    {
+        emit({ 0x88 });
+        cpu_operand(reg, disp);
+    }
+    void store_imm8(int32_t disp, uint8_t value)
+    {
+        emit({ 0xC6 });
+        cpu_operand(0, disp);
+        emit({ value });
+    }
+    void store_imm16(int32_t disp, uint16_t value)
+    {
+        emit({ 0x66, 0xC7 });
+        cpu_operand(0, disp);
+        emit({ (uint8_t)value, (uint8_t)(value >> 8) });
+    }
+    // group 1 (add/or/and/cmp...) byte [rbx + disp], imm8
+    void byte_op_imm(uint8_t op, int32_t disp, uint8_t value)
+    {
+        emit({ 0x80 });
+        cpu_operand(op, disp);
+        emit({ value });
+    }
+    void test_byte_imm(int32_t disp, uint8_t value)
+    {
+        emit({ 0xF6 });
+        cpu_operand(0, disp);
+        emit({ value });
+    }
+    // inc/dec byte [rbx + disp]
+    void inc_byte(int32_t disp, bool decrement)
+    {
+        emit({ 0xFE });
+        cpu_operand(decrement ? 1 : 0, disp);
+    }
+    void add_qword_imm(int32_t disp, uint32_t value)
+    {
+        if (value == 0) return;
+        emit({ 0x48, 0x81 });
+        cpu_operand(0, disp);
+        emit32(value);
+    }
+    // add qword [rbx + disp], rax
+    void add_qword_rax(int32_t disp)
+    {
+        emit({ 0x48, 0x01 });
+        cpu_operand(0, disp);
+    }
+
+    void call(const void* function)
+    {
+        emit({ 0x48, 0x89, 0xDF }); // mov rdi, rbx
+        emit({ 0x48, 0xB8 });       // mov rax, imm64
+        emit64((uint64_t)function);
+        emit({ 0xFF, 0xD0 }); // call rax
+    }
+
+    size_t jump(Condition condition)
+    {
+        emit({ 0x0F, (uint8_t)(0x80 | (uint8_t)condition) });
+        emit32(0);
+        return m_Code.size() - 4;
+    }
+    size_t jump()
+    {
+        emit({ 0xE9 });
+        emit32(0);
+        return m_Code.size() - 4;
+    }
+    void bind(size_t jump_at)
+    {
+        const uint32_t displacement = (uint32_t)(m_Code.size() - (jump_at + 4));
+        memcpy(m_Code.data() + jump_at, &displacement, sizeof(displacement));
+    }
+
+private:
+    std::vector<uint8_t>& m_Code;
+};
+
+static constexpr uint8_t eax = 0;
+static constexpr uint8_t ecx = 1;
+static constexpr uint8_t edx = 2;
+
+// Where an instruction's operand comes from once the addressing mode has been worked out at translation time
+struct Operand
+{
+    enum class Kind { Immediate, Constant, Dynamic } kind; // Dynamic addresses are in r12d
+    uint16_t value;
+};
+
+class BlockTranslator
+{
+public:
+    BlockTranslator(std::vector<uint8_t>& code, const CpuOffsets& offsets) : m_Asm(code), m_Offsets(offsets) {}
+
+    uint16_t translate(std::span<const DecodedInstruction> block, uint16_t pc)
+    {
+        uint32_t max_cycles = 0;
+        m_Asm.prologue();
+        for (size_t i = 0; i < block.size(); ++i) {
+            // fused pairs are translated as the two instructions they're made of
+            DecodedInstruction decoded = block[i];
+            if (decoded.length > 1) {
+                decoded.handler = CPU6502::decoded_handler(decoded.opcode);
+                decoded.operand &= 0xFFFF;
+                decoded.length = 1;
+            }
+            const CPU6502::Instruction& instruction = CPU6502::instruction(decoded.opcode);
+            const uint16_t next_pc                  = (uint16_t)(pc + decoded.bytes);
+            const bool last                         = i + 1 == block.size();
+
+            // nothing adds more than 2 cycles to an instruction (a branch taken to another page)
+            if (!last) max_cycles += instruction.cycles + 2u;
+
+            if (!translate_native(decoded, instruction, next_pc, last)) {
+                translate_call(decoded, next_pc, last);
+            }
+            pc = next_pc;
+        }
+        return (uint16_t)std::min<uint32_t>(max_cycles, 0xFFFF);
+    }
+
+private:
+    bool translate_native(const DecodedInstruction& decoded, const CPU6502::Instruction& instruction, uint16_t next_pc,
+                          bool last);
+    void translate_call(const DecodedInstruction& decoded, uint16_t next_pc, bool last);
+
+    std::optional<Operand> address(const CPU6502::Instruction& instruction, uint16_t operand);
+    void read(const Operand& operand);
+    void write(const Operand& operand, uint16_t next_pc);
+    void set_io_cycle();
+    void set_zero_and_negative_from(uint8_t reg);
+    void assign_flags_from_dl_and_al(uint8_t mask);
+    void branch(const DecodedInstruction& decoded, int32_t flag_disp, uint8_t flag_mask, bool taken_when_set,
+                uint16_t next_pc);
+    void exit_if_stopping(uint16_t next_pc);
+    void exit(uint16_t pc);
+
+    Assembler m_Asm;
+    const CpuOffsets& m_Offsets;
+    uint32_t m_PendingCycles = 0; // cycles of translated instructions that haven't been added to cycle_count yet
+};
+
+std::optional<Operand> BlockTranslator::address(const CPU6502::Instruction& instruction, uint16_t operand)
+{
+    const AddressingMode mode = instruction.mode;
+    if (mode == AddressingMode::Immediate) return Operand{ Operand::Kind::Immediate, (uint8_t)operand };
+    if (mode == AddressingMode::ZeroPage) return Operand{ Operand::Kind::Constant, (uint8_t)operand };
+    if (mode == AddressingMode::Absolute) return Operand{ Operand::Kind::Constant, operand };
+
+    const bool zero_page = mode == AddressingMode::ZeroPageX || mode == AddressingMode::ZeroPageY;
+    const bool indexed   = zero_page || mode == AddressingMode::AbsoluteX || mode == AddressingMode::AbsoluteY;
+    if (!indexed) return std::nullopt;
+
+    // r12d = (index + operand) wrapped to the zero page or the address space
+    const bool by_x = mode == AddressingMode::ZeroPageX || mode == AddressingMode::AbsoluteX;
+    m_Asm.emit({ 0x44, 0x0F, 0xB6 }); // movzx r12d, byte [rbx + index]
+    m_Asm.cpu_operand(4, by_x ? m_Offsets.x : m_Offsets.y);
+    m_Asm.emit({ 0x41, 0x81, 0xC4 }); // add r12d, operand
+    m_Asm.emit32(operand);
+    m_Asm.emit({ 0x41, 0x81, 0xE4 }); // and r12d, mask
+    m_Asm.emit32(zero_page ? 0xFF : 0xFFFF);
+    return Operand{ Operand::Kind::Dynamic, 0 };
+}
+
+// eax = the byte at operand
+void BlockTranslator::read(const Operand& operand)
+{
+    if (operand.kind == Operand::Kind::Immediate) {
+        m_Asm.emit({ 0xB8 }); // mov eax, imm32
+        m_Asm.emit32(operand.value);
+        return;
+    }
+
+    if (operand.kind == Operand::Kind::Constant) {
+        m_Asm.emit({ 0x48, 0x8B }); // mov rax, [rbx + read_pages + page * 8]
+        m_Asm.cpu_operand(eax, m_Offsets.read_pages + (operand.value >> 8) * 8);
+    } else {
+        m_Asm.emit({ 0x44, 0x89, 0xE0 });                           // mov eax, r12d
+        m_Asm.emit({ 0xC1, 0xE8, 0x08 });                           // shr eax, 8
+        m_Asm.emit({ 0x48, 0x8B, 0x84, 0xC3 });                     // mov rax, [rbx + rax * 8 + read_pages]
+        m_Asm.emit32((uint32_t)m_Offsets.read_pages);
+    }
+    m_Asm.emit({ 0x48, 0x85, 0xC0 }); // test rax, rax
+    const size_t to_slow = m_Asm.jump(Condition::Zero);
+    if (operand.kind == Operand::Kind::Constant) {
+        m_Asm.emit({ 0x0F, 0xB6, 0x80 }); // movzx eax, byte [rax + offset]
+        m_Asm.emit32(operand.value & 0xFF);
+    } else {
+        m_Asm.emit({ 0x41, 0x0F, 0xB6, 0xCC }); // movzx ecx, r12b
+        m_Asm.emit({ 0x0F, 0xB6, 0x04, 0x08 }); // movzx eax, byte [rax + rcx]
+    }
+    const size_t to_done = m_Asm.jump();
+
+    m_Asm.bind(to_slow);
+    set_io_cycle();
+    if (operand.kind == Operand::Kind::Constant) {
+        m_Asm.emit({ 0xBE }); // mov esi, imm32
+        m_Asm.emit32(operand.value);
+    } else {
+        m_Asm.emit({ 0x44, 0x89, 0xE6 }); // mov esi, r12d
+    }
+    m_Asm.call((const void*)&read_byte_slow);
+    m_Asm.emit({ 0x0F, 0xB6, 0xC0 }); // movzx eax, al
+    m_Asm.bind(to_done);
+}
+
+// writes edx to operand, which always ends the instruction so a write that didn't go to plain memory can stop the
+// block straight after
+void BlockTranslator::write(const Operand& operand, uint16_t next_pc)
+{
+    if (operand.kind == Operand::Kind::Constant) {
+        m_Asm.emit({ 0x48, 0x8B }); // mov rax, [rbx + write_pages + page * 8]
+        m_Asm.cpu_operand(eax, m_Offsets.write_pages + (operand.value >> 8) * 8);
+    } else {
+        m_Asm.emit({ 0x44, 0x89, 0xE0 });       // mov eax, r12d
+        m_Asm.emit({ 0xC1, 0xE8, 0x08 });       // shr eax, 8
+        m_Asm.emit({ 0x48, 0x8B, 0x84, 0xC3 }); // mov rax, [rbx + rax * 8 + write_pages]
+        m_Asm.emit32((uint32_t)m_Offsets.write_pages);
+    }
+    m_Asm.emit({ 0x48, 0x85, 0xC0 }); // test rax, rax
+    const size_t to_slow = m_Asm.jump(Condition::Zero);
+    if (operand.kind == Operand::Kind::Constant) {
+        m_Asm.emit({ 0x88, 0x90 }); // mov [rax + offset], dl
+        m_Asm.emit32(operand.value & 0xFF);
+    } else {
+        m_Asm.emit({ 0x41, 0x0F, 0xB6, 0xCC }); // movzx ecx, r12b
+        m_Asm.emit({ 0x88, 0x14, 0x08 });       // mov [rax + rcx], dl
+    }
+    const size_t to_done = m_Asm.jump();
+
+    m_Asm.bind(to_slow);
+    set_io_cycle();
+    if (operand.kind == Operand::Kind::Constant) {
+        m_Asm.emit({ 0xBE }); // mov esi, imm32
+        m_Asm.emit32(operand.value);
+    } else {
+        m_Asm.emit({ 0x44, 0x89, 0xE6 }); // mov esi, r12d
+    }
+    m_Asm.call((const void*)&write_byte_slow);
+    exit_if_stopping(next_pc);
+    m_Asm.bind(to_done);
+}
+
+// For a register, which is only reached through the slow paths. The instruction's cycles are already in
+// m_PendingCycles (and a page crossing in cycle_count), so its last cycle is one before the two added together
+void BlockTranslator::set_io_cycle()
+{
+    m_Asm.emit({ 0x48, 0x8B }); // mov rax, [rbx + cycle_count]
+    m_Asm.cpu_operand(eax, m_Offsets.cycle_count);
+    m_Asm.emit({ 0x48, 0x05 }); // add rax, pending - 1
+    m_Asm.emit32(m_PendingCycles - 1);
+    m_Asm.emit({ 0x48, 0x89 }); // mov [rbx + io_cycle], rax
+    m_Asm.cpu_operand(eax, m_Offsets.io_cycle);
+}
+
+void BlockTranslator::set_zero_and_negative_from(uint8_t reg)
+{
+    m_Asm.store_byte(reg, m_Offsets.negative_result);
+    m_Asm.store_byte(reg, m_Offsets.zero_result);
+}
+
+// flags = (flags & ~mask) | dl | al << 6, dl being the carry and al the overflow (only when mask includes it)
+void BlockTranslator::assign_flags_from_dl_and_al(uint8_t mask)
+{
+    m_Asm.emit({ 0x0F, 0xB6, 0xD2 }); // movzx edx, dl
+    if (mask & (uint8_t)StatusRegFlag::Overflow) {
+        m_Asm.emit({ 0x0F, 0xB6, 0xC0 }); // movzx eax, al
+        m_Asm.emit({ 0xC1, 0xE0, 0x06 }); // shl eax, 6
+        m_Asm.emit({ 0x09, 0xC2 });       // or edx, eax
+    }
+    m_Asm.load_byte(eax, m_Offsets.flags);
+    m_Asm.emit({ 0x25 }); // and eax, ~mask
+    m_Asm.emit32((uint8_t)~mask);
+    m_Asm.emit({ 0x09, 0xD0 }); // or eax, edx
+    m_Asm.store_byte(eax, m_Offsets.flags);
+}
+
+void BlockTranslator::exit(uint16_t pc)
+{
+    m_Asm.add_qword_imm(m_Offsets.cycle_count, m_PendingCycles);
+    m_Asm.store_imm16(m_Offsets.pc, pc);
+    m_Asm.epilogue();
+}
+
+// Leaves the block if the CPU has been asked to stop by the call that was just made, cycle_count has to count the
+// instruction that made it before it can be compared
+void BlockTranslator::exit_if_stopping(uint16_t next_pc)
+{
+    m_Asm.emit({ 0x48, 0x8B }); // mov rax, [rbx + cycle_count]
+    m_Asm.cpu_operand(eax, m_Offsets.cycle_count);
+    m_Asm.emit({ 0x48, 0x05 }); // add rax, pending
+    m_Asm.emit32(m_PendingCycles);
+    m_Asm.emit({ 0x48, 0x3B }); // cmp rax, [rbx + stop_cycle]
+    m_Asm.cpu_operand(eax, m_Offsets.stop_cycle);
+    const size_t to_continue = m_Asm.jump(Condition::Below);
+    exit(next_pc);
+    m_Asm.bind(to_continue);
+}
+
+void BlockTranslator::branch(const DecodedInstruction& decoded, int32_t flag_disp, uint8_t flag_mask,
+                             bool taken_when_set, uint16_t next_pc)
+{
+    const uint16_t target      = (uint16_t)(next_pc + (int8_t)decoded.operand);
+    const uint8_t taken_cycles = (target & 0xFF00) == (next_pc & 0xFF00) ? 1 : 2;
+
+    if (flag_mask) {
+        m_Asm.test_byte_imm(flag_disp, flag_mask);
+    } else {
+        m_Asm.byte_op_imm(7, flag_disp, 0); // cmp byte [rbx + zero_result], 0
+    }
+    // for Z the byte being zero means the flag is set
+    const bool jump_if_zero = flag_mask ? !taken_when_set : taken_when_set;
+    const size_t to_taken   = m_Asm.jump(jump_if_zero ? Condition::Zero : Condition::NotZero);
+    exit(next_pc);
+
+    m_Asm.bind(to_taken);
+    m_PendingCycles += taken_cycles;
+    exit(target);
+}
+
+bool BlockTranslator::translate_native(const DecodedInstruction& decoded, const CPU6502::Instruction& instruction,
+                                       uint16_t next_pc, bool last)
+{
+    const CPU6502::operation_fn_t op = instruction.operation_fn;
+    const uint8_t base_cycles        = instruction.cycles;
+    const CpuOffsets& cpu            = m_Offsets;
+
+    // the block cache swaps in its own handlers for some instructions (the end of an idle loop) which have to be kept
+    if (decoded.handler != CPU6502::decoded_handler(decoded.opcode)) return false;
+
+    // instructions without an operand
+    struct Implied
+    {
+        CPU6502::operation_fn_t op;
+        enum class Kind { Transfer, Step, SetFlag, ClearFlag, Nop } kind;
+        int32_t from;
+        int32_t to;
+        uint8_t flag = 0;
+    };
+    // CLI isn't here as it has to stop the CPU for an IRQ that was waiting on it
+    const Implied implied[] = {
+        { &CPU6502::tax, Implied::Kind::Transfer, cpu.a, cpu.x },
+        { &CPU6502::tay, Implied::Kind::Transfer, cpu.a, cpu.y },
+        { &CPU6502::txa, Implied::Kind::Transfer, cpu.x, cpu.a },
+        { &CPU6502::tya, Implied::Kind::Transfer, cpu.y, cpu.a },
+        { &CPU6502::tsx, Implied::Kind::Transfer, cpu.s, cpu.x },
+        { &CPU6502::txs, Implied::Kind::Transfer, cpu.x, cpu.s },
+        { &CPU6502::inx, Implied::Kind::Step, cpu.x, 0, 0 },
+        { &CPU6502::iny, Implied::Kind::Step, cpu.y, 0, 0 },
+        { &CPU6502::dex, Implied::Kind::Step, cpu.x, 0, 1 },
+        { &CPU6502::dey, Implied::Kind::Step, cpu.y, 0, 1 },
+        { &CPU6502::sec, Implied::Kind::SetFlag, 0, 0, (uint8_t)StatusRegFlag::Carry },
+        { &CPU6502::sed, Implied::Kind::SetFlag, 0, 0, (uint8_t)StatusRegFlag::Decimal },
+        { &CPU6502::sei, Implied::Kind::SetFlag, 0, 0, (uint8_t)StatusRegFlag::IntDisable },
+        { &CPU6502::clc, Implied::Kind::ClearFlag, 0, 0, (uint8_t)StatusRegFlag::Carry },
+        { &CPU6502::cld, Implied::Kind::ClearFlag, 0, 0, (uint8_t)StatusRegFlag::Decimal },
+        { &CPU6502::clv, Implied::Kind::ClearFlag, 0, 0, (uint8_t)StatusRegFlag::Overflow },
+        { &CPU6502::nop, Implied::Kind::Nop, 0, 0 },
+    };
+    for (const Implied& entry : implied) {
+        if (entry.op != op) continue;
+
+        m_PendingCycles += base_cycles;
+        switch (entry.kind) {
+            case Implied::Kind::Transfer:
+                m_Asm.load_byte(eax, entry.from);
+                m_Asm.store_byte(eax, entry.to);
+                // txs is the one transfer that leaves the flags alone
+                if (op != &CPU6502::txs) set_zero_and_negative_from(eax);
+                break;
+            case Implied::Kind::Step:
+                m_Asm.inc_byte(entry.from, entry.flag);
+                m_Asm.load_byte(eax, entry.from);
+                set_zero_and_negative_from(eax);
+                break;
+            case Implied::Kind::SetFlag: m_Asm.byte_op_imm(1, cpu.flags, entry.flag); break;
+            case Implied::Kind::ClearFlag: m_Asm.byte_op_imm(4, cpu.flags, (uint8_t)~entry.flag); break;
+            case Implied::Kind::Nop: break;
+        }
+        if (last) exit(next_pc);
+        return true;
+    }
+
+    // branches are always the end of a block
+    struct Branch
+    {
+        CPU6502::operation_fn_t op;
+        int32_t flag_disp;
+        uint8_t flag_mask; // 0 for Z which is stored as the result it came from
+        bool taken_when_set;
+    };
+    const Branch branches[] = {
+        { &CPU6502::bcc, cpu.flags, (uint8_t)StatusRegFlag::Carry, false },
+        { &CPU6502::bcs, cpu.flags, (uint8_t)StatusRegFlag::Carry, true },
+        { &CPU6502::bne, cpu.zero_result, 0, false },
+        { &CPU6502::beq, cpu.zero_result, 0, true },
+        { &CPU6502::bpl, cpu.negative_result, (uint8_t)StatusRegFlag::Negative, false },
+        { &CPU6502::bmi, cpu.negative_result, (uint8_t)StatusRegFlag::Negative, true },
+        { &CPU6502::bvc, cpu.flags, (uint8_t)StatusRegFlag::Overflow, false },
+        { &CPU6502::bvs, cpu.flags, (uint8_t)StatusRegFlag::Overflow, true },
+    };
+    for (const Branch& entry : branches) {
+        if (entry.op != op) continue;
+
+        m_PendingCycles += base_cycles;
+        branch(decoded, entry.flag_disp, entry.flag_mask, entry.taken_when_set, next_pc);
+        return true;
+    }
+
+    if (op == &CPU6502::jmp && instruction.mode == AddressingMode::Absolute) {
+        m_PendingCycles += base_cycles;
+        exit(decoded.operand);
+        return true;
+    }
+
+    const bool load  = op == &CPU6502::lda || op == &CPU6502::ldx || op == &CPU6502::ldy;
+    const bool store = op == &CPU6502::sta || op == &CPU6502::stx || op == &CPU6502::sty;
+    const bool logic = op == &CPU6502::and_op || op == &CPU6502::ora || op == &CPU6502::eor;
+    const bool carry = op == &CPU6502::adc || op == &CPU6502::sbc;
+    const bool cmp   = op == &CPU6502::cmp || op == &CPU6502::cpx || op == &CPU6502::cpy;
+    const bool step  = op == &CPU6502::inc || op == &CPU6502::dec;
+    if (!load && !store && !logic && !carry && !cmp && !step) return false;
+
+    // work out where the operand is before emitting anything so unsupported addressing modes can still be called
+    const AddressingMode mode = instruction.mode;
+    const bool supported_mode = mode == AddressingMode::Immediate || mode == AddressingMode::ZeroPage ||
+                                mode == AddressingMode::Absolute || mode == AddressingMode::ZeroPageX ||
+                                mode == AddressingMode::ZeroPageY || mode == AddressingMode::AbsoluteX ||
+                                mode == AddressingMode::AbsoluteY;
+    if (!supported_mode || (step && mode == AddressingMode::Immediate)) return false;
+
+    m_PendingCycles += base_cycles;
+    const Operand operand = *address(instruction, decoded.operand);
+
+    const auto register_of = [&](CPU6502::operation_fn_t a, CPU6502::operation_fn_t x) {
+        return op == a ? cpu.a : op == x ? cpu.x : cpu.y;
+    };
+
+    // the extra cycle when indexing carries into the high byte, added without branching like the interpreter
+    if (instruction.page_cross_penalty) {
+        m_Asm.emit({ 0x44, 0x89, 0xE0 }); // mov eax, r12d
+        m_Asm.emit({ 0x35 });             // xor eax, operand
+        m_Asm.emit32(decoded.operand);
+        m_Asm.emit({ 0xA9 }); // test eax, 0xFF00
+        m_Asm.emit32(0xFF00);
+        m_Asm.emit({ 0x0F, 0x95, 0xC0 }); // setnz al
+        m_Asm.emit({ 0x0F, 0xB6, 0xC0 }); // movzx eax, al
+        m_Asm.add_qword_rax(cpu.cycle_count);
+    }
+
+    if (load) {
+        read(operand);
+        const int32_t reg = register_of(&CPU6502::lda, &CPU6502::ldx);
+        m_Asm.store_byte(eax, reg);
+        set_zero_and_negative_from(eax);
+    } else if (store) {
+        m_Asm.load_byte(edx, register_of(&CPU6502::sta, &CPU6502::stx));
+        write(operand, next_pc);
+    } else if (logic) {
+        read(operand);
+        const uint8_t opcode = op == &CPU6502::and_op ? 0x22 : op == &CPU6502::ora ? 0x0A : 0x32;
+        m_Asm.emit({ opcode }); // and/or/xor al, [rbx + a]
+        m_Asm.cpu_operand(eax, cpu.a);
+        m_Asm.store_byte(eax, cpu.a);
+        set_zero_and_negative_from(eax);
+    } else if (carry) {
+        // the 6502's carry in and out match x86's adc, and sbb's borrow is the inverse of the 6502's carry
+        read(operand);
+        m_Asm.load_byte(edx, cpu.flags);
+        if (op == &CPU6502::sbc) m_Asm.emit({ 0xF6, 0xD2 }); // not dl
+        m_Asm.emit({ 0xD0, 0xEA });                           // shr dl, 1
+        m_Asm.load_byte(ecx, cpu.a);
+        m_Asm.emit({ op == &CPU6502::adc ? (uint8_t)0x10 : (uint8_t)0x18, 0xC1 }); // adc/sbb cl, al
+        m_Asm.emit({ 0x0F, op == &CPU6502::adc ? (uint8_t)0x92 : (uint8_t)0x93, 0xC2 }); // setc/setnc dl
+        m_Asm.emit({ 0x0F, 0x90, 0xC0 });                                              // seto al
+        m_Asm.store_byte(ecx, cpu.a);
+        set_zero_and_negative_from(ecx);
+        assign_flags_from_dl_and_al((uint8_t)StatusRegFlag::Carry | (uint8_t)StatusRegFlag::Overflow);
+    } else if (cmp) {
+        read(operand);
+        m_Asm.load_byte(ecx, register_of(&CPU6502::cmp, &CPU6502::cpx));
+        m_Asm.emit({ 0x28, 0xC1 });       // sub cl, al
+        m_Asm.emit({ 0x0F, 0x93, 0xC2 }); // setnc dl
+        set_zero_and_negative_from(ecx);
+        assign_flags_from_dl_and_al((uint8_t)StatusRegFlag::Carry);
+    } else {
+        read(operand);
+        m_Asm.emit({ 0xFE, op == &CPU6502::inc ? (uint8_t)0xC0 : (uint8_t)0xC8 }); // inc/dec al
+        m_Asm.emit({ 0x89, 0xC2 });                                               // mov edx, eax
+        set_zero_and_negative_from(edx);
+        write(operand, next_pc);
+    }
+
+    if (last) exit(next_pc);
+    return true;
+}
+
+// Anything that isn't translated runs the interpreter's handler, which expects pc to already be past the instruction
+// and cycle_count to be up to date (skipping an idle loop works out how far it can go from it)
+void BlockTranslator::translate_call(const DecodedInstruction& decoded, uint16_t next_pc, bool last)
+{
+    if (m_PendingCycles) {
+        m_Asm.add_qword_imm(m_Offsets.cycle_count, m_PendingCycles);
+        m_PendingCycles = 0;
+    }
+    m_Asm.store_imm16(m_Offsets.pc, next_pc);
+    m_Asm.emit({ 0xBE }); // mov esi, operand
+    m_Asm.emit32(decoded.operand);
+    m_Asm.call((const void*)decoded.handler);
+    m_Asm.emit({ 0x0F, 0xB6, 0xC0 }); // movzx eax, al
+    m_Asm.add_qword_rax(m_Offsets.cycle_count);
+
+    if (last) {
+        // the handler has already moved pc wherever it's going
+        m_Asm.epilogue();
+        return;
+    }
+    exit_if_stopping(next_pc);
+}
+
+std::unique_ptr<Recompiler> Recompiler::create(CPU6502& cpu)
+{
+    void* arena = mmap(nullptr, default_arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) {
+        info_message("couldn't allocate memory for the recompiler");
+        return nullptr;
+    }
+    return std::unique_ptr<Recompiler>(new Recompiler(cpu, (uint8_t*)arena, default_arena_size));
+}
+
+Recompiler::~Recompiler()
+{
+    munmap(m_Arena, m_ArenaSize);
+}
+
+NativeBlock Recompiler::compile(std::span<const DecodedInstruction> block, uint16_t pc)
+{
+    m_Code.clear();
+    const CpuOffsets offsets = CpuOffsets::of(m_Cpu);
+    BlockTranslator translator(m_Code, offsets);
+    const uint16_t max_cycles = translator.translate(block, pc);
+
+    if (m_ArenaUsed + m_Code.size() > m_ArenaSize) {
+        m_Cpu.block_cache.drop_native_blocks();
+        m_ArenaUsed = 0;
+    }
+
+    // the arena is only ever writable or executable, never both
+    if (mprotect(m_Arena, m_ArenaSize, PROT_READ | PROT_WRITE) != 0) return {};
+    uint8_t* entry = m_Arena + m_ArenaUsed;
+    memcpy(entry, m_Code.data(), m_Code.size());
+    m_ArenaUsed += (m_Code.size() + 15) & ~(size_t)15;
+    if (mprotect(m_Arena, m_ArenaSize, PROT_READ | PROT_EXEC) != 0) return {};
+
+    NativeBlock native;
+    native.entry      = (void (*)(CPU6502&))entry;
+    native.max_cycles = max_cycles;
+    return native;
+}
+
+#else
+
+std::unique_ptr<Recompiler> Recompiler::create(CPU6502&)
+{
+    return nullptr;
+}
+
+Recompiler::~Recompiler() = default;
+
+NativeBlock Recompiler::compile(std::span<const DecodedInstruction>, uint16_t)
+{
+    return {};
+}
+
+#endif
+
+Recompiler::Recompiler(CPU6502& cpu, uint8_t* arena, size_t arena_size)
+    : m_Cpu(cpu), m_Arena(arena), m_ArenaSize(arena_size)
+{
+}
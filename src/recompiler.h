@@ -0,0 +1,40 @@
+#pragma once
+
+#include "block_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+class CPU6502;
+
+// Translates blocks from the block cache into x86-64 machine code. Instructions that are simple enough are emitted
+// inline with memory accesses going through the page tables, anything else calls the interpreter's handler for it, so
+// every block can be translated and the result matches the interpreter cycle for cycle.
+// Translated code stops early when a write goes anywhere other than plain memory (registers, mapper bank switches,
+// memory code was decoded from) and the CPU has been asked to stop, which is also how it gets out to take interrupts.
+// Only available on x86-64 Linux and macOS, create() returns null everywhere else.
+class Recompiler
+{
+public:
+    static std::unique_ptr<Recompiler> create(CPU6502& cpu);
+    ~Recompiler();
+    Recompiler(const Recompiler&)            = delete;
+    Recompiler& operator=(const Recompiler&) = delete;
+
+    // a block is translated once the interpreter has run it this many times
+    static constexpr uint16_t hot_block_runs = 16;
+
+    NativeBlock compile(std::span<const DecodedInstruction> block, uint16_t pc);
+
+private:
+    Recompiler(CPU6502& cpu, uint8_t* arena, size_t arena_size);
+
+    CPU6502& m_Cpu;
+    uint8_t* m_Arena;
+    size_t m_ArenaSize;
+    size_t m_ArenaUsed = 0;
+    std::vector<uint8_t> m_Code; // the block being translated, copied into the arena once it's complete
+};
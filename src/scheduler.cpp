@@ -0,0 +1,49 @@
+#include "scheduler.h"
+
+#include <algorithm>
+
+bool Scheduler::later(const Event& lhs, const Event& rhs)
+{
+    return lhs.cycle != rhs.cycle ? lhs.cycle > rhs.cycle : lhs.sequence > rhs.sequence;
+}
+
+// There's one event per handler and only a handful of handlers, so finding one is a short linear search and removing
+// it just rebuilds the heap
+void Scheduler::remove(EventHandler* handler)
+{
+    const auto it =
+        std::find_if(m_Events.begin(), m_Events.end(), [&](const Event& e) { return e.handler == handler; });
+    if (it == m_Events.end()) return;
+    m_Events.erase(it);
+    std::make_heap(m_Events.begin(), m_Events.end(), later);
+}
+
+void Scheduler::schedule(EventHandler* handler, uint64_t cycle)
+{
+    remove(handler);
+    m_Events.push_back({ cycle, m_NextSequence++, handler });
+    std::push_heap(m_Events.begin(), m_Events.end(), later);
+
+    // the CPU may be part way through running to a later stop
+    m_StopCycle = std::min(m_StopCycle, cycle);
+}
+
+void Scheduler::cancel(EventHandler* handler)
+{
+    remove(handler);
+}
+
+bool Scheduler::scheduled(const EventHandler* handler) const
+{
+    return std::any_of(m_Events.begin(), m_Events.end(), [&](const Event& e) { return e.handler == handler; });
+}
+
+void Scheduler::run_due_events_slow()
+{
+    while (!m_Events.empty() && m_Events.front().cycle <= m_CycleCount) {
+        std::pop_heap(m_Events.begin(), m_Events.end(), later);
+        const Event event = m_Events.back();
+        m_Events.pop_back();
+        event.handler->run_event(event.cycle);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Implemented by anything that needs to do something at a particular cycle (the PPU raising an NMI at the start of
+// vblank, the APU frame counter, a mapper's IRQ counter)
+class EventHandler
+{
+public:
+    virtual ~EventHandler() = default;
+
+    // cycle is when the event was scheduled for, which the CPU may have run slightly past
+    virtual void run_event(uint64_t cycle) = 0;
+};
+
+// Keeps the next event for each handler in a min-heap ordered by CPU cycle, so nothing has to be ticked every cycle.
+// Components work out what they've been doing since they last ran when the CPU touches their registers (now() is the
+// master clock) and schedule an event for the next thing that can't wait for that, like an interrupt. The CPU stops
+// running at the next event, so scheduling one sooner lowers stop_cycle.
+class Scheduler
+{
+public:
+    static constexpr uint64_t no_event = std::numeric_limits<uint64_t>::max();
+
+    Scheduler(const uint64_t& cycle_count, uint64_t& stop_cycle) : m_CycleCount(cycle_count), m_StopCycle(stop_cycle) {}
+    Scheduler(const Scheduler&)            = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    uint64_t now() const { return m_CycleCount; }
+
+    // Each handler has at most one event waiting, scheduling another replaces it
+    void schedule(EventHandler* handler, uint64_t cycle);
+    void cancel(EventHandler* handler);
+    bool scheduled(const EventHandler* handler) const;
+
+    uint64_t next_event_cycle() const { return m_Events.empty() ? no_event : m_Events.front().cycle; }
+
+    // Runs everything due by now() in the order it was scheduled for, including anything those schedule
+    void run_due_events()
+    {
+        if (next_event_cycle() <= m_CycleCount) [[unlikely]] {
+            run_due_events_slow();
+        }
+    }
+
+private:
+    struct Event
+    {
+        uint64_t cycle;
+        uint64_t sequence; // events due on the same cycle run in the order they were scheduled
+        EventHandler* handler;
+    };
+    static bool later(const Event& lhs, const Event& rhs);
+
+    void run_due_events_slow();
+    void remove(EventHandler* handler);
+
+    const uint64_t& m_CycleCount;
+    uint64_t& m_StopCycle;
+    std::vector<Event> m_Events; // a heap with the next event at the front
+    uint64_t m_NextSequence = 0;
+};
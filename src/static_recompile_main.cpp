@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "cartridge.h"
+#include "log.h"
+#include "static_recompiler.h"
+
+// Translates an NROM rom to a C++ file that can be linked into the emulator, see recompile_nrom()
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        fmt::print("usage: <program_name> <path_to_rom> <output_cpp_file> <name>\n");
+        return EXIT_FAILURE;
+    }
+
+    // the name becomes part of the generated identifiers
+    const std::string_view name = argv[3];
+    const auto identifier_char  = [](char c) { return std::isalnum((unsigned char)c) || c == '_'; };
+    const bool valid_name       = !name.empty() && !std::isdigit((unsigned char)name.front()) &&
+                            std::all_of(name.begin(), name.end(), identifier_char);
+    if (!valid_name) {
+        info_message("{} isn't a valid C++ identifier", name);
+        return EXIT_FAILURE;
+    }
+
+    std::optional<Cartridge> cart = Cartridge::from_file(argv[1]);
+    if (!cart.has_value()) {
+        info_message("failed to load cart");
+        return EXIT_FAILURE;
+    }
+
+    const std::optional<std::string> source = recompile_nrom(*cart, name);
+    if (!source.has_value()) return EXIT_FAILURE;
+
+    FILE* file = fopen(argv[2], "w");
+    if (!file) {
+        info_message("fopen failed: {}", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    const bool written = fwrite(source->data(), 1, source->size(), file) == source->size();
+    if (fclose(file) != 0 || !written) {
+        info_message("couldn't write {}", argv[2]);
+        return EXIT_FAILURE;
+    }
+}
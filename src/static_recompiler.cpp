@@ -0,0 +1,451 @@
+#include "static_recompiler.h"
+
+#include "cpu.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+uint64_t hash_prg(std::span<const uint8_t> prg)
+{
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325;
+    for (uint8_t byte : prg) {
+        hash = (hash ^ byte) * 0x100000001B3;
+    }
+    return hash;
+}
+
+// A function local so it's there for programs registering themselves before main, whatever order that happens in
+static std::vector<StaticProgram>& static_programs()
+{
+    static std::vector<StaticProgram> programs;
+    return programs;
+}
+
+bool register_static_program(const StaticProgram& program)
+{
+    static_programs().push_back(program);
+    return true;
+}
+
+const StaticProgram* find_static_program(std::span<const uint8_t> prg)
+{
+    if (static_programs().empty()) return nullptr;
+
+    const uint64_t hash = hash_prg(prg);
+    for (const StaticProgram& program : static_programs()) {
+        if (program.prg_hash == hash) return &program;
+    }
+    return nullptr;
+}
+
+namespace
+{
+struct FoundInstruction
+{
+    uint8_t opcode;
+    uint16_t operand;
+};
+
+using Op = CPU6502::operation_fn_t;
+
+bool is_branch(Op op)
+{
+    return op == &CPU6502::bcc || op == &CPU6502::bcs || op == &CPU6502::beq || op == &CPU6502::bne ||
+           op == &CPU6502::bmi || op == &CPU6502::bpl || op == &CPU6502::bvc || op == &CPU6502::bvs;
+}
+
+uint16_t branch_target(uint16_t next_pc, uint16_t operand)
+{
+    return (uint16_t)(next_pc + (int8_t)operand);
+}
+
+// Everything reachable from the vectors, by address
+std::map<uint16_t, FoundInstruction> find_code(std::span<const uint8_t> prg)
+{
+    // NROM-128 is mirrored into both halves of $8000-$FFFF
+    const auto read = [&](uint32_t addr) { return prg[(addr - 0x8000) % prg.size()]; };
+    const auto read_word = [&](uint32_t addr) { return (uint16_t)(read(addr) | (read(addr + 1) << 8)); };
+
+    std::map<uint16_t, FoundInstruction> found;
+    std::vector<uint16_t> to_visit = { read_word(0xFFFA), read_word(0xFFFC), read_word(0xFFFE) };
+    while (!to_visit.empty()) {
+        const uint16_t pc = to_visit.back();
+        to_visit.pop_back();
+        if (pc < 0x8000 || found.contains(pc)) continue;
+
+        const uint8_t opcode                    = read(pc);
+        const CPU6502::Instruction& instruction = CPU6502::instruction(opcode);
+        if (instruction.operation_fn == &CPU6502::illegal_opcode || pc + instruction.bytes > 0x10000) continue;
+
+        uint16_t operand = 0;
+        if (instruction.bytes == 2) operand = read(pc + 1u);
+        if (instruction.bytes == 3) operand = read_word(pc + 1u);
+        found[pc] = { opcode, operand };
+
+        const Op op            = instruction.operation_fn;
+        const uint16_t next_pc = (uint16_t)(pc + instruction.bytes);
+        if (is_branch(op)) {
+            to_visit.push_back(branch_target(next_pc, operand));
+            to_visit.push_back(next_pc);
+        } else if (op == &CPU6502::jmp) {
+            if (instruction.mode == AddressingMode::Absolute) to_visit.push_back(operand);
+        } else if (op == &CPU6502::jsr) {
+            to_visit.push_back(operand);
+            to_visit.push_back(next_pc);
+        } else if (op == &CPU6502::brk) {
+            // RTI comes back past the padding byte
+            to_visit.push_back((uint16_t)(next_pc + 1));
+        } else if (op != &CPU6502::rts && op != &CPU6502::rti) {
+            to_visit.push_back(next_pc);
+        }
+    }
+    return found;
+}
+
+class CodeWriter
+{
+public:
+    CodeWriter(const std::map<uint16_t, FoundInstruction>& found, std::string& out) : m_Found(found), m_Out(out) {}
+
+    void instruction(uint16_t pc, const FoundInstruction& found, std::optional<uint16_t> following);
+
+private:
+    template <typename... Args>
+    void line(fmt::format_string<Args...> format, Args&&... args)
+    {
+        m_Out += "    ";
+        fmt::format_to(std::back_inserter(m_Out), format, std::forward<Args>(args)...);
+        m_Out += '\n';
+    }
+
+    std::string address(const CPU6502::Instruction& instruction, uint16_t pc, uint16_t operand) const;
+    std::string read(const CPU6502::Instruction& instruction, uint16_t pc, uint16_t operand) const;
+    void add_cycles(const CPU6502::Instruction& instruction);
+    void set_io_cycle(const CPU6502::Instruction& instruction, uint16_t operand);
+    void jump(uint16_t target, std::optional<uint16_t> following, const char* indent = "");
+    bool translate_inline(const CPU6502::Instruction& instruction, uint16_t pc, uint16_t operand);
+
+    const std::map<uint16_t, FoundInstruction>& m_Found;
+    std::string& m_Out;
+};
+
+// The data address the interpreter's addressing mode would give
+std::string CodeWriter::address(const CPU6502::Instruction& instruction, uint16_t pc, uint16_t operand) const
+{
+    const AddressingMode mode = instruction.mode;
+    if (mode == AddressingMode::Immediate || mode == AddressingMode::Relative) return fmt::format("0x{:04X}", pc + 1);
+    if (mode == AddressingMode::ZeroPage) return fmt::format("0x{:02X}", operand);
+    if (mode == AddressingMode::Absolute) return fmt::format("0x{:04X}", operand);
+    if (mode == AddressingMode::ZeroPageX) return fmt::format("cpu.resolve_zpx(0x{:02X})", operand);
+    if (mode == AddressingMode::ZeroPageY) return fmt::format("cpu.resolve_zpy(0x{:02X})", operand);
+    if (mode == AddressingMode::AbsoluteX) return fmt::format("cpu.resolve_absx(0x{:04X})", operand);
+    if (mode == AddressingMode::AbsoluteY) return fmt::format("cpu.resolve_absy(0x{:04X})", operand);
+    if (mode == AddressingMode::IndirectX) return fmt::format("cpu.resolve_indx(0x{:02X})", operand);
+    if (mode == AddressingMode::IndirectY) return fmt::format("cpu.resolve_indy(0x{:02X})", operand);
+    if (mode == AddressingMode::Indirect) return fmt::format("cpu.resolve_ind(0x{:04X})", operand);
+    return "0";
+}
+
+std::string CodeWriter::read(const CPU6502::Instruction& instruction, uint16_t pc, uint16_t operand) const
+{
+    if (instruction.mode == AddressingMode::Immediate) return fmt::format("0x{:02X}", operand);
+    return fmt::format("cpu.memory.read_byte({})", address(instruction, pc, operand));
+}
+
+void CodeWriter::add_cycles(const CPU6502::Instruction& instruction)
+{
+    if (instruction.page_cross_penalty) {
+        line("cpu.cycle_count += {} + cpu.page_crossed;", instruction.cycles);
+    } else {
+        line("cpu.cycle_count += {};", instruction.cycles);
+    }
+}
+
+// Sets io_cycle like the interpreter does before an instruction that can reach a register, which an address that's
+// known to be in RAM or ROM can't
+void CodeWriter::set_io_cycle(const CPU6502::Instruction& instruction, uint16_t operand)
+{
+    const AddressingMode mode = instruction.mode;
+    const bool indexed        = mode == AddressingMode::AbsoluteX || mode == AddressingMode::AbsoluteY;
+    if (!can_reach_io(mode)) return;
+    if (mode == AddressingMode::Absolute && (operand < 0x2000 || operand >= 0x8000)) return;
+    if (indexed && (operand + 0xFF < 0x2000 || operand >= 0x8000)) return;
+
+    // the page crossing worked out up front, as the call that resolves the address is also the one that accesses it
+    std::string page_crossed;
+    if (instruction.page_cross_penalty && indexed) {
+        page_crossed = fmt::format(" + ((0x{:02X} + cpu.registers.{}) >> 8)",
+                                   operand & 0xFF,
+                                   mode == AddressingMode::AbsoluteX ? 'x' : 'y');
+    } else if (instruction.page_cross_penalty) {
+        page_crossed = fmt::format(" + ((cpu.memory.read_byte(0x{:02X}) + cpu.registers.y) >> 8)", operand);
+    }
+    line("cpu.io_cycle = cpu.cycle_count + {}{};", instruction.cycles - 1, page_crossed);
+}
+
+// Carries on at target, going back through the dispatch switch (which checks whether the CPU has to stop) if it wasn't
+// found. following is the instruction written out next, which a jump to can just fall through to.
+void CodeWriter::jump(uint16_t target, std::optional<uint16_t> following, const char* indent)
+{
+    if (!m_Found.contains(target)) {
+        line("{}cpu.registers.pc = 0x{:04X};", indent, target);
+        line("{}goto dispatch;", indent);
+        return;
+    }
+    line("{}if (cpu.cycle_count >= cpu.stop_cycle) {{", indent);
+    line("{}    cpu.registers.pc = 0x{:04X};", indent, target);
+    line("{}    return true;", indent);
+    line("{}}}", indent);
+    if (following != target) line("{}goto l_{:04X};", indent, target);
+}
+
+// Loads, stores and anything else that only touches registers and memory are written out directly, leaving the
+// compiler free to keep registers in registers and fold the constant addresses in
+bool CodeWriter::translate_inline(const CPU6502::Instruction& instruction, uint16_t pc, uint16_t operand)
+{
+    const Op op       = instruction.operation_fn;
+    const auto reg_of = [&](Op a, Op x) {
+        return op == a ? "cpu.registers.a" : op == x ? "cpu.registers.x" : "cpu.registers.y";
+    };
+
+    if (op == &CPU6502::lda || op == &CPU6502::ldx || op == &CPU6502::ldy) {
+        const char* reg = reg_of(&CPU6502::lda, &CPU6502::ldx);
+        line("{} = {};", reg, read(instruction, pc, operand));
+        line("cpu.registers.p.set_zero_and_negative_from({});", reg);
+        return true;
+    }
+    if (op == &CPU6502::sta || op == &CPU6502::stx || op == &CPU6502::sty) {
+        line("cpu.memory.write_byte({}, {});", address(instruction, pc, operand), reg_of(&CPU6502::sta, &CPU6502::stx));
+        return true;
+    }
+    if (op == &CPU6502::and_op || op == &CPU6502::ora || op == &CPU6502::eor) {
+        const char logic = op == &CPU6502::and_op ? '&' : op == &CPU6502::ora ? '|' : '^';
+        line("cpu.registers.a {}= {};", logic, read(instruction, pc, operand));
+        line("cpu.registers.p.set_zero_and_negative_from(cpu.registers.a);");
+        return true;
+    }
+
+    struct Transfer
+    {
+        Op op;
+        const char* from;
+        const char* to;
+    };
+    const Transfer transfers[] = {
+        { &CPU6502::tax, "a", "x" }, { &CPU6502::tay, "a", "y" }, { &CPU6502::txa, "x", "a" },
+        { &CPU6502::tya, "y", "a" }, { &CPU6502::tsx, "s", "x" }, { &CPU6502::txs, "x", "s" },
+    };
+    for (const Transfer& transfer : transfers) {
+        if (transfer.op != op) continue;
+        line("cpu.registers.{} = cpu.registers.{};", transfer.to, transfer.from);
+        if (op != &CPU6502::txs) line("cpu.registers.p.set_zero_and_negative_from(cpu.registers.{});", transfer.to);
+        return true;
+    }
+
+    struct Step
+    {
+        Op op;
+        const char* reg;
+        char sign;
+    };
+    const Step steps[] = {
+        { &CPU6502::inx, "x", '+' },
+        { &CPU6502::iny, "y", '+' },
+        { &CPU6502::dex, "x", '-' },
+        { &CPU6502::dey, "y", '-' },
+    };
+    for (const Step& step : steps) {
+        if (step.op != op) continue;
+        line("cpu.registers.{0} = (uint8_t)(cpu.registers.{0} {1} 1);", step.reg, step.sign);
+        line("cpu.registers.p.set_zero_and_negative_from(cpu.registers.{});", step.reg);
+        return true;
+    }
+
+    // not CLI, which has to check for a waiting IRQ
+    struct Flag
+    {
+        Op op;
+        const char* call;
+    };
+    const Flag flags[] = {
+        { &CPU6502::sec, "set_carry_bit" },        { &CPU6502::clc, "clear_carry_flag" },
+        { &CPU6502::sed, "set_decimal_flag" },     { &CPU6502::cld, "clear_decimal_flag" },
+        { &CPU6502::sei, "set_int_disable_flag" }, { &CPU6502::clv, "clear_overflow_flag" },
+    };
+    for (const Flag& flag : flags) {
+        if (flag.op != op) continue;
+        line("cpu.registers.p.{}();", flag.call);
+        return true;
+    }
+
+    return op == &CPU6502::nop;
+}
+
+void CodeWriter::instruction(uint16_t pc, const FoundInstruction& found, std::optional<uint16_t> following)
+{
+    const CPU6502::Instruction& instruction = CPU6502::instruction(found.opcode);
+    const Op op                             = instruction.operation_fn;
+    const uint16_t next_pc                  = (uint16_t)(pc + instruction.bytes);
+
+    fmt::format_to(std::back_inserter(m_Out), "l_{:04X}: // {}\n", pc, instruction.name);
+
+    if (is_branch(op)) {
+        const char* conditions[][2] = {
+            { "!cpu.registers.p.carry_bit_set()", "cpu.registers.p.carry_bit_set()" },
+            { "!cpu.registers.p.zero_flag_set()", "cpu.registers.p.zero_flag_set()" },
+            { "!cpu.registers.p.negative_flag_set()", "cpu.registers.p.negative_flag_set()" },
+            { "!cpu.registers.p.overflow_flag_set()", "cpu.registers.p.overflow_flag_set()" },
+        };
+        const size_t flag = op == &CPU6502::bcc || op == &CPU6502::bcs   ? 0
+                            : op == &CPU6502::bne || op == &CPU6502::beq ? 1
+                            : op == &CPU6502::bpl || op == &CPU6502::bmi ? 2
+                                                                         : 3;
+        const bool when_set = op == &CPU6502::bcs || op == &CPU6502::beq || op == &CPU6502::bmi || op == &CPU6502::bvs;
+        const uint16_t target = branch_target(next_pc, found.operand);
+
+        add_cycles(instruction);
+        line("if ({}) {{", conditions[flag][when_set]);
+        line("    cpu.cycle_count += {};", (target & 0xFF00) == (next_pc & 0xFF00) ? 1 : 2);
+        jump(target, std::nullopt, "    ");
+        line("}}");
+        jump(next_pc, following);
+        return;
+    }
+
+    if (op == &CPU6502::jmp && instruction.mode == AddressingMode::Absolute) {
+        add_cycles(instruction);
+        jump(found.operand, following);
+        return;
+    }
+
+    set_io_cycle(instruction, found.operand);
+    if (translate_inline(instruction, pc, found.operand)) {
+        add_cycles(instruction);
+        jump(next_pc, following);
+        return;
+    }
+
+    // everything else calls the interpreter's implementation, which expects pc to already be past the instruction
+    std::string name = instruction.name;
+    std::transform(name.begin(), name.end(), name.begin(), [](char c) { return (char)std::tolower(c); });
+    if (op == &CPU6502::and_op) name = "and_op";
+    if (instruction.mode == AddressingMode::Accumulator) name += "_acc";
+
+    line("cpu.registers.pc = 0x{:04X};", next_pc);
+    line("cpu.cycle_count += cpu.{}({}) + {};", name, address(instruction, pc, found.operand), instruction.cycles);
+    // in a statement of its own as it's only set once the call has resolved the address
+    if (instruction.page_cross_penalty) line("cpu.cycle_count += cpu.page_crossed;");
+    if (op == &CPU6502::jsr) {
+        jump(found.operand, following);
+    } else if (op == &CPU6502::jmp || op == &CPU6502::rts || op == &CPU6502::rti || op == &CPU6502::brk) {
+        line("goto dispatch;");
+    } else {
+        jump(next_pc, following);
+    }
+}
+} // namespace
+
+std::optional<std::string> recompile_nrom(const Cartridge& cart, std::string_view name)
+{
+    if (cart.get_mapper_number() != 0) {
+        info_message("only NROM (mapper 0) games can be recompiled, this uses mapper {}", cart.get_mapper_number());
+        return std::nullopt;
+    }
+
+    const std::span<const uint8_t> prg                 = cart.get_program_data();
+    const std::map<uint16_t, FoundInstruction> found = find_code(prg);
+
+    std::string out;
+    fmt::format_to(std::back_inserter(out),
+                   "// Generated by nes-static-recompile, {} instructions found from the vectors\n"
+                   "#include \"cpu.h\"\n"
+                   "#include \"static_recompiler.h\"\n"
+                   "\n"
+                   "static bool run_{}(CPU6502& cpu)\n"
+                   "{{\n"
+                   "    bool entered = false;\n"
+                   "    goto start;\n"
+                   "dispatch:\n"
+                   "    if (cpu.cycle_count >= cpu.stop_cycle) return true;\n"
+                   "    entered = true;\n"
+                   "start:\n"
+                   "    switch (cpu.registers.pc) {{\n",
+                   found.size(),
+                   name);
+    for (const auto& [pc, instruction] : found) {
+        fmt::format_to(std::back_inserter(out), "    case 0x{0:04X}: goto l_{0:04X};\n", pc);
+    }
+    out += "    default: return entered;\n"
+           "    }\n"
+           "\n";
+
+    CodeWriter writer(found, out);
+    for (auto it = found.begin(); it != found.end(); ++it) {
+        const auto next = std::next(it);
+        writer.instruction(it->first, it->second, next == found.end() ? std::nullopt : std::optional(next->first));
+    }
+
+    fmt::format_to(std::back_inserter(out),
+                   "}}\n"
+                   "\n"
+                   "[[maybe_unused]] static const bool registered_{0} =\n"
+                   "    register_static_program(StaticProgram{{ \"{0}\", 0x{1:016X}, &run_{0} }});\n",
+                   name,
+                   hash_prg(prg));
+    return out;
+}
+
+static std::optional<std::string> find_difference(const CPU6502& recompiled, const CPU6502& interpreted)
+{
+    const CpuRegisters& lhs = recompiled.registers;
+    const CpuRegisters& rhs = interpreted.registers;
+    if (recompiled.cycle_count != interpreted.cycle_count || lhs.pc != rhs.pc || lhs.a != rhs.a || lhs.x != rhs.x ||
+        lhs.y != rhs.y || lhs.s != rhs.s || !(lhs.p == rhs.p)) {
+        return fmt::format("registers differ at cycle {}\n"
+                           "recompiled:  PC:{:04X} A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X} CYC:{}\n"
+                           "interpreted: PC:{:04X} A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X} CYC:{}\n",
+                           interpreted.cycle_count,
+                           lhs.pc, lhs.a, lhs.x, lhs.y, lhs.p.value(), lhs.s, recompiled.cycle_count,
+                           rhs.pc, rhs.a, rhs.x, rhs.y, rhs.p.value(), rhs.s, interpreted.cycle_count);
+    }
+
+    // RAM and PRG-RAM
+    for (uint32_t addr = 0; addr < 0x8000; addr = addr == 0x7FF ? 0x6000 : addr + 1) {
+        const uint8_t expected = interpreted.memory.peek_byte((uint16_t)addr);
+        const uint8_t actual   = recompiled.memory.peek_byte((uint16_t)addr);
+        if (actual != expected) {
+            return fmt::format("memory differs at ${:04X} at cycle {}: recompiled {:02X}, interpreted {:02X}\n",
+                               addr,
+                               interpreted.cycle_count,
+                               actual,
+                               expected);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> verify_static_program(std::shared_ptr<const Cartridge> cart, const StaticProgram& program,
+                                                 uint64_t cycles)
+{
+    CPU6502 recompiled;
+    CPU6502 interpreted;
+    if (!recompiled.load_cartridge(cart) || !interpreted.load_cartridge(cart)) return "couldn't load the cartridge\n";
+    recompiled.static_program     = &program;
+    interpreted.use_static_program = false;
+    recompiled.reset();
+    interpreted.reset();
+
+    while (interpreted.cycle_count < cycles) {
+        // every instruction takes at least one cycle, so this runs exactly one
+        interpreted.run_for_cycles(1);
+        recompiled.run_until(interpreted.cycle_count);
+        if (std::optional<std::string> difference = find_difference(recompiled, interpreted)) return difference;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cartridge.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+class CPU6502;
+
+// A game's PRG-ROM translated to C++ ahead of time by nes-static-recompile. run() carries on from cpu.registers.pc
+// until cycle_count reaches stop_cycle or pc gets somewhere that wasn't found in the ROM, and returns false without
+// doing anything if it starts somewhere like that.
+struct StaticProgram
+{
+    const char* name;
+    uint64_t prg_hash;
+    bool (*run)(CPU6502& cpu);
+};
+
+uint64_t hash_prg(std::span<const uint8_t> prg);
+
+// Generated translation units register their program on start up, load_cartridge then picks it up for the rom it was
+// generated from
+bool register_static_program(const StaticProgram& program);
+const StaticProgram* find_static_program(std::span<const uint8_t> prg);
+
+// Finds the code reachable from the reset, NMI and IRQ vectors of an NROM cartridge, following branches, jumps and
+// subroutine calls, and translates it to a C++ translation unit defining a StaticProgram called name. Indirect jumps
+// (and returns to addresses the code pushed itself) go back to the interpreter unless they land on an instruction
+// that was found. Code that isn't in ROM always runs in the interpreter.
+// nullopt (with the reason logged) if the cartridge doesn't use mapper 0.
+std::optional<std::string> recompile_nrom(const Cartridge& cart, std::string_view name);
+
+// Runs the cartridge with and without program, comparing the CPU state and RAM after every instruction for the given
+// number of cycles. Describes the first difference, nullopt if there wasn't one.
+std::optional<std::string> verify_static_program(std::shared_ptr<const Cartridge> cart, const StaticProgram& program,
+                                                 uint64_t cycles);
@@ -0,0 +1,49 @@
+#include "tile_cache.h"
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+
+// Each plane byte is spread across the 8 bytes of its row, then every byte is tested against its own pixel's bit,
+// two rows to a register
+void TileCache::decode_tile(const uint8_t* planes, uint64_t* rows)
+{
+    const __m128i pixel_bits = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32, 64, (char)128);
+    const __m128i one        = _mm_set1_epi8(1);
+    const __m128i two        = _mm_set1_epi8(2);
+
+    const auto spread = [](__m128i plane, __m128i (&pairs)[4]) {
+        const __m128i doubled = _mm_unpacklo_epi8(plane, plane);
+        const __m128i top     = _mm_unpacklo_epi16(doubled, doubled);
+        const __m128i bottom  = _mm_unpackhi_epi16(doubled, doubled);
+        pairs[0]              = _mm_unpacklo_epi32(top, top);
+        pairs[1]              = _mm_unpackhi_epi32(top, top);
+        pairs[2]              = _mm_unpacklo_epi32(bottom, bottom);
+        pairs[3]              = _mm_unpackhi_epi32(bottom, bottom);
+    };
+    __m128i low[4];
+    __m128i high[4];
+    spread(_mm_loadl_epi64((const __m128i*)planes), low);
+    spread(_mm_loadl_epi64((const __m128i*)(planes + 8)), high);
+
+    for (int i = 0; i < 4; ++i) {
+        const __m128i low_set  = _mm_cmpeq_epi8(_mm_and_si128(low[i], pixel_bits), pixel_bits);
+        const __m128i high_set = _mm_cmpeq_epi8(_mm_and_si128(high[i], pixel_bits), pixel_bits);
+        const __m128i pixels   = _mm_or_si128(_mm_and_si128(low_set, one), _mm_and_si128(high_set, two));
+        _mm_storeu_si128((__m128i*)(rows + i * 2), pixels);
+    }
+}
+
+#else
+
+void TileCache::decode_tile(const uint8_t* planes, uint64_t* rows)
+{
+    for (int row = 0; row < 8; ++row) {
+        rows[row] = 0;
+        for (int x = 0; x < 8; ++x) {
+            const uint64_t pixel = ((planes[row] >> (7 - x)) & 1) | (((planes[row + 8] >> (7 - x)) & 1) << 1);
+            rows[row] |= pixel << (x * 8);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// The 512 tiles in the PPU's pattern tables ($0000-$1FFF) with each row expanded from two bitplanes to a byte per
+// pixel (the colour, 0-3), leftmost pixel in the lowest byte. A row is a single load when drawing. Tiles are decoded
+// the first time they're used after being invalidated, which the mapper does when it switches a CHR bank or CHR-RAM
+// is written.
+class TileCache
+{
+public:
+    static constexpr size_t tile_count = 512;
+
+    TileCache() { m_Valid.fill(false); }
+
+    // planes is the tile's 16 bytes of CHR, used to decode it if it isn't cached
+    const std::array<uint64_t, 8>& rows(size_t tile, const uint8_t* planes)
+    {
+        if (!m_Valid[tile]) [[unlikely]] {
+            decode_tile(planes, m_Rows[tile].data());
+            m_Valid[tile] = true;
+        }
+        return m_Rows[tile];
+    }
+
+    void invalidate(size_t tile) { m_Valid[tile] = false; }
+    void invalidate(size_t first_tile, size_t count)
+    {
+        std::fill(m_Valid.begin() + (ptrdiff_t)first_tile, m_Valid.begin() + (ptrdiff_t)(first_tile + count), false);
+    }
+
+    // Expands a tile's low plane (bytes 0-7) and high plane (bytes 8-15) into 8 rows
+    static void decode_tile(const uint8_t* planes, uint64_t* rows);
+
+private:
+    std::array<std::array<uint64_t, 8>, tile_count> m_Rows;
+    std::array<bool, tile_count> m_Valid;
+};
@@ -0,0 +1,117 @@
+#include "trace.h"
+
+#include "cpu.h"
+#include "log.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+static constexpr char trace_magic[8]     = { 'N', 'E', 'S', 'T', 'R', 'A', 'C', 'E' };
+static constexpr uint32_t trace_version = 1;
+
+std::string format_trace_record(const TraceRecord& record)
+{
+    const StatusRegister p = { (StatusRegFlag)record.p };
+    return fmt::format("{:04X} {:4} {:02X}  a: {:02X}  x: {:02X}  y: {:02X}  sp: {:02X}  flags: {}({:02X})  cycles: {:5}",
+                       record.pc,
+                       CPU6502::instruction(record.opcode).name,
+                       record.opcode,
+                       record.a,
+                       record.x,
+                       record.y,
+                       record.s,
+                       p,
+                       record.p,
+                       record.cycle);
+}
+
+std::unique_ptr<TraceWriter> TraceWriter::open(const char* file_name)
+{
+    FILE* file = fopen(file_name, "wb");
+    if (!file) {
+        info_message("fopen failed: {}", strerror(errno));
+        return nullptr;
+    }
+
+    TraceFileHeader header = {};
+    memcpy(header.magic, trace_magic, sizeof(header.magic));
+    header.version     = trace_version;
+    header.record_size = sizeof(TraceRecord);
+    fwrite(&header, sizeof(header), 1, file);
+
+    return std::make_unique<TraceWriter>(file);
+}
+
+TraceWriter::TraceWriter(FILE* file)
+    : m_File(file), m_Records(std::make_unique<std::array<TraceRecord, capacity>>()), m_Thread([this] { drain(); })
+{
+}
+
+TraceWriter::~TraceWriter()
+{
+    m_Stopping.store(true, std::memory_order_release);
+    m_Thread.join();
+    fclose(m_File);
+}
+
+void TraceWriter::drain()
+{
+    while (true) {
+        // read the flag before the head so anything pushed before stopping is still written
+        const bool stopping = m_Stopping.load(std::memory_order_acquire);
+        const uint32_t head = m_Head.load(std::memory_order_acquire);
+        uint32_t tail       = m_Tail.load(std::memory_order_relaxed);
+
+        if (head == tail) {
+            if (stopping) return;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        // write up to the end of the ring, anything that wrapped goes out on the next pass
+        const uint32_t start = tail % capacity;
+        const uint32_t count = std::min(head - tail, capacity - start);
+        fwrite(m_Records->data() + start, sizeof(TraceRecord), count, m_File);
+        tail += count;
+        m_Tail.store(tail, std::memory_order_release);
+    }
+}
+
+std::optional<TraceReader> TraceReader::open(const char* file_name)
+{
+    FILE* file = fopen(file_name, "rb");
+    if (!file) {
+        info_message("fopen failed: {}", strerror(errno));
+        return std::nullopt;
+    }
+
+    TraceFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, trace_magic, sizeof(trace_magic)) != 0) {
+        info_message("{} is not a trace file", file_name);
+        fclose(file);
+        return std::nullopt;
+    }
+    if (header.version != trace_version || header.record_size != sizeof(TraceRecord)) {
+        info_message("unsupported trace version {} (record size {})", header.version, header.record_size);
+        fclose(file);
+        return std::nullopt;
+    }
+
+    return TraceReader(file);
+}
+
+TraceReader::TraceReader(TraceReader&& other) noexcept : m_File(other.m_File)
+{
+    other.m_File = nullptr;
+}
+
+TraceReader::~TraceReader()
+{
+    if (m_File) fclose(m_File);
+}
+
+bool TraceReader::next(TraceRecord& record)
+{
+    return fread(&record, sizeof(record), 1, m_File) == 1;
+}
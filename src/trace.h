@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+// CPU state captured before each instruction executes. The trace file is a TraceFileHeader followed by these records
+// back to back, so it's only readable on a machine with the same endianness as the one that wrote it.
+struct TraceRecord
+{
+    uint64_t cycle;
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t operands[2]; // only as many as the instruction uses, the rest are zero
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t s;
+    uint8_t p;
+    uint8_t reserved[6];
+};
+static_assert(sizeof(TraceRecord) == 24);
+
+struct TraceFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+
+// The same text the CPU prints with verbose_log set, which is what nestest-log-compare.py consumes
+std::string format_trace_record(const TraceRecord& record);
+
+// Records are pushed into a single producer/single consumer ring buffer by the emulation thread and written out by a
+// background thread. If the writer falls behind the emulation thread waits rather than dropping records.
+class TraceWriter
+{
+public:
+    static std::unique_ptr<TraceWriter> open(const char* file_name);
+
+    explicit TraceWriter(FILE* file);
+    TraceWriter(const TraceWriter&)            = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    ~TraceWriter();
+
+    void push(const TraceRecord& record)
+    {
+        const uint32_t head = m_Head.load(std::memory_order_relaxed);
+        while (head - m_Tail.load(std::memory_order_acquire) == capacity) {
+            std::this_thread::yield();
+        }
+        (*m_Records)[head % capacity] = record;
+        m_Head.store(head + 1, std::memory_order_release);
+    }
+
+private:
+    static constexpr uint32_t capacity = 1 << 15;
+
+    void drain();
+
+    FILE* m_File;
+    std::unique_ptr<std::array<TraceRecord, capacity>> m_Records;
+    alignas(64) std::atomic<uint32_t> m_Head = 0;
+    alignas(64) std::atomic<uint32_t> m_Tail = 0;
+    std::atomic<bool> m_Stopping             = false;
+    std::thread m_Thread;
+};
+
+class TraceReader
+{
+public:
+    static std::optional<TraceReader> open(const char* file_name);
+
+    TraceReader(TraceReader&& other) noexcept;
+    TraceReader& operator=(TraceReader&&) = delete;
+    ~TraceReader();
+
+    bool next(TraceRecord& record);
+
+private:
+    explicit TraceReader(FILE* file) : m_File(file) {}
+
+    FILE* m_File;
+};
@@ -0,0 +1,163 @@
+#include "trace_compare.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+template <typename T>
+static bool parse_hex(std::string_view text, T& value)
+{
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Finds the value following a register label such as "SP:" in the register section of the line
+template <typename T>
+static bool parse_field(std::string_view registers, std::string_view label, T& value, int base = 16)
+{
+    size_t pos = registers.find(label);
+    if (pos == std::string_view::npos) return false;
+    pos += label.size();
+    while (pos < registers.size() && registers[pos] == ' ') {
+        pos++;
+    }
+
+    const char* end   = registers.data() + registers.size();
+    const auto result = std::from_chars(registers.data() + pos, end, value, base);
+    return result.ec == std::errc();
+}
+
+std::optional<TraceRecord> parse_nestest_line(std::string_view line)
+{
+    // pc, then up to three instruction bytes in fixed columns, then the disassembly and the registers
+    if (line.size() < 16) return std::nullopt;
+
+    TraceRecord record = {};
+    if (!parse_hex(line.substr(0, 4), record.pc) || !parse_hex(line.substr(6, 2), record.opcode)) return std::nullopt;
+    for (size_t i = 0; i < 2; ++i) {
+        const std::string_view operand = line.substr(9 + i * 3, 2);
+        if (operand != "  " && !parse_hex(operand, record.operands[i])) return std::nullopt;
+    }
+
+    // the disassembly can't contain " A:" so it marks the start of the registers
+    const size_t registers_start = line.find(" A:");
+    if (registers_start == std::string_view::npos) return std::nullopt;
+    const std::string_view registers = line.substr(registers_start);
+
+    const bool parsed = parse_field(registers, " A:", record.a) && parse_field(registers, " X:", record.x) &&
+                        parse_field(registers, " Y:", record.y) && parse_field(registers, " P:", record.p) &&
+                        parse_field(registers, " SP:", record.s) && parse_field(registers, " CYC:", record.cycle, 10);
+    if (!parsed) return std::nullopt;
+    return record;
+}
+
+std::optional<std::vector<TraceRecord>> load_nestest_log(const char* file_name)
+{
+    FILE* file = fopen(file_name, "r");
+    if (!file) {
+        info_message("fopen failed: {}", strerror(errno));
+        return std::nullopt;
+    }
+
+    std::vector<TraceRecord> records;
+    char line[256];
+    size_t line_number = 1;
+    while (fgets(line, sizeof(line), file)) {
+        std::string_view text = line;
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+            text.remove_suffix(1);
+        }
+
+        const std::optional<TraceRecord> record = parse_nestest_line(text);
+        if (!record.has_value()) {
+            info_message("{}:{}: couldn't parse line", file_name, line_number);
+            fclose(file);
+            return std::nullopt;
+        }
+        records.push_back(*record);
+        line_number++;
+    }
+
+    fclose(file);
+    return records;
+}
+
+std::span<const TraceRecord> official_opcode_prefix(std::span<const TraceRecord> reference)
+{
+    const auto unofficial = std::find_if(reference.begin(), reference.end(), [](const TraceRecord& record) {
+        return CPU6502::instruction(record.opcode).operation_fn == &CPU6502::illegal_opcode;
+    });
+    return reference.first((size_t)(unofficial - reference.begin()));
+}
+
+static bool same_state(const TraceRecord& lhs, const TraceRecord& rhs)
+{
+    return lhs.pc == rhs.pc && lhs.opcode == rhs.opcode && lhs.operands[0] == rhs.operands[0] &&
+           lhs.operands[1] == rhs.operands[1] && lhs.a == rhs.a && lhs.x == rhs.x && lhs.y == rhs.y &&
+           lhs.s == rhs.s && lhs.p == rhs.p && lhs.cycle == rhs.cycle;
+}
+
+std::optional<TraceMismatch> compare_trace(CPU6502& cpu, std::span<const TraceRecord> reference, size_t context_length)
+{
+    for (size_t i = 0; i < reference.size(); ++i) {
+        const TraceRecord actual = cpu.trace_record(cpu.registers.pc);
+        if (!same_state(actual, reference[i])) [[unlikely]] {
+            const size_t context_start = i - std::min(i, context_length);
+            return TraceMismatch{ i, reference[i], actual, reference.subspan(context_start, i - context_start) };
+        }
+
+        // every instruction takes at least one cycle, so this runs exactly one
+        cpu.run_for_cycles(1);
+    }
+
+    return std::nullopt;
+}
+
+std::optional<TraceMismatch> compare_trace_sampled(CPU6502& cpu, std::span<const TraceRecord> reference, size_t stride,
+                                                   size_t context_length)
+{
+    for (size_t i = 0; i < reference.size(); i += stride) {
+        // the reference cycle counts are all instruction boundaries so this stops exactly on record i
+        cpu.run_until(reference[i].cycle);
+        const TraceRecord actual = cpu.trace_record(cpu.registers.pc);
+        if (!same_state(actual, reference[i])) [[unlikely]] {
+            const size_t context_start = i - std::min({ i, stride - 1, context_length });
+            return TraceMismatch{ i, reference[i], actual, reference.subspan(context_start, i - context_start) };
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::string format_trace_mismatch(const TraceMismatch& mismatch)
+{
+    std::string differences;
+    const auto check = [&](bool same, const char* name) {
+        if (same) return;
+        if (!differences.empty()) differences += ", ";
+        differences += name;
+    };
+    check(mismatch.actual.pc == mismatch.expected.pc, "pc");
+    check(mismatch.actual.opcode == mismatch.expected.opcode, "opcode");
+    check(mismatch.actual.operands[0] == mismatch.expected.operands[0] &&
+              mismatch.actual.operands[1] == mismatch.expected.operands[1],
+          "operands");
+    check(mismatch.actual.a == mismatch.expected.a, "a");
+    check(mismatch.actual.x == mismatch.expected.x, "x");
+    check(mismatch.actual.y == mismatch.expected.y, "y");
+    check(mismatch.actual.s == mismatch.expected.s, "sp");
+    check(mismatch.actual.p == mismatch.expected.p, "flags");
+    check(mismatch.actual.cycle == mismatch.expected.cycle, "cycles");
+
+    std::string text = fmt::format("trace diverged at line {} ({})\n", mismatch.index + 1, differences);
+    for (const TraceRecord& record : mismatch.context) {
+        text += fmt::format("          {}\n", format_trace_record(record));
+    }
+    text += fmt::format("expected: {}\n", format_trace_record(mismatch.expected));
+    text += fmt::format("ours:     {}\n", format_trace_record(mismatch.actual));
+    return text;
+}
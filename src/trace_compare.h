@@ -0,0 +1,38 @@
+#pragma once
+
+#include "cpu.h"
+#include "trace.h"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Parses a line of a reference log in the format nestest.log uses, e.g.
+// C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7
+std::optional<TraceRecord> parse_nestest_line(std::string_view line);
+std::optional<std::vector<TraceRecord>> load_nestest_log(const char* file_name);
+
+// nestest finishes off by testing the unofficial opcodes, which aren't emulated, so this is the part of a reference
+// trace before the first of those
+std::span<const TraceRecord> official_opcode_prefix(std::span<const TraceRecord> reference);
+
+struct TraceMismatch
+{
+    size_t index; // of the reference record that didn't match
+    TraceRecord expected;
+    TraceRecord actual;
+    std::span<const TraceRecord> context; // the reference records leading up to the mismatch, which all matched
+};
+
+// Runs the CPU one instruction per reference record, checking its state before each against the reference, and stops
+// at the first difference. The CPU should already be set up to execute the first record.
+std::optional<TraceMismatch> compare_trace(CPU6502& cpu, std::span<const TraceRecord> reference,
+                                           size_t context_length = 8);
+// The same but only checks every stride records, running whole blocks (and translated code) in between. The context
+// of a mismatch is then the records leading up to it that weren't checked.
+std::optional<TraceMismatch> compare_trace_sampled(CPU6502& cpu, std::span<const TraceRecord> reference, size_t stride,
+                                                   size_t context_length = 8);
+std::string format_trace_mismatch(const TraceMismatch& mismatch);
@@ -0,0 +1,65 @@
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "log.h"
+#include "trace_compare.h"
+
+// Runs a rom against a reference log (nestest.log) and reports the first instruction where the CPU state differs.
+// With --jit the recompiler is used and the state is checked every so often rather than after every instruction.
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fmt::print("usage: <program_name> <path_to_rom> <path_to_reference_log> [--jit]");
+        return -1;
+    }
+
+    bool use_recompiler = false;
+    for (int i = 3; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--jit") {
+            use_recompiler = true;
+        } else {
+            info_message("unknown argument: {}", arg);
+            return -1;
+        }
+    }
+
+    std::optional<Cartridge> cart = Cartridge::from_file(argv[1]);
+    if (!cart.has_value()) {
+        info_message("failed to load cart");
+        return EXIT_FAILURE;
+    }
+
+    const std::optional<std::vector<TraceRecord>> log = load_nestest_log(argv[2]);
+    if (!log.has_value() || log->empty()) {
+        info_message("failed to load reference log");
+        return EXIT_FAILURE;
+    }
+    const std::span<const TraceRecord> reference = official_opcode_prefix(*log);
+
+    CPU6502 cpu;
+    if (!cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*cart)))) {
+        info_message("failed to load cart");
+        return EXIT_FAILURE;
+    }
+    cpu.reset();
+    // nestest's automated mode starts at $C000 rather than the reset vector
+    cpu.registers.pc   = reference.front().pc;
+    cpu.use_recompiler = use_recompiler;
+
+    constexpr size_t jit_stride                 = 64;
+    const std::optional<TraceMismatch> mismatch = use_recompiler ? compare_trace_sampled(cpu, reference, jit_stride)
+                                                                 : compare_trace(cpu, reference);
+    if (mismatch.has_value()) {
+        fmt::print("{}", format_trace_mismatch(*mismatch));
+        return EXIT_FAILURE;
+    }
+
+    fmt::print("all {} instructions matched\n", reference.size());
+}
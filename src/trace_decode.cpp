@@ -0,0 +1,25 @@
+#include <cstdlib>
+#include <optional>
+
+#include "log.h"
+#include "trace.h"
+
+// Renders a binary trace written by nes-emulator --trace as the same text verbose_log prints
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fmt::print("usage: <program_name> <path_to_trace>");
+        return -1;
+    }
+
+    std::optional<TraceReader> reader = TraceReader::open(argv[1]);
+    if (!reader.has_value()) {
+        info_message("failed to open trace");
+        return EXIT_FAILURE;
+    }
+
+    TraceRecord record;
+    while (reader->next(record)) {
+        fmt::print("{}\n", format_trace_record(record));
+    }
+}
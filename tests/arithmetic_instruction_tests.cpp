@@ -341,4 +341,30 @@ TEST_CASE("sbc imm", "[sbc],[cpu],[imm],[instruction]")
         // 150 - 50 - (1 - 1) = 100
         REQUIRE(cpu.registers.a == 100);
     }
+
+    SECTION("overflow flag set subtracting a positive from a negative")
+    {
+        cpu.registers.a = 0x80;
+        cpu.memory.write_byte(1, 1);
+        cpu.registers.p.set_carry_bit();
+        cpu.process_instruction();
+
+        // -128 - 1 doesn't fit
+        REQUIRE(cpu.registers.a == 0x7F);
+        REQUIRE(cpu.registers.p.overflow_flag_set());
+        REQUIRE(cpu.registers.p.carry_bit_set());
+    }
+
+    SECTION("borrow clears carry")
+    {
+        cpu.registers.a = 0x01;
+        cpu.memory.write_byte(1, 2);
+        cpu.registers.p.set_carry_bit();
+        cpu.process_instruction();
+
+        REQUIRE(cpu.registers.a == 0xFF);
+        REQUIRE(!cpu.registers.p.carry_bit_set());
+        REQUIRE(!cpu.registers.p.overflow_flag_set());
+        REQUIRE(cpu.registers.p.negative_flag_set());
+    }
 }
@@ -0,0 +1,335 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "fused_pairs.h"
+#include "opcodes.h"
+#include "static_test_rom.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+static void write_program(CPU6502& cpu, uint16_t addr, std::initializer_list<uint8_t> program)
+{
+    for (uint8_t byte : program) {
+        cpu.memory.write_byte(addr++, byte);
+    }
+}
+
+// loop: LDA #n; STA $0200; INC $0801; JMP loop
+// INC goes through the mirror at $0800 to bump the LDA operand, so every pass stores one more than the last
+static void write_self_modifying_loop(CPU6502& cpu)
+{
+    write_program(cpu,
+                  0x0000,
+                  { OPCODE_LDA_IMM, 0x01,                   //
+                    OPCODE_STA_ABS, 0x00, 0x02,             //
+                    OPCODE_INC_ABS, 0x01, 0x08,             //
+                    OPCODE_JMP_ABS, 0x00, 0x00 });
+}
+
+TEST_CASE("block cache matches the interpreter", "[cpu],[block_cache]")
+{
+    CPU6502 cached;
+    CPU6502 uncached;
+    uncached.use_block_cache = false;
+    write_self_modifying_loop(cached);
+    write_self_modifying_loop(uncached);
+
+    cached.run_until(5000);
+    uncached.run_until(5000);
+
+    REQUIRE(cached.cycle_count == uncached.cycle_count);
+    REQUIRE(cached.registers.pc == uncached.registers.pc);
+    REQUIRE(cached.registers.a == uncached.registers.a);
+    REQUIRE(cached.registers.p == uncached.registers.p);
+    REQUIRE(cached.memory.read_byte(0x0200) == uncached.memory.read_byte(0x0200));
+}
+
+TEST_CASE("block cache sees code being written", "[cpu],[block_cache]")
+{
+    CPU6502 cpu;
+
+    SECTION("through a mirror")
+    {
+        write_self_modifying_loop(cpu);
+
+        // LDA (2) + STA (4) + INC (6) + JMP (3)
+        cpu.run_until(15 * 10);
+        REQUIRE(cpu.memory.read_byte(0x0200) == 10);
+        REQUIRE(cpu.memory.read_byte(0x0001) == 11);
+    }
+
+    SECTION("later in the block that's running")
+    {
+        // LDA #INX; STA $0005; NOP; JMP $0006 with the NOP overwritten before it runs
+        write_program(cpu,
+                      0x0000,
+                      { OPCODE_LDA_IMM, OPCODE_INX_IMP,       //
+                        OPCODE_STA_ABS, 0x05, 0x00,           //
+                        OPCODE_NOP_IMP,                       //
+                        OPCODE_JMP_ABS, 0x06, 0x00 });
+
+        cpu.run_until(100);
+        REQUIRE(cpu.registers.x == 1);
+    }
+
+    SECTION("by write_rom")
+    {
+        // INX; JMP $8000
+        const std::array<uint8_t, 4> increment = { OPCODE_INX_IMP, OPCODE_JMP_ABS, 0x00, 0x80 };
+        const std::array<uint8_t, 4> decrement = { OPCODE_DEX_IMP, OPCODE_JMP_ABS, 0x00, 0x80 };
+        cpu.memory.write_rom(0x8000, increment);
+        cpu.registers.pc = 0x8000;
+
+        cpu.run_for_cycles(50);
+        REQUIRE(cpu.registers.x == 10);
+
+        cpu.memory.write_rom(0x8000, decrement);
+        cpu.registers.pc = 0x8000;
+        cpu.run_for_cycles(50);
+        REQUIRE(cpu.registers.x == 0);
+    }
+}
+
+// UxROM with 16KiB bank n starting LDX #n; RTS, and the fixed bank at $C000 running
+// JSR $8000; STX $0200; LDA #1; STA $C100; JSR $8000; STX $0201; JMP *
+static std::shared_ptr<const Cartridge> make_bank_switching_cartridge()
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, 4, 0 };
+    image.resize(16);
+    image[6] = 2 << 4;
+    for (uint8_t bank = 0; bank < 4; ++bank) {
+        const size_t start = image.size();
+        image.resize(start + 0x4000);
+        image[start]     = OPCODE_LDX_IMM;
+        image[start + 1] = bank;
+        image[start + 2] = OPCODE_RTS_IMP;
+    }
+
+    constexpr std::array<uint8_t, 21> fixed_bank = { OPCODE_JSR_ABS, 0x00, 0x80, OPCODE_STX_ABS, 0x00, 0x02,
+                                                     OPCODE_LDA_IMM, 0x01,       OPCODE_STA_ABS, 0x00, 0xC1,
+                                                     OPCODE_JSR_ABS, 0x00, 0x80, OPCODE_STX_ABS, 0x01, 0x02,
+                                                     OPCODE_JMP_ABS, 0x11, 0xC0, 0x00 };
+    memcpy(image.data() + 16 + 3 * 0x4000, fixed_bank.data(), fixed_bank.size());
+
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    return std::make_shared<const Cartridge>(std::move(*cart));
+}
+
+TEST_CASE("block cache follows bank switches", "[cpu],[block_cache]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(make_bank_switching_cartridge()));
+    cpu.registers.pc = 0xC000;
+    cpu.registers.s  = 0xFD;
+
+    cpu.run_until(200);
+    REQUIRE(cpu.memory.read_byte(0x0200) == 0);
+    REQUIRE(cpu.memory.read_byte(0x0201) == 1);
+}
+
+static void require_same_state(const CPU6502& skipping, const CPU6502& stepping)
+{
+    REQUIRE(skipping.cycle_count == stepping.cycle_count);
+    REQUIRE(skipping.registers.pc == stepping.registers.pc);
+    REQUIRE(skipping.registers.a == stepping.registers.a);
+    REQUIRE(skipping.registers.x == stepping.registers.x);
+    REQUIRE(skipping.registers.y == stepping.registers.y);
+    REQUIRE(skipping.registers.s == stepping.registers.s);
+    REQUIRE(skipping.registers.p == stepping.registers.p);
+}
+
+TEST_CASE("idle loops are skipped", "[cpu],[block_cache]")
+{
+    CPU6502 skipping;
+    CPU6502 stepping;
+    stepping.skip_idle_loops = false;
+
+    SECTION("polling a register")
+    {
+        // LDA $4015; BPL $0000 waiting on a flag that never gets set
+        for (CPU6502* cpu : { &skipping, &stepping }) {
+            write_program(*cpu, 0x0000, { OPCODE_LDA_ABS, 0x15, 0x40, OPCODE_BPL_REL, 0xFB });
+        }
+    }
+
+    SECTION("jumping to itself")
+    {
+        // LDX #$05; JMP $0002
+        for (CPU6502* cpu : { &skipping, &stepping }) {
+            write_program(*cpu, 0x0000, { OPCODE_LDX_IMM, 0x05, OPCODE_JMP_ABS, 0x02, 0x00 });
+        }
+    }
+
+    // odd sized steps so runs end part way through the loop as well as at its start
+    for (uint64_t target = 1; target < 100000; target += 997) {
+        skipping.run_until(target);
+        stepping.run_until(target);
+        require_same_state(skipping, stepping);
+    }
+    REQUIRE(skipping.idle_cycles_skipped > 90000);
+    REQUIRE(stepping.idle_cycles_skipped == 0);
+}
+
+TEST_CASE("loops that change something aren't skipped", "[cpu],[block_cache]")
+{
+    CPU6502 cpu;
+
+    SECTION("a register")
+    {
+        // INX; BNE $0000
+        write_program(cpu, 0x0000, { OPCODE_INX_IMP, OPCODE_BNE_REL, 0xFD, OPCODE_JMP_ABS, 0x00, 0x00 });
+        cpu.run_until(10000);
+        REQUIRE(cpu.idle_cycles_skipped == 0);
+    }
+
+    SECTION("memory")
+    {
+        // INC $10; LDA $10; BNE $0000 isn't an idle loop at all because of the write
+        write_program(cpu, 0x0000, { OPCODE_INC_ZP, 0x10, OPCODE_LDA_ZP, 0x10, OPCODE_BNE_REL, 0xFA });
+        cpu.run_until(10000);
+        REQUIRE(cpu.idle_cycles_skipped == 0);
+    }
+}
+
+// loop: LDY #$00; LDA $0300,Y; ADC $0300,Y; STA $0300,Y; INY; BNE $0002
+//       CLC; ADC #$01; STA $10; INC $10; LDA $10; SEC; SBC $11; STA $11; JMP $0000
+// made of pairs from the static test rom's fused_pairs.h, with a few in between that aren't
+static void write_fusable_program(CPU6502& cpu)
+{
+    write_program(cpu,
+                  0x0000,
+                  { OPCODE_LDY_IMM, 0x00, OPCODE_LDA_ABSY, 0x00, 0x03,          //
+                    OPCODE_ADC_ABSY, 0x00, 0x03, OPCODE_STA_ABSY, 0x00, 0x03, //
+                    OPCODE_INY_IMP, OPCODE_BNE_REL, 0xF4,                     //
+                    OPCODE_CLC_IMP, OPCODE_ADC_IMM, 0x01, OPCODE_STA_ZP, 0x10, //
+                    OPCODE_INC_ZP, 0x10, OPCODE_LDA_ZP, 0x10,                 //
+                    OPCODE_SEC_IMP, OPCODE_SBC_ZP, 0x11, OPCODE_STA_ZP, 0x11, //
+                    OPCODE_JMP_ABS, 0x00, 0x00 });
+}
+
+// Checks block was fused the way BlockCache::fuse does it with the pairs in fused_pairs.h, so the test doesn't
+// depend on which pairs were generated. Returns how many pairs there were
+static size_t require_fused_from_table(std::span<const DecodedInstruction> block)
+{
+    size_t pairs = 0;
+    for (size_t i = 0; i < block.size();) {
+        const bool fused = i + 1 < block.size() &&
+                           std::ranges::any_of(fused_opcode_pairs, [&](OpcodePair pair) {
+                               return pair.first == block[i].opcode && pair.second == block[i + 1].opcode;
+                           });
+        REQUIRE(block[i].length == (fused ? 2 : 1));
+        pairs += fused;
+        i += block[i].length;
+    }
+    return pairs;
+}
+
+TEST_CASE("fused pairs match running the instructions one at a time", "[cpu],[block_cache]")
+{
+    CPU6502 fused;
+    CPU6502 unfused;
+    unfused.block_cache.fuse_pairs = false;
+    write_fusable_program(fused);
+    write_fusable_program(unfused);
+
+    REQUIRE(fused.block_cache.block_at(0x0000).size() == 6);
+    REQUIRE(fused.block_cache.block_at(0x000E).size() == 9);
+    const size_t pairs = require_fused_from_table(fused.block_cache.block_at(0x0000)) +
+                         require_fused_from_table(fused.block_cache.block_at(0x0002)) +
+                         require_fused_from_table(fused.block_cache.block_at(0x000E));
+    REQUIRE(pairs > 0);
+
+    // odd sized steps so runs stop in between the two halves of a pair as well as after them
+    for (uint64_t target = 1; target < 50000; target += 331) {
+        fused.run_until(target);
+        unfused.run_until(target);
+        require_same_state(fused, unfused);
+        REQUIRE(fused.memory.read_byte(0x0010) == unfused.memory.read_byte(0x0010));
+        REQUIRE(fused.memory.read_byte(0x0011) == unfused.memory.read_byte(0x0011));
+        REQUIRE(fused.memory.read_byte(0x0300 + fused.registers.y) ==
+                unfused.memory.read_byte(0x0300 + unfused.registers.y));
+    }
+}
+
+TEST_CASE("fused pairs stop in between when the first takes the CPU to stop_cycle", "[cpu],[block_cache]")
+{
+    // CLC; ADC #$01; STA $10; JMP $0000
+    CPU6502 cpu;
+    write_program(cpu,
+                  0x0000,
+                  { OPCODE_CLC_IMP, OPCODE_ADC_IMM, 0x01, OPCODE_STA_ZP, 0x10, OPCODE_JMP_ABS, 0x00, 0x00 });
+
+    cpu.run_until(2);
+    REQUIRE(cpu.block_cache.block_at(0x0000)[0].length == 2);
+    REQUIRE(cpu.cycle_count == 2);
+    REQUIRE(cpu.registers.pc == 0x0001);
+    REQUIRE(cpu.registers.a == 0);
+
+    cpu.run_until(4);
+    REQUIRE(cpu.cycle_count == 4);
+    REQUIRE(cpu.registers.pc == 0x0003);
+    REQUIRE(cpu.registers.a == 1);
+}
+
+TEST_CASE("opcode pairs are counted when one follows the other", "[cpu],[block_cache]")
+{
+    // LDX #$05; DEX; BNE $0002; JMP $0000
+    CPU6502 cpu;
+    write_program(cpu,
+                  0x0000,
+                  { OPCODE_LDX_IMM, 0x05, OPCODE_DEX_IMP, OPCODE_BNE_REL, 0xFD, OPCODE_JMP_ABS, 0x00, 0x00 });
+    OpcodePairHistogram histogram;
+    cpu.pair_histogram = &histogram;
+
+    // LDX (2) + 4 * (DEX (2) + BNE taken (3)) + DEX (2) + BNE (2) + JMP (3) is one time round
+    cpu.run_until(29);
+    REQUIRE(cpu.registers.pc == 0x0000);
+    REQUIRE(histogram.count({ OPCODE_LDX_IMM, OPCODE_DEX_IMP }) == 1);
+    REQUIRE(histogram.count({ OPCODE_DEX_IMP, OPCODE_BNE_REL }) == 5);
+    REQUIRE(histogram.count({ OPCODE_BNE_REL, OPCODE_JMP_ABS }) == 1);
+    // the taken branches and the jump went somewhere else
+    REQUIRE(histogram.count({ OPCODE_BNE_REL, OPCODE_DEX_IMP }) == 0);
+    REQUIRE(histogram.count({ OPCODE_JMP_ABS, OPCODE_LDX_IMM }) == 0);
+    REQUIRE(histogram.total() == 7);
+
+    // the branch can't be fused with what follows it
+    const std::vector<OpcodePairHistogram::Entry> pairs = histogram.most_frequent(8);
+    REQUIRE(pairs.size() == 2);
+    REQUIRE(pairs[0].pair.first == OPCODE_DEX_IMP);
+    REQUIRE(pairs[0].count == 5);
+    REQUIRE(pairs[1].pair.first == OPCODE_LDX_IMM);
+}
+
+TEST_CASE("fused_pairs.h is what nes-opcode-pairs makes from the static test rom", "[cpu],[block_cache]")
+{
+    // the command in the comment at the top of fused_pairs.h, static_test.nes being static_test_rom() written out
+    std::optional<Cartridge> cart = Cartridge::from_memory(static_test_rom());
+    REQUIRE(cart.has_value());
+    auto histogram = std::make_unique<OpcodePairHistogram>();
+    REQUIRE(count_opcode_pairs(std::make_shared<const Cartridge>(std::move(*cart)), 60, *histogram));
+    const std::string header =
+        write_fused_pairs_header(histogram->most_frequent(32),
+                                 histogram->total(),
+                                 "nes-opcode-pairs fused_pairs.h static_test.nes --frames 60 --pairs 32");
+
+    FILE* file = fopen(NES_SOURCE_DIR "/fused_pairs.h", "rb");
+    REQUIRE(file);
+    std::string checked_in;
+    char buffer[4096];
+    while (size_t read = fread(buffer, 1, sizeof(buffer), file)) {
+        checked_in.append(buffer, read);
+    }
+    fclose(file);
+    REQUIRE(header == checked_in);
+}
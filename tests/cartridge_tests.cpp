@@ -0,0 +1,69 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+
+#include <cstdio>
+#include <vector>
+
+static std::vector<uint8_t> make_image(uint8_t prg_banks_16k, uint8_t chr_banks_8k)
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, prg_banks_16k, chr_banks_8k, 0x10 };
+    image.resize(16);
+    for (size_t i = 0; i < prg_banks_16k * 0x4000u + chr_banks_8k * 0x2000u; ++i) {
+        image.push_back((uint8_t)(i >> 13));
+    }
+    return image;
+}
+
+TEST_CASE("cartridge from memory", "[cartridge]")
+{
+    const std::vector<uint8_t> image = make_image(2, 1);
+    std::optional<Cartridge> cart    = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+
+    REQUIRE(cart->get_mapper_number() == 1);
+    REQUIRE(cart->get_program_data().size() == 0x8000);
+    REQUIRE(cart->get_program_data()[0x2000] == 1);
+    REQUIRE(cart->get_video_data().size() == 0x2000);
+    REQUIRE(cart->get_video_data()[0] == 4);
+
+    SECTION("the image is copied")
+    {
+        REQUIRE(cart->get_program_data().data() != image.data() + 16);
+    }
+}
+
+TEST_CASE("cartridge rejects bad images", "[cartridge]")
+{
+    std::vector<uint8_t> image = make_image(2, 1);
+
+    SECTION("bad signature")
+    {
+        image[3] = 0;
+        REQUIRE(!Cartridge::from_memory(image).has_value());
+    }
+
+    SECTION("truncated")
+    {
+        image.resize(image.size() - 1);
+        REQUIRE(!Cartridge::from_memory(image).has_value());
+    }
+}
+
+TEST_CASE("cartridge from file", "[cartridge]")
+{
+    // bigger than the 32KiB the loader used to be limited to
+    const std::vector<uint8_t> image = make_image(32, 0);
+    FILE* file                       = tmpfile();
+    REQUIRE(file);
+    REQUIRE(fwrite(image.data(), 1, image.size(), file) == image.size());
+    rewind(file);
+
+    std::optional<Cartridge> cart = Cartridge::from_file(file);
+    fclose(file);
+    REQUIRE(cart.has_value());
+
+    REQUIRE(cart->get_program_data().size() == 512 * 1024);
+    REQUIRE(cart->get_program_data()[0x7FFFF] == 63);
+    REQUIRE(cart->get_video_data().empty());
+}
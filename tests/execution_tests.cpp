@@ -0,0 +1,114 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cpu.h"
+#include "opcodes.h"
+
+#include <initializer_list>
+
+// LDX #$00; loop: INX; BNE loop; JMP $0000
+static void write_count_loop(CPU6502& cpu)
+{
+    cpu.memory.write_byte(0, OPCODE_LDX_IMM);
+    cpu.memory.write_byte(1, 0x00);
+    cpu.memory.write_byte(2, OPCODE_INX_IMP);
+    cpu.memory.write_byte(3, OPCODE_BNE_REL);
+    cpu.memory.write_byte(4, 0xFD);
+    cpu.memory.write_byte(5, OPCODE_JMP_ABS);
+    cpu.memory.write_word(6, 0x0000);
+}
+
+TEST_CASE("run_until matches next_cycle", "[cpu],[execution]")
+{
+    CPU6502 stepped;
+    CPU6502 batched;
+    write_count_loop(stepped);
+    write_count_loop(batched);
+
+    // stop both on an instruction boundary
+    while (stepped.cycle_count < 5000 || stepped.cycles_remaining != 0) {
+        stepped.next_cycle();
+    }
+    batched.run_until(5000);
+
+    REQUIRE(batched.cycle_count == stepped.cycle_count);
+    REQUIRE(batched.registers.pc == stepped.registers.pc);
+    REQUIRE(batched.registers.x == stepped.registers.x);
+    REQUIRE(batched.registers.p == stepped.registers.p);
+}
+
+TEST_CASE("run_until finishes an instruction started by next_cycle", "[cpu],[execution]")
+{
+    CPU6502 cpu;
+    write_count_loop(cpu);
+
+    cpu.next_cycle();
+    REQUIRE(cpu.cycles_remaining == 1);
+
+    cpu.run_until(2);
+    REQUIRE(cpu.cycles_remaining == 0);
+    REQUIRE(cpu.cycle_count == 2);
+    REQUIRE(cpu.registers.pc == 2);
+}
+
+TEST_CASE("run_for_cycles", "[cpu],[execution]")
+{
+    CPU6502 cpu;
+    write_count_loop(cpu);
+
+    SECTION("stops on the first instruction boundary at or past the target")
+    {
+        // LDX (2) + INX (2) + BNE taken (3)
+        cpu.run_for_cycles(6);
+        REQUIRE(cpu.cycle_count == 7);
+        REQUIRE(cpu.registers.pc == 2);
+    }
+
+    SECTION("zero cycles does nothing")
+    {
+        cpu.run_for_cycles(0);
+        REQUIRE(cpu.cycle_count == 0);
+        REQUIRE(cpu.registers.pc == 0);
+    }
+}
+
+TEST_CASE("run_frame", "[cpu],[execution]")
+{
+    CPU6502 cpu;
+    write_count_loop(cpu);
+
+    // the first vblank starts on dot 1 of scanline 241, and a frame with rendering off is 341 * 262 dots
+    cpu.run_frame();
+    REQUIRE(cpu.ppu.frame_count() == 1);
+    REQUIRE(cpu.cycle_count >= (241 * 341 + 1) / 3 + 1);
+    REQUIRE(cpu.cycle_count < (241 * 341 + 1) / 3 + 1 + 7);
+
+    cpu.run_frame();
+    REQUIRE(cpu.ppu.frame_count() == 2);
+    REQUIRE(cpu.cycle_count >= (241 * 341 + 1 + 341 * 262) / 3 + 1);
+    REQUIRE(cpu.cycle_count < (241 * 341 + 1 + 341 * 262) / 3 + 1 + 7);
+}
+
+TEST_CASE("unofficial opcodes run as NOPs the length of their addressing mode", "[cpu],[execution]")
+{
+    // NOP abs,X; NOP #; a jam opcode; LAX zp; SLO (zp,X); ISC abs,Y; INX
+    constexpr uint8_t program[] = { 0x1C, 0x00, 0x03, 0x80, 0x55, 0x02, 0xA7, 0x10, 0x03, 0x20, 0xFB, 0x00, 0x02,
+                                    OPCODE_INX_IMP };
+    for (bool use_block_cache : { false, true }) {
+        CPU6502 cpu;
+        cpu.use_block_cache = use_block_cache;
+        for (uint16_t i = 0; i < sizeof(program); ++i) {
+            cpu.memory.write_byte(i, program[i]);
+        }
+        const CpuRegisters before = cpu.registers;
+
+        cpu.run_until(4 + 2 + 2 + 3 + 6 + 4);
+        REQUIRE(cpu.registers.pc == sizeof(program) - 1);
+        REQUIRE(cpu.cycle_count == 4 + 2 + 2 + 3 + 6 + 4);
+        REQUIRE(cpu.registers.a == before.a);
+        REQUIRE(cpu.registers.x == before.x);
+        REQUIRE(cpu.registers.p == before.p);
+
+        cpu.run_for_cycles(1);
+        REQUIRE(cpu.registers.x == (uint8_t)(before.x + 1));
+    }
+}
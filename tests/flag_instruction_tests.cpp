@@ -72,3 +72,26 @@ TEST_CASE("cld imp", "[cld],[cpu],[imp],[instruction]")
 
     REQUIRE(!cpu.registers.p.decimal_flag_set());
 }
+
+TEST_CASE("status register value", "[cpu],[flags]")
+{
+    for (int value = 0; value < 0x100; ++value) {
+        const StatusRegister reg = { (StatusRegFlag)value };
+        REQUIRE(reg.value() == value);
+    }
+
+    StatusRegister reg = {};
+    reg.set_zero_and_negative_from(0x80);
+    REQUIRE(reg.negative_flag_set());
+    REQUIRE(!reg.zero_flag_set());
+    REQUIRE(reg.value() == (uint8_t)StatusRegFlag::Negative);
+
+    reg.set_zero_and_negative_from(0);
+    REQUIRE(!reg.negative_flag_set());
+    REQUIRE(reg.zero_flag_set());
+    REQUIRE(reg.value() == (uint8_t)StatusRegFlag::Zero);
+
+    // bit sets N and Z from different values, so both can be set at once
+    reg.set_negative_from(0xFF);
+    REQUIRE(reg.value() == (uint8_t)(StatusRegFlag::Negative | StatusRegFlag::Zero));
+}
@@ -0,0 +1,191 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "frame_convert.h"
+#include "opcodes.h"
+
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Runs a frame with rendering off, so it's all the backdrop, and the mask written with it
+static void render_backdrop(CPU6502& cpu, uint8_t backdrop, uint8_t mask)
+{
+    cpu.memory.write_byte(0x2006, 0x3F);
+    cpu.memory.write_byte(0x2006, 0x00);
+    cpu.memory.write_byte(0x2007, backdrop);
+    cpu.memory.write_byte(0x2006, 0x20);
+    cpu.memory.write_byte(0x2006, 0x00);
+    cpu.memory.write_byte(0x2001, mask);
+    cpu.run_frame();
+    cpu.run_frame();
+}
+
+static std::vector<uint8_t> convert(const CPU6502& cpu, PixelFormat format, bool half_size)
+{
+    std::vector<uint8_t> out(converted_frame_size(format, half_size));
+    REQUIRE(convert_frame(cpu.ppu, format, half_size, out));
+    return out;
+}
+
+TEST_CASE("frame conversion", "[ppu],[frame_convert]")
+{
+    CPU6502 cpu;
+    cpu.memory.write_byte(0x0000, OPCODE_JMP_ABS);
+
+    SECTION("rgba")
+    {
+        render_backdrop(cpu, 0x16, 0);
+        const std::vector<uint8_t> out = convert(cpu, PixelFormat::Rgba8888, false);
+        REQUIRE(out.size() == 256 * 240 * 4);
+        REQUIRE(std::vector<uint8_t>(out.begin(), out.begin() + 4) == std::vector<uint8_t>{ 0xB5, 0x31, 0x20, 0xFF });
+        REQUIRE(std::vector<uint8_t>(out.end() - 4, out.end()) == std::vector<uint8_t>{ 0xB5, 0x31, 0x20, 0xFF });
+    }
+
+    SECTION("rgb565")
+    {
+        render_backdrop(cpu, 0x30, 0);
+        const std::vector<uint8_t> out = convert(cpu, PixelFormat::Rgb565, false);
+        REQUIRE(out.size() == 256 * 240 * 2);
+        uint16_t pixel;
+        std::memcpy(&pixel, out.data(), sizeof(pixel));
+        REQUIRE(pixel == 0xFFFF);
+    }
+
+    SECTION("gray")
+    {
+        render_backdrop(cpu, 0x0F, 0);
+        REQUIRE(convert(cpu, PixelFormat::Gray8, false) == std::vector<uint8_t>(256 * 240, 0));
+        render_backdrop(cpu, 0x30, 0);
+        REQUIRE(convert(cpu, PixelFormat::Gray8, false)[0] == 0xFE);
+    }
+
+    SECTION("emphasis darkens the other channels")
+    {
+        render_backdrop(cpu, 0x30, 0x20);
+        REQUIRE(cpu.ppu.emphasis_spans().size() == 1);
+        REQUIRE(cpu.ppu.emphasis_spans()[0].emphasis == 1);
+        const std::vector<uint8_t> out = convert(cpu, PixelFormat::Rgba8888, false);
+        REQUIRE(std::vector<uint8_t>(out.begin(), out.begin() + 4) == std::vector<uint8_t>{ 0xFF, 0xCF, 0xD0, 0xFF });
+    }
+
+    SECTION("grayscale")
+    {
+        render_backdrop(cpu, 0x16, 0x01);
+        REQUIRE(cpu.ppu.frame()[0] == 0x10);
+    }
+
+    SECTION("too small")
+    {
+        std::vector<uint8_t> out(converted_frame_size(PixelFormat::Gray8, false) - 1);
+        REQUIRE(!convert_frame(cpu.ppu, PixelFormat::Gray8, false, out));
+    }
+}
+
+TEST_CASE("half size frames average 2x2 blocks", "[ppu],[frame_convert]")
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, 1, 0 };
+    image.resize(16 + 0x4000);
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*cart))));
+    cpu.memory.write_byte(0x0000, OPCODE_JMP_ABS);
+
+    // every tile is tile 0, which is white and black stripes
+    cpu.memory.write_byte(0x2006, 0x00);
+    cpu.memory.write_byte(0x2006, 0x00);
+    for (int row = 0; row < 8; ++row) {
+        cpu.memory.write_byte(0x2007, 0xAA);
+    }
+    cpu.memory.write_byte(0x2006, 0x3F);
+    cpu.memory.write_byte(0x2006, 0x00);
+    cpu.memory.write_byte(0x2007, 0x0F);
+    cpu.memory.write_byte(0x2007, 0x30);
+    cpu.memory.write_byte(0x2001, 0x0A);
+    cpu.run_frame();
+    cpu.run_frame();
+
+    const std::vector<uint8_t> rgba = convert(cpu, PixelFormat::Rgba8888, true);
+    REQUIRE(rgba.size() == 128 * 120 * 4);
+    REQUIRE(std::vector<uint8_t>(rgba.begin(), rgba.begin() + 4) == std::vector<uint8_t>{ 0x7F, 0x7F, 0x7F, 0xFF });
+    REQUIRE(convert(cpu, PixelFormat::Gray8, true) == std::vector<uint8_t>(128 * 120, 0x7F));
+}
+
+TEST_CASE("emphasis changes on the pixel PPUMASK is written on", "[ppu],[frame_convert]")
+{
+    CPU6502 cpu;
+    cpu.memory.write_byte(0x0000, OPCODE_JMP_ABS);
+    render_backdrop(cpu, 0x30, 0);
+
+    // halfway across scanline 100 of the next frame
+    while (cpu.ppu.scanline() != 100 || cpu.ppu.dot() < 128) {
+        cpu.run_until(cpu.cycle_count + 1);
+        cpu.ppu.catch_up();
+    }
+    cpu.memory.write_byte(0x2001, 0x20);
+    const auto changed_at = (uint32_t)(100 * Ppu::width + cpu.ppu.dot() - 1);
+    cpu.run_frame();
+
+    REQUIRE(cpu.ppu.emphasis_spans().size() == 2);
+    REQUIRE(cpu.ppu.emphasis_spans()[1].first_pixel == changed_at);
+    REQUIRE(cpu.ppu.emphasis_spans()[1].emphasis == 1);
+
+    const std::vector<uint8_t> out = convert(cpu, PixelFormat::Gray8, false);
+    REQUIRE(out[100 * Ppu::width] == out[0]);
+    REQUIRE(out[changed_at - 1] == out[0]);
+    REQUIRE(out[changed_at] != out[0]);
+    REQUIRE(out[101 * Ppu::width] == out[changed_at]);
+    REQUIRE(out.back() == out[changed_at]);
+}
+
+TEST_CASE("the SSSE3 lookups make the same frames as the plain ones", "[ppu],[frame_convert]")
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, 1, 0 };
+    image.resize(16 + 0x4000);
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*cart))));
+    cpu.memory.write_byte(0x0000, OPCODE_JMP_ABS);
+
+    // a different tile everywhere, all four palettes, and colours from every row of the system palette
+    cpu.memory.write_byte(0x2006, 0x00);
+    cpu.memory.write_byte(0x2006, 0x00);
+    for (int i = 0; i < 0x1000; ++i) {
+        cpu.memory.write_byte(0x2007, (uint8_t)(i * 37 + (i >> 4)));
+    }
+    cpu.memory.write_byte(0x2006, 0x20);
+    cpu.memory.write_byte(0x2006, 0x00);
+    for (int i = 0; i < 0x400; ++i) {
+        cpu.memory.write_byte(0x2007, (uint8_t)(i * 7));
+    }
+    cpu.memory.write_byte(0x2006, 0x3F);
+    cpu.memory.write_byte(0x2006, 0x00);
+    for (int i = 0; i < 32; ++i) {
+        cpu.memory.write_byte(0x2007, (uint8_t)(i * 13 + 5));
+    }
+    cpu.memory.write_byte(0x2001, 0x0A);
+    cpu.run_frame();
+
+    // and an emphasis change partway along a row
+    while (cpu.ppu.scanline() != 77 || cpu.ppu.dot() < 100) {
+        cpu.run_until(cpu.cycle_count + 1);
+        cpu.ppu.catch_up();
+    }
+    cpu.memory.write_byte(0x2001, 0xAA);
+    cpu.run_frame();
+    REQUIRE(cpu.ppu.emphasis_spans().size() == 2);
+
+    for (const PixelFormat format : { PixelFormat::Rgba8888, PixelFormat::Rgb565, PixelFormat::Gray8 }) {
+        for (const bool half_size : { false, true }) {
+            frame_convert_use_ssse3          = false;
+            const std::vector<uint8_t> plain = convert(cpu, format, half_size);
+            frame_convert_use_ssse3          = true;
+            REQUIRE(convert(cpu, format, half_size) == plain);
+        }
+    }
+}
@@ -0,0 +1,182 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "headless.h"
+#include "opcodes.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+static std::vector<uint8_t> bytes(std::string_view text)
+{
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+TEST_CASE("xxhash64 matches the reference", "[headless]")
+{
+    REQUIRE(xxhash64({}) == 0xEF46DB3751D8E999);
+    REQUIRE(xxhash64(bytes("a")) == 0xD24EC4F1A98C6E5B);
+    REQUIRE(xxhash64(bytes("abc")) == 0x44BC2CF5AD770999);
+
+    // long enough for the four lane loop and every tail
+    std::vector<uint8_t> counting(100);
+    for (size_t i = 0; i < counting.size(); ++i) {
+        counting[i] = (uint8_t)i;
+    }
+    REQUIRE(xxhash64(counting) == 0x6AC1E58032166597);
+    REQUIRE(xxhash64(counting, 1) == 0x3D19A3A2098A7023);
+}
+
+TEST_CASE("controller reads", "[headless]")
+{
+    CPU6502 cpu;
+    cpu.io_registers.set_buttons(0, (uint8_t)Button::A | (uint8_t)Button::Start | (uint8_t)Button::Right);
+    cpu.io_registers.set_buttons(1, (uint8_t)Button::B);
+    REQUIRE_FALSE(cpu.memory.read_repeatable(0x4016));
+
+    SECTION("the strobe latches the buttons and they come out A first")
+    {
+        cpu.memory.write_byte(0x4016, 1);
+        cpu.memory.write_byte(0x4016, 0);
+        // pressing something after the strobe doesn't show up until the next one
+        cpu.io_registers.set_buttons(0, 0);
+
+        constexpr std::array<uint8_t, 8> port0 = { 1, 0, 0, 1, 0, 0, 0, 1 };
+        constexpr std::array<uint8_t, 8> port1 = { 0, 1, 0, 0, 0, 0, 0, 0 };
+        for (size_t i = 0; i < 8; ++i) {
+            REQUIRE(cpu.memory.read_byte(0x4016) == (0x40 | port0[i]));
+            REQUIRE(cpu.memory.read_byte(0x4017) == (0x40 | port1[i]));
+        }
+        REQUIRE(cpu.memory.read_byte(0x4016) == 0x41);
+        REQUIRE(cpu.memory.read_byte(0x4017) == 0x41);
+    }
+
+    SECTION("while the strobe is high every read is A")
+    {
+        cpu.memory.write_byte(0x4016, 1);
+        REQUIRE(cpu.memory.read_byte(0x4016) == 0x41);
+        REQUIRE(cpu.memory.read_byte(0x4016) == 0x41);
+        cpu.io_registers.set_buttons(0, 0);
+        REQUIRE(cpu.memory.read_byte(0x4016) == 0x40);
+    }
+}
+
+TEST_CASE("input scripts", "[headless]")
+{
+    const std::optional<InputScript> script = InputScript::parse("# a comment\n"
+                                                                 "\n"
+                                                                 "10 .......A\n"
+                                                                 "20 R..UT... ......B.\r\n"
+                                                                 "30 ........\n");
+    REQUIRE(script.has_value());
+    REQUIRE(script->buttons(1) == std::array<uint8_t, 2>{ 0, 0 });
+    REQUIRE(script->buttons(10) == std::array<uint8_t, 2>{ (uint8_t)Button::A, 0 });
+    REQUIRE(script->buttons(19) == std::array<uint8_t, 2>{ (uint8_t)Button::A, 0 });
+    const uint8_t held = (uint8_t)Button::Right | (uint8_t)Button::Up | (uint8_t)Button::Start;
+    REQUIRE(script->buttons(20) == std::array<uint8_t, 2>{ held, (uint8_t)Button::B });
+    REQUIRE(script->buttons(1000) == std::array<uint8_t, 2>{ 0, 0 });
+
+    REQUIRE_FALSE(InputScript::parse("10 ....\n").has_value());
+    REQUIRE_FALSE(InputScript::parse("x .......A\n").has_value());
+    REQUIRE_FALSE(InputScript::parse("0 .......A\n").has_value());
+    REQUIRE_FALSE(InputScript::parse("10 .......A\n5 ........\n").has_value());
+    REQUIRE_FALSE(InputScript::parse("10 .......A ........ ........\n").has_value());
+}
+
+// NROM that reads controller 1 into $01 over and over, A ending up in bit 7:
+// loop: LDA #$01; STA $4016; LDA #$00; STA $4016; LDX #$08
+// read: LDA $4016; LSR A; ROL $00; DEX; BNE read; LDA $00; STA $01; JMP loop
+static std::shared_ptr<const Cartridge> make_controller_cartridge()
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, 1, 0 };
+    image.resize(16 + 0x4000);
+
+    constexpr std::array<uint8_t, 28> program = { OPCODE_LDA_IMM, 0x01, OPCODE_STA_ABS, 0x16, 0x40,           //
+                                                  OPCODE_LDA_IMM, 0x00, OPCODE_STA_ABS, 0x16, 0x40,           //
+                                                  OPCODE_LDX_IMM, 0x08,                                       //
+                                                  OPCODE_LDA_ABS, 0x16, 0x40, OPCODE_LSR_ACC,                 //
+                                                  OPCODE_ROL_ZP,  0x00, OPCODE_DEX_IMP, OPCODE_BNE_REL, 0xF7, //
+                                                  OPCODE_LDA_ZP,  0x00, OPCODE_STA_ZP,  0x01,                 //
+                                                  OPCODE_JMP_ABS, 0x00, 0xC0 };
+    std::copy(program.begin(), program.end(), image.begin() + 16);
+    image[image.size() - 4] = 0x00;
+    image[image.size() - 3] = 0xC0;
+
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    return std::make_shared<const Cartridge>(std::move(*cart));
+}
+
+// run_headless's report, read back from the file it was written to
+static std::string headless_report(CPU6502& cpu, const InputScript& input, const HeadlessOptions& options)
+{
+    FILE* file = tmpfile();
+    REQUIRE(file != nullptr);
+    run_headless(cpu, input, options, file);
+    rewind(file);
+    std::string report;
+    char buffer[256];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        report.append(buffer, read);
+    }
+    fclose(file);
+    return report;
+}
+
+// the lines of a run_headless report that start with prefix
+static std::string report_lines(const std::string& report, std::string_view prefix)
+{
+    std::string lines;
+    for (size_t start = 0; start < report.size();) {
+        const size_t newline        = report.find('\n', start);
+        const size_t end            = newline == std::string::npos ? report.size() : newline + 1;
+        const std::string_view line = std::string_view(report).substr(start, end - start);
+        if (line.starts_with(prefix)) lines += line;
+        start = end;
+    }
+    return lines;
+}
+
+TEST_CASE("headless runs hash frames and RAM", "[headless]")
+{
+    const std::optional<InputScript> input = InputScript::parse("2 .......A\n3 R.......\n");
+    REQUIRE(input.has_value());
+    HeadlessOptions options;
+    options.frames            = 4;
+    options.ram_hash_interval = 2;
+
+    const auto run = [&](const InputScript& script, uint8_t backdrop) {
+        auto cpu = std::make_unique<CPU6502>();
+        REQUIRE(cpu->load_cartridge(make_controller_cartridge()));
+        cpu->reset();
+        cpu->ppu.vram_write(0x3F00, backdrop);
+        const std::string report = headless_report(*cpu, script, options);
+        return std::make_pair(report, cpu->memory.read_byte(0x0001));
+    };
+
+    const auto [report, last_read] = run(*input, 0x0F);
+    REQUIRE(last_read == 0x01);
+    REQUIRE(report_lines(report, "frame ").size() == 4 * std::string_view("frame 1 0123456789abcdef\n").size());
+    REQUIRE(report_lines(report, "ram ").starts_with("ram 2 "));
+    REQUIRE(report_lines(report, "ram ").find("\nram 4 ") != std::string::npos);
+    REQUIRE(report_lines(report, "ram ").size() == 2 * std::string_view("ram 2 0123456789abcdef\n").size());
+
+    // the same run hashes the same, a different picture only changes the frame hashes and different input only the
+    // RAM hashes
+    REQUIRE(run(*input, 0x0F).first == report);
+    const std::string other_backdrop = run(*input, 0x30).first;
+    REQUIRE(report_lines(other_backdrop, "frame ") != report_lines(report, "frame "));
+    REQUIRE(report_lines(other_backdrop, "ram ") == report_lines(report, "ram "));
+    const std::string no_input = run(InputScript(), 0x0F).first;
+    REQUIRE(report_lines(no_input, "frame ") == report_lines(report, "frame "));
+    REQUIRE(report_lines(no_input, "ram ") != report_lines(report, "ram "));
+}
@@ -0,0 +1,152 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cpu.h"
+#include "opcodes.h"
+#include "scheduler.h"
+
+#include <initializer_list>
+#include <vector>
+
+// 32KiB of ROM at $8000 with the given code at $8000, the NMI handler at $9000 and the IRQ/BRK handler at $A000
+static void write_rom(CPU6502& cpu, std::initializer_list<uint8_t> main, std::initializer_list<uint8_t> nmi,
+                      std::initializer_list<uint8_t> irq)
+{
+    std::vector<uint8_t> rom(0x8000);
+    std::copy(main.begin(), main.end(), rom.begin());
+    std::copy(nmi.begin(), nmi.end(), rom.begin() + 0x1000);
+    std::copy(irq.begin(), irq.end(), rom.begin() + 0x2000);
+    rom[0x7FFA] = 0x00;
+    rom[0x7FFB] = 0x90;
+    rom[0x7FFE] = 0x00;
+    rom[0x7FFF] = 0xA0;
+    cpu.memory.write_rom(0x8000, rom);
+    cpu.registers.pc = 0x8000;
+    cpu.registers.s  = 0xFD;
+}
+
+TEST_CASE("brk imp", "[brk],[cpu],[imp],[instruction]")
+{
+    CPU6502 cpu;
+    // BRK; padding; INY and an IRQ handler of INX; RTI
+    write_rom(cpu, { OPCODE_BRK_IMP, 0xFF, OPCODE_INY_IMP }, {}, { OPCODE_INX_IMP, OPCODE_RTI_IMP });
+    cpu.registers.p.set_value(0x01); // just C
+
+    REQUIRE(cpu.process_instruction() == 7);
+    REQUIRE(cpu.registers.pc == 0xA000);
+    REQUIRE(cpu.registers.p.int_disable_flag_set());
+    REQUIRE(cpu.stack_top_byte() == 0x31); // C, bit 4 and bit 5
+    REQUIRE(cpu.memory.read_word(0x1FC) == 0x8002);
+
+    cpu.process_instruction();
+    cpu.process_instruction();
+    REQUIRE(cpu.registers.pc == 0x8002);
+    REQUIRE(cpu.registers.x == 1);
+    REQUIRE_FALSE(cpu.registers.p.int_disable_flag_set());
+    REQUIRE(cpu.registers.s == 0xFD);
+}
+
+// Triggers an NMI every period cycles, like the PPU at the start of vblank
+struct NmiSource : EventHandler
+{
+    NmiSource(CPU6502& nmi_cpu, uint64_t nmi_period) : cpu(nmi_cpu), period(nmi_period)
+    {
+        cpu.scheduler.schedule(this, period);
+    }
+
+    void run_event(uint64_t cycle) override
+    {
+        cpu.trigger_nmi();
+        cpu.scheduler.schedule(this, cycle + period);
+    }
+
+    CPU6502& cpu;
+    uint64_t period;
+};
+
+TEST_CASE("NMIs interrupt the running code", "[cpu],[interrupts]")
+{
+    // JMP $8000 with an NMI handler of INC $10; RTI
+    const auto setup = [](CPU6502& cpu) {
+        write_rom(cpu, { OPCODE_JMP_ABS, 0x00, 0x80 }, { OPCODE_INC_ZP, 0x10, OPCODE_RTI_IMP }, {});
+    };
+
+    CPU6502 stepping;
+    stepping.use_block_cache = false;
+    setup(stepping);
+    NmiSource stepping_nmi(stepping, 1000);
+    stepping.run_until(10500);
+    REQUIRE(stepping.memory.read_byte(0x10) == 10);
+    REQUIRE(stepping.registers.s == 0xFD);
+
+    CPU6502 cpu;
+    SECTION("block cache") {}
+    SECTION("recompiler")
+    {
+        cpu.use_recompiler = true;
+    }
+    setup(cpu);
+    NmiSource nmi(cpu, 1000);
+    for (uint64_t target = 1; target < 10500; target += 97) {
+        cpu.run_until(target);
+    }
+    cpu.run_until(10500);
+    REQUIRE(cpu.cycle_count == stepping.cycle_count);
+    REQUIRE(cpu.registers.pc == stepping.registers.pc);
+    REQUIRE(cpu.memory.read_byte(0x10) == 10);
+    REQUIRE(cpu.idle_cycles_skipped > 0);
+}
+
+TEST_CASE("next_cycle takes interrupts", "[cpu],[interrupts]")
+{
+    CPU6502 cpu;
+    write_rom(cpu, { OPCODE_JMP_ABS, 0x00, 0x80 }, { OPCODE_INC_ZP, 0x10, OPCODE_RTI_IMP }, {});
+    NmiSource nmi(cpu, 1000);
+    while (cpu.cycle_count < 10500) {
+        cpu.next_cycle();
+    }
+    REQUIRE(cpu.memory.read_byte(0x10) == 10);
+}
+
+TEST_CASE("IRQs wait for the I flag", "[cpu],[interrupts]")
+{
+    // LDY #$00; loop: INY; BNE loop; CLI; JMP *
+    // with an IRQ handler that counts in X and sets I in the pushed flags so it's only taken once:
+    // INX; PLA; ORA #$04; PHA; RTI
+    const auto setup = [](CPU6502& cpu) {
+        write_rom(cpu,
+                  { OPCODE_LDY_IMM, 0x00, OPCODE_INY_IMP, OPCODE_BNE_REL, 0xFD, OPCODE_CLI_IMP, //
+                    OPCODE_JMP_ABS, 0x06, 0x80 },
+                  {},
+                  { OPCODE_INX_IMP, OPCODE_PLA_IMP, OPCODE_ORA_IMM, 0x04, OPCODE_PHA_IMP, OPCODE_RTI_IMP });
+        cpu.registers.p.set_int_disable_flag();
+    };
+
+    CPU6502 cpu;
+    SECTION("block cache") {}
+    SECTION("recompiler")
+    {
+        cpu.use_recompiler = true;
+    }
+    SECTION("one instruction at a time")
+    {
+        cpu.use_block_cache = false;
+    }
+    setup(cpu);
+    cpu.set_irq_line(IrqSource::Mapper, true);
+
+    cpu.run_until(1000);
+    REQUIRE(cpu.registers.x == 0);
+
+    cpu.run_until(5000);
+    REQUIRE(cpu.registers.x == 1);
+    REQUIRE(cpu.registers.y == 0);
+    REQUIRE(cpu.registers.pc == 0x8006);
+    REQUIRE(cpu.registers.p.int_disable_flag_set());
+    REQUIRE(cpu.registers.s == 0xFD);
+
+    // acknowledging the IRQ and clearing I doesn't take it again
+    cpu.set_irq_line(IrqSource::Mapper, false);
+    cpu.registers.p.clear_int_disable_flag();
+    cpu.run_until(6000);
+    REQUIRE(cpu.registers.x == 1);
+}
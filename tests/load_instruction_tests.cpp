@@ -231,8 +231,8 @@ TEST_CASE("lda indx", "[lda],[cpu],[indx],[instruction]")
     {
         cpu.registers.x = 4;
         cpu.memory.write_byte(0xF4, 0x12);
-        cpu.memory.write_byte(0xF5, 0x34);
-        cpu.memory.write_byte(0x3412, 42);
+        cpu.memory.write_byte(0xF5, 0x04);
+        cpu.memory.write_byte(0x0412, 42);
         cpu.process_instruction();
 
         REQUIRE(cpu.registers.pc == 2);
@@ -243,8 +243,8 @@ TEST_CASE("lda indx", "[lda],[cpu],[indx],[instruction]")
     {
         cpu.registers.x = 0x20;
         cpu.memory.write_byte(0x10, 0x12);
-        cpu.memory.write_byte(0x11, 0x34);
-        cpu.memory.write_byte(0x3412, 42);
+        cpu.memory.write_byte(0x11, 0x04);
+        cpu.memory.write_byte(0x0412, 42);
         cpu.process_instruction();
 
         REQUIRE(cpu.registers.pc == 2);
@@ -261,9 +261,9 @@ TEST_CASE("lda indy", "[lda],[cpu],[indy],[instruction]")
     {
         cpu.memory.write_byte(1, 0x20);
         cpu.memory.write_byte(0x20, 0x12);
-        cpu.memory.write_byte(0x21, 0x34);
+        cpu.memory.write_byte(0x21, 0x04);
         cpu.registers.y = 0x10;
-        cpu.memory.write_byte(0x3412 + 0x10, 42);
+        cpu.memory.write_byte(0x0412 + 0x10, 42);
         cpu.process_instruction();
 
         REQUIRE(cpu.registers.pc == 2);
@@ -339,3 +339,73 @@ TEST_CASE("sty zp", "[sty],[cpu],[zp],[instruction]")
 
     REQUIRE(cpu.memory.read_byte(0x20) == 44);
 }
+
+TEST_CASE("page crossing penalty", "[cpu],[instruction]")
+{
+    CPU6502 cpu;
+
+    SECTION("lda absx")
+    {
+        cpu.memory.write_byte(0, OPCODE_LDA_ABSX);
+        cpu.memory.write_word(1, 0x02F0);
+        cpu.registers.x = 0x0F;
+        REQUIRE(cpu.process_instruction() == 4);
+
+        cpu.registers.pc = 0;
+        cpu.registers.x  = 0x10;
+        REQUIRE(cpu.process_instruction() == 5);
+    }
+
+    SECTION("lda absy landing on the start of a page")
+    {
+        cpu.memory.write_byte(0, OPCODE_LDA_ABSY);
+        cpu.memory.write_word(1, 0x0200);
+        cpu.registers.y = 0x00;
+        REQUIRE(cpu.process_instruction() == 4);
+    }
+
+    SECTION("ldx absy")
+    {
+        cpu.memory.write_byte(0, OPCODE_LDX_ABSY);
+        cpu.memory.write_word(1, 0x02FF);
+        cpu.registers.y = 0x01;
+        REQUIRE(cpu.process_instruction() == 5);
+    }
+
+    SECTION("eor absx")
+    {
+        cpu.memory.write_byte(0, OPCODE_EOR_ABSX);
+        cpu.memory.write_word(1, 0x02FF);
+        cpu.memory.write_byte(0x0300, 0x0F);
+        cpu.registers.a = 0xFF;
+        cpu.registers.x = 0x01;
+        REQUIRE(cpu.process_instruction() == 5);
+        REQUIRE(cpu.registers.pc == 3);
+        REQUIRE(cpu.registers.a == 0xF0);
+
+        cpu.registers.pc = 0;
+        cpu.registers.x  = 0x00;
+        REQUIRE(cpu.process_instruction() == 4);
+    }
+
+    SECTION("lda indy")
+    {
+        cpu.memory.write_byte(0, OPCODE_LDA_INDY);
+        cpu.memory.write_byte(1, 0x20);
+        cpu.memory.write_word(0x20, 0x0280);
+        cpu.registers.y = 0x7F;
+        REQUIRE(cpu.process_instruction() == 5);
+
+        cpu.registers.pc = 0;
+        cpu.registers.y  = 0x80;
+        REQUIRE(cpu.process_instruction() == 6);
+    }
+
+    SECTION("writes always take the extra cycle")
+    {
+        cpu.memory.write_byte(0, OPCODE_STA_ABSX);
+        cpu.memory.write_word(1, 0x0200);
+        cpu.registers.x = 0x01;
+        REQUIRE(cpu.process_instruction() == 5);
+    }
+}
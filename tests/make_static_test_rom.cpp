@@ -0,0 +1,16 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "static_test_rom.h"
+
+// Writes the rom from static_test_rom.h out for nes-static-recompile
+int main(int argc, char* argv[])
+{
+    if (argc < 2) return EXIT_FAILURE;
+
+    const std::vector<uint8_t> image = static_test_rom();
+    FILE* file                       = fopen(argv[1], "wb");
+    if (!file) return EXIT_FAILURE;
+    const bool written = fwrite(image.data(), 1, image.size(), file) == image.size();
+    return fclose(file) == 0 && written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
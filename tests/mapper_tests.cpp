@@ -0,0 +1,234 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "mapper.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Builds an iNES image where every byte of 8KiB PRG bank n is n, and every byte of 1KiB CHR bank n is n
+static std::shared_ptr<const Cartridge> make_cartridge(uint8_t mapper_number, uint8_t prg_banks_16k, uint8_t chr_banks_8k)
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, prg_banks_16k, chr_banks_8k };
+    image.resize(16);
+    image[6] = (uint8_t)(mapper_number << 4);
+    image[7] = mapper_number & 0xF0;
+    for (size_t i = 0; i < prg_banks_16k * 2u; ++i) {
+        image.insert(image.end(), 0x2000, (uint8_t)i);
+    }
+    for (size_t i = 0; i < chr_banks_8k * 8u; ++i) {
+        image.insert(image.end(), 0x400, (uint8_t)i);
+    }
+
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    return std::make_shared<const Cartridge>(std::move(*cart));
+}
+
+TEST_CASE("nrom", "[mapper],[nrom]")
+{
+    CPU6502 cpu;
+
+    SECTION("16KiB is mirrored into $C000")
+    {
+        const auto cart = make_cartridge(0, 1, 1);
+        REQUIRE(cpu.load_cartridge(cart));
+
+        REQUIRE(cpu.memory.read_byte(0x8000) == 0);
+        REQUIRE(cpu.memory.read_byte(0xA000) == 1);
+        REQUIRE(cpu.memory.read_byte(0xC000) == 0);
+        REQUIRE(cpu.memory.read_byte(0xE000) == 1);
+    }
+
+    SECTION("32KiB")
+    {
+        const auto cart = make_cartridge(0, 2, 1);
+        REQUIRE(cpu.load_cartridge(cart));
+
+        REQUIRE(cpu.memory.read_byte(0x8000) == 0);
+        REQUIRE(cpu.memory.read_byte(0xFFFF) == 3);
+        REQUIRE(cpu.mapper->chr_read(0x1FFF) == 7);
+    }
+
+    SECTION("ROM can't be written, PRG-RAM can")
+    {
+        const auto cart = make_cartridge(0, 2, 1);
+        REQUIRE(cpu.load_cartridge(cart));
+
+        cpu.memory.write_byte(0x8000, 42);
+        cpu.memory.write_byte(0x6000, 42);
+        REQUIRE(cpu.memory.read_byte(0x8000) == 0);
+        REQUIRE(cpu.memory.read_byte(0x6000) == 42);
+    }
+}
+
+static void mmc1_write(CPU6502& cpu, uint16_t addr, uint8_t value)
+{
+    for (int i = 0; i < 5; ++i) {
+        cpu.memory.write_byte(addr, (value >> i) & 1);
+    }
+}
+
+TEST_CASE("mmc1", "[mapper],[mmc1]")
+{
+    CPU6502 cpu;
+    const auto cart = make_cartridge(1, 8, 4);
+    REQUIRE(cpu.load_cartridge(cart));
+
+    // powers up with the last bank fixed at $C000
+    REQUIRE(cpu.memory.read_byte(0xC000) == 14);
+
+    SECTION("switch 16KiB bank at $8000")
+    {
+        mmc1_write(cpu, 0xE000, 3);
+        REQUIRE(cpu.memory.read_byte(0x8000) == 6);
+        REQUIRE(cpu.memory.read_byte(0xA000) == 7);
+        REQUIRE(cpu.memory.read_byte(0xC000) == 14);
+    }
+
+    SECTION("32KiB mode ignores the low bit")
+    {
+        mmc1_write(cpu, 0x8000, 0b00000);
+        mmc1_write(cpu, 0xE000, 3);
+        REQUIRE(cpu.memory.read_byte(0x8000) == 4);
+        REQUIRE(cpu.memory.read_byte(0xE000) == 7);
+    }
+
+    SECTION("4KiB CHR banks and mirroring")
+    {
+        mmc1_write(cpu, 0x8000, 0b10010);
+        mmc1_write(cpu, 0xA000, 3);
+        mmc1_write(cpu, 0xC000, 5);
+        REQUIRE(cpu.mapper->mirroring() == Mirroring::Vertical);
+        REQUIRE(cpu.mapper->chr_read(0x0000) == 12);
+        REQUIRE(cpu.mapper->chr_read(0x1000) == 20);
+    }
+
+    SECTION("a write with bit 7 set resets the shift register")
+    {
+        cpu.memory.write_byte(0xE000, 1);
+        cpu.memory.write_byte(0xE000, 0x80);
+        mmc1_write(cpu, 0xE000, 2);
+        REQUIRE(cpu.memory.read_byte(0x8000) == 4);
+    }
+}
+
+TEST_CASE("uxrom", "[mapper],[uxrom]")
+{
+    CPU6502 cpu;
+    const auto cart = make_cartridge(2, 8, 0);
+    REQUIRE(cpu.load_cartridge(cart));
+
+    cpu.memory.write_byte(0x8000, 5);
+    REQUIRE(cpu.memory.read_byte(0x8000) == 10);
+    REQUIRE(cpu.memory.read_byte(0xC000) == 14);
+
+    SECTION("CHR-RAM is writable")
+    {
+        cpu.mapper->chr_write(0x1234, 42);
+        REQUIRE(cpu.mapper->chr_read(0x1234) == 42);
+    }
+}
+
+TEST_CASE("cnrom", "[mapper],[cnrom]")
+{
+    CPU6502 cpu;
+    const auto cart = make_cartridge(3, 2, 4);
+    REQUIRE(cpu.load_cartridge(cart));
+
+    cpu.memory.write_byte(0x8000, 2);
+    REQUIRE(cpu.mapper->chr_read(0x0000) == 16);
+    REQUIRE(cpu.mapper->chr_read(0x1C00) == 23);
+
+    SECTION("CHR-ROM isn't writable")
+    {
+        cpu.mapper->chr_write(0x0000, 42);
+        REQUIRE(cpu.mapper->chr_read(0x0000) == 16);
+    }
+}
+
+TEST_CASE("mmc3", "[mapper],[mmc3]")
+{
+    CPU6502 cpu;
+    const auto cart = make_cartridge(4, 8, 4);
+    REQUIRE(cpu.load_cartridge(cart));
+
+    SECTION("PRG banks")
+    {
+        cpu.memory.write_byte(0x8000, 6);
+        cpu.memory.write_byte(0x8001, 3);
+        cpu.memory.write_byte(0x8000, 7);
+        cpu.memory.write_byte(0x8001, 9);
+        REQUIRE(cpu.memory.read_byte(0x8000) == 3);
+        REQUIRE(cpu.memory.read_byte(0xA000) == 9);
+        REQUIRE(cpu.memory.read_byte(0xC000) == 14);
+        REQUIRE(cpu.memory.read_byte(0xE000) == 15);
+
+        cpu.memory.write_byte(0x8000, 0x46);
+        REQUIRE(cpu.memory.read_byte(0x8000) == 14);
+        REQUIRE(cpu.memory.read_byte(0xC000) == 3);
+    }
+
+    SECTION("CHR banks with A12 inversion")
+    {
+        cpu.memory.write_byte(0x8000, 0x80);
+        cpu.memory.write_byte(0x8001, 11);
+        cpu.memory.write_byte(0x8000, 0x82);
+        cpu.memory.write_byte(0x8001, 20);
+        REQUIRE(cpu.mapper->chr_read(0x1000) == 10);
+        REQUIRE(cpu.mapper->chr_read(0x1400) == 11);
+        REQUIRE(cpu.mapper->chr_read(0x0000) == 20);
+    }
+
+    SECTION("scanline IRQ")
+    {
+        cpu.memory.write_byte(0xC000, 2);
+        cpu.memory.write_byte(0xC001, 0);
+        cpu.memory.write_byte(0xE001, 0);
+
+        cpu.mapper->clock_scanline();
+        cpu.mapper->clock_scanline();
+        REQUIRE(!cpu.mapper->irq_asserted());
+        cpu.mapper->clock_scanline();
+        REQUIRE(cpu.mapper->irq_asserted());
+
+        cpu.memory.write_byte(0xE000, 0);
+        REQUIRE(!cpu.mapper->irq_asserted());
+    }
+}
+
+TEST_CASE("unsupported mapper", "[mapper]")
+{
+    CPU6502 cpu;
+    const auto cart = make_cartridge(5, 2, 1);
+    REQUIRE(!cpu.load_cartridge(cart));
+}
+
+TEST_CASE("instances share one ROM image", "[mapper]")
+{
+    const auto cart = make_cartridge(4, 8, 4);
+    CPU6502 first;
+    CPU6502 second;
+    REQUIRE(first.load_cartridge(cart));
+    REQUIRE(second.load_cartridge(cart));
+    REQUIRE(cart.use_count() == 3);
+
+    REQUIRE(first.memory.read_page(0xE0) == second.memory.read_page(0xE0));
+    REQUIRE(first.memory.read_page(0xE0) == cart->get_program_data().data() + 15 * 0x2000);
+
+    SECTION("bank state is per instance")
+    {
+        first.memory.write_byte(0x8000, 6);
+        first.memory.write_byte(0x8001, 3);
+        REQUIRE(first.memory.read_byte(0x8000) == 3);
+        REQUIRE(second.memory.read_byte(0x8000) == 0);
+    }
+
+    SECTION("PRG-RAM is per instance")
+    {
+        first.memory.write_byte(0x6000, 42);
+        REQUIRE(second.memory.read_byte(0x6000) == 0);
+    }
+}
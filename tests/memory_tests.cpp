@@ -12,3 +12,89 @@ TEST_CASE("mirror r/w", "[memory],[RAM]")
     REQUIRE(memory.read_byte(10 + 0x800 * 2) == 42);
     REQUIRE(memory.read_byte(10 + 0x800 * 3) == 42);
 }
+
+TEST_CASE("ppu register mirrors", "[memory],[IO]")
+{
+    Memory memory;
+    memory.write_byte(0x2003, 42);
+
+    REQUIRE(memory.read_byte(0x2003) == 42);
+    REQUIRE(memory.read_byte(0x2003 + 0x08) == 42);
+    REQUIRE(memory.read_byte(0x3FFB) == 42);
+}
+
+TEST_CASE("mirrored pages share storage", "[memory]")
+{
+    Memory memory;
+    memory.write_rom(0x8000, std::array<uint8_t, 1>{ 0 });
+    memory.mirror_pages(0xC0, 0x40, 0x80);
+    memory.write_byte(0x8123, 42);
+
+    REQUIRE(memory.read_byte(0xC123) == 42);
+
+    memory.write_byte(0xFFFC, 0x34);
+    REQUIRE(memory.read_byte(0xBFFC) == 0x34);
+}
+
+namespace
+{
+struct RecordingIoHandler : IoHandler
+{
+    uint16_t last_read_addr  = 0;
+    uint16_t last_write_addr = 0;
+    uint8_t last_write_data  = 0;
+
+    uint8_t io_read(uint16_t addr) override
+    {
+        last_read_addr = addr;
+        return 0x5A;
+    }
+
+    void io_write(uint16_t addr, uint8_t data) override
+    {
+        last_write_addr = addr;
+        last_write_data = data;
+    }
+};
+} // namespace
+
+TEST_CASE("io handler pages", "[memory],[IO]")
+{
+    Memory memory;
+    RecordingIoHandler handler;
+    memory.map_io(0x20, 0x20, &handler);
+
+    REQUIRE(memory.read_byte(0x2002) == 0x5A);
+    REQUIRE(handler.last_read_addr == 0x2002);
+
+    memory.write_byte(0x3FFF, 7);
+    REQUIRE(handler.last_write_addr == 0x3FFF);
+    REQUIRE(handler.last_write_data == 7);
+
+    SECTION("plain memory pages don't reach the handler")
+    {
+        memory.write_byte(0x10, 1);
+        REQUIRE(handler.last_write_addr == 0x3FFF);
+    }
+}
+
+TEST_CASE("unmapped writes are dropped", "[memory]")
+{
+    Memory memory;
+    memory.write_byte(0x8000, 42);
+    memory.map_write(0x80, 0x80, nullptr);
+    memory.write_byte(0x8000, 7);
+
+    REQUIRE(memory.read_byte(0x8000) == 42);
+}
+
+TEST_CASE("cartridge space is only allocated when used", "[memory]")
+{
+    Memory memory;
+    REQUIRE(memory.read_byte(0xC400) == 0);
+    REQUIRE(!memory.m_OpenCartridgeSpace);
+
+    memory.write_byte(0xC400, 42);
+    REQUIRE(memory.m_OpenCartridgeSpace);
+    REQUIRE(memory.read_byte(0xC400) == 42);
+}
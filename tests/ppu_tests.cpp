@@ -0,0 +1,471 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "opcodes.h"
+
+#include <filesystem>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+static void write_program(CPU6502& cpu, uint16_t addr, std::initializer_list<uint8_t> program)
+{
+    for (uint8_t byte : program) {
+        cpu.memory.write_byte(addr++, byte);
+    }
+}
+
+// A cartridge with CHR-RAM and horizontal mirroring whose NMI handler is at $0010 and IRQ handler at $0030
+static std::shared_ptr<const Cartridge> make_chr_ram_cartridge(uint8_t mapper_number, uint8_t prg_banks_16k)
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, prg_banks_16k, 0 };
+    image.resize(16);
+    image[6] = (uint8_t)(mapper_number << 4);
+    image.resize(16 + prg_banks_16k * 0x4000);
+    image[image.size() - 6] = 0x10;
+    image[image.size() - 2] = 0x30;
+
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    return std::make_shared<const Cartridge>(std::move(*cart));
+}
+
+static void set_vram_address(CPU6502& cpu, uint16_t addr)
+{
+    cpu.memory.write_byte(0x2006, (uint8_t)(addr >> 8));
+    cpu.memory.write_byte(0x2006, (uint8_t)addr);
+}
+
+static void write_vram(CPU6502& cpu, uint16_t addr, std::initializer_list<uint8_t> data)
+{
+    set_vram_address(cpu, addr);
+    for (uint8_t byte : data) {
+        cpu.memory.write_byte(0x2007, byte);
+    }
+}
+
+static uint8_t pixel(const CPU6502& cpu, int x, int y)
+{
+    return cpu.ppu.frame()[(size_t)(y * Ppu::width + x)];
+}
+
+constexpr uint8_t black = 0x0F;
+constexpr uint8_t white = 0x30;
+constexpr uint8_t red   = 0x16;
+
+TEST_CASE("ppu memory", "[ppu]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(make_chr_ram_cartridge(0, 1)));
+
+    SECTION("nametable reads are a read behind")
+    {
+        write_vram(cpu, 0x2108, { 0x11, 0x22 });
+        set_vram_address(cpu, 0x2108);
+        cpu.memory.read_byte(0x2007);
+        REQUIRE(cpu.memory.read_byte(0x2007) == 0x11);
+        REQUIRE(cpu.memory.read_byte(0x2007) == 0x22);
+
+        // horizontal mirroring
+        set_vram_address(cpu, 0x2508);
+        cpu.memory.read_byte(0x2007);
+        REQUIRE(cpu.memory.read_byte(0x2007) == 0x11);
+        REQUIRE(cpu.ppu.vram_read(0x2908) == 0);
+    }
+
+    SECTION("incrementing by 32")
+    {
+        cpu.memory.write_byte(0x2000, 0x04);
+        write_vram(cpu, 0x2000, { 1, 2 });
+        REQUIRE(cpu.ppu.vram_read(0x2000) == 1);
+        REQUIRE(cpu.ppu.vram_read(0x2020) == 2);
+    }
+
+    SECTION("palette reads aren't buffered and the sprite backdrops are mirrors")
+    {
+        write_vram(cpu, 0x3F00, { 0x0F });
+        set_vram_address(cpu, 0x3F10);
+        REQUIRE(cpu.memory.read_byte(0x2007) == 0x0F);
+
+        write_vram(cpu, 0x3F14, { 0x21 });
+        REQUIRE(cpu.ppu.vram_read(0x3F04) == 0x21);
+        REQUIRE(cpu.ppu.vram_read(0x3F24) == 0x21);
+    }
+
+    SECTION("pattern tables are the cartridge's CHR-RAM")
+    {
+        write_vram(cpu, 0x0010, { 0xAA });
+        REQUIRE(cpu.mapper->chr_read(0x0010) == 0xAA);
+    }
+}
+
+TEST_CASE("vblank and NMI", "[ppu],[interrupt]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(make_chr_ram_cartridge(0, 1)));
+    // JMP $0000, NMI: INC $20; RTI
+    write_program(cpu, 0x0000, { OPCODE_JMP_ABS, 0x00, 0x00 });
+    write_program(cpu, 0x0010, { OPCODE_INC_ZP, 0x20, OPCODE_RTI_IMP });
+    cpu.registers.pc = 0x0000;
+
+    // vblank starts on dot 1 of scanline 241
+    cpu.run_until(27390);
+    REQUIRE((cpu.memory.read_byte(0x2002) & 0x80) == 0);
+    cpu.run_until(27400);
+    REQUIRE(cpu.ppu.scanline() == Ppu::vblank_scanline);
+    REQUIRE(cpu.ppu.frame_count() == 1);
+
+    SECTION("reading the status clears the flag")
+    {
+        REQUIRE((cpu.memory.read_byte(0x2002) & 0x80) != 0);
+        REQUIRE((cpu.memory.read_byte(0x2002) & 0x80) == 0);
+    }
+
+    SECTION("the flag is cleared at the end of vblank")
+    {
+        cpu.run_until((Ppu::prerender_scanline * 341 + 1) / 3 + 1);
+        REQUIRE((cpu.memory.read_byte(0x2002) & 0x80) == 0);
+    }
+
+    SECTION("an NMI every frame while enabled")
+    {
+        cpu.memory.write_byte(0x2000, 0x80);
+        cpu.run_for_cycles(20);
+        REQUIRE(cpu.memory.read_byte(0x20) == 1);
+
+        cpu.run_frame();
+        cpu.run_frame();
+        cpu.run_for_cycles(20);
+        REQUIRE(cpu.ppu.frame_count() == 3);
+        REQUIRE(cpu.memory.read_byte(0x20) == 3);
+    }
+
+    SECTION("enabling NMI during vblank raises one straight away")
+    {
+        cpu.memory.write_byte(0x2000, 0x80);
+        REQUIRE(cpu.nmi_pending);
+    }
+}
+
+TEST_CASE("registers are read on the last cycle of the instruction", "[ppu]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(make_chr_ram_cartridge(0, 1)));
+    SECTION("stepping") { cpu.use_block_cache = false; }
+    SECTION("from the block cache") {}
+
+    // LDA $2002 takes 4 cycles and reads on the last, vblank is seen from the cycle dot 1 of scanline 241 is in
+    write_program(cpu, 0x0000, { OPCODE_LDA_ABS, 0x02, 0x20 });
+    const uint64_t vblank = cpu.ppu.next_vblank_cycle();
+
+    SECTION("the cycle before")
+    {
+        cpu.cycle_count = vblank - 4;
+        cpu.run_until(vblank - 3);
+        REQUIRE(cpu.cycle_count == vblank);
+        REQUIRE((cpu.registers.a & 0x80) == 0);
+        // it was only set after the read
+        REQUIRE((cpu.memory.read_byte(0x2002) & 0x80) != 0);
+    }
+
+    SECTION("on the cycle vblank starts")
+    {
+        cpu.cycle_count = vblank - 3;
+        cpu.run_until(vblank - 2);
+        REQUIRE(cpu.cycle_count == vblank + 1);
+        REQUIRE((cpu.registers.a & 0x80) != 0);
+        // and it was cleared by the read
+        REQUIRE((cpu.memory.read_byte(0x2002) & 0x80) == 0);
+    }
+}
+
+TEST_CASE("waiting for vblank on $2002", "[ppu],[cpu],[block_cache],[recompiler]")
+{
+    // wait: LDA $2002; BPL wait; INC $10; JMP wait, which goes round once a frame
+    CPU6502 stepping;
+    CPU6502 skipping;
+    CPU6502 recompiled;
+    stepping.use_block_cache   = false;
+    recompiled.use_recompiler  = true;
+    recompiled.skip_idle_loops = false;
+    for (CPU6502* cpu : { &stepping, &skipping, &recompiled }) {
+        REQUIRE(cpu->load_cartridge(make_chr_ram_cartridge(0, 1)));
+        write_program(*cpu,
+                      0x0000,
+                      { OPCODE_LDA_ABS, 0x02, 0x20, OPCODE_BPL_REL, 0xFB, //
+                        OPCODE_INC_ZP, 0x10, OPCODE_JMP_ABS, 0x00, 0x00 });
+        cpu->registers.pc = 0x0000;
+    }
+
+    // odd sized steps so runs end part way through the loop, and sometimes on the cycle vblank starts
+    for (uint64_t target = 1; target < 100000; target += 997) {
+        stepping.run_until(target);
+        for (CPU6502* cpu : { &skipping, &recompiled }) {
+            cpu->run_until(target);
+            REQUIRE(cpu->cycle_count == stepping.cycle_count);
+            REQUIRE(cpu->registers.pc == stepping.registers.pc);
+            REQUIRE(cpu->registers.a == stepping.registers.a);
+            REQUIRE(cpu->memory.read_byte(0x10) == stepping.memory.read_byte(0x10));
+        }
+    }
+    REQUIRE(stepping.memory.read_byte(0x10) == 3);
+    REQUIRE(skipping.idle_cycles_skipped > 50000);
+    REQUIRE(recompiled.block_cache.native_block(0x0000).entry != nullptr);
+
+    // it comes out of the loop on the first read that lands on or after the cycle vblank starts
+    const uint64_t vblank = stepping.ppu.next_vblank_cycle();
+    do {
+        stepping.run_for_cycles(1);
+    } while (stepping.registers.pc != 0x0005);
+    // BPL not taken is 2 cycles, the read was on the cycle before it
+    const uint64_t read_cycle = stepping.cycle_count - 3;
+    REQUIRE(read_cycle >= vblank);
+    REQUIRE(read_cycle < vblank + 7);
+}
+
+// Tile 1 is solid colour 1, drawn at tile (2, 3) of the first nametable. Colour 1 is white for the background and red
+// for sprites, the backdrop is black. All the sprites are off screen.
+static void set_up_scene(CPU6502& cpu)
+{
+    REQUIRE(cpu.load_cartridge(make_chr_ram_cartridge(0, 1)));
+    write_program(cpu, 0x0000, { OPCODE_JMP_ABS, 0x00, 0x00 });
+    cpu.registers.pc = 0x0000;
+
+    write_vram(cpu, 0x0010, { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF });
+    write_vram(cpu, 0x2000 + 3 * 32 + 2, { 1 });
+    write_vram(cpu, 0x3F00, { 0x0F, 0x30 });
+    write_vram(cpu, 0x3F11, { 0x16 });
+
+    cpu.memory.write_byte(0x2003, 0);
+    for (int i = 0; i < 0x100; ++i) {
+        cpu.memory.write_byte(0x2004, 0xFF);
+    }
+
+    cpu.memory.write_byte(0x2000, 0);
+    cpu.memory.write_byte(0x2005, 0);
+    cpu.memory.write_byte(0x2005, 0);
+}
+
+static void write_sprite(CPU6502& cpu, uint8_t index, std::initializer_list<uint8_t> entry)
+{
+    cpu.memory.write_byte(0x2003, (uint8_t)(index * 4));
+    for (uint8_t byte : entry) {
+        cpu.memory.write_byte(0x2004, byte);
+    }
+}
+
+// The scroll registers are only copied into v from the end of the first frame, so the second is the first that's right
+static void render(CPU6502& cpu)
+{
+    cpu.memory.write_byte(0x2001, 0x1E);
+    cpu.run_frame();
+    cpu.run_frame();
+}
+
+TEST_CASE("background rendering", "[ppu]")
+{
+    CPU6502 cpu;
+    set_up_scene(cpu);
+
+    SECTION("unscrolled")
+    {
+        render(cpu);
+        REQUIRE(pixel(cpu, 16, 24) == white);
+        REQUIRE(pixel(cpu, 23, 31) == white);
+        REQUIRE(pixel(cpu, 15, 24) == black);
+        REQUIRE(pixel(cpu, 24, 24) == black);
+        REQUIRE(pixel(cpu, 16, 32) == black);
+    }
+
+    SECTION("scrolled")
+    {
+        cpu.memory.write_byte(0x2005, 4);
+        cpu.memory.write_byte(0x2005, 9);
+        render(cpu);
+        REQUIRE(pixel(cpu, 12, 15) == white);
+        REQUIRE(pixel(cpu, 19, 22) == white);
+        REQUIRE(pixel(cpu, 11, 15) == black);
+        REQUIRE(pixel(cpu, 20, 15) == black);
+        REQUIRE(pixel(cpu, 12, 14) == black);
+    }
+
+    SECTION("rendering off shows the backdrop")
+    {
+        // or the palette entry v points at if it's in the palette
+        set_vram_address(cpu, 0x2000);
+        cpu.run_frame();
+        cpu.run_frame();
+        REQUIRE(pixel(cpu, 16, 24) == black);
+
+        set_vram_address(cpu, 0x3F01);
+        cpu.run_frame();
+        REQUIRE(pixel(cpu, 0, 239) == white);
+    }
+}
+
+TEST_CASE("sprite rendering", "[ppu]")
+{
+    CPU6502 cpu;
+    set_up_scene(cpu);
+
+    SECTION("in front of the background, with a sprite 0 hit")
+    {
+        write_sprite(cpu, 0, { 23, 1, 0x00, 20 });
+        render(cpu);
+        REQUIRE(pixel(cpu, 19, 24) == white);
+        REQUIRE(pixel(cpu, 20, 24) == red);
+        REQUIRE(pixel(cpu, 27, 31) == red);
+        REQUIRE(pixel(cpu, 28, 24) == black);
+        REQUIRE((cpu.memory.read_byte(0x2002) & 0x60) == 0x40);
+    }
+
+    SECTION("behind the background")
+    {
+        write_sprite(cpu, 0, { 23, 1, 0x20, 20 });
+        render(cpu);
+        REQUIRE(pixel(cpu, 20, 24) == white);
+        REQUIRE(pixel(cpu, 24, 24) == red);
+    }
+
+    SECTION("no hit where the background is transparent")
+    {
+        write_sprite(cpu, 0, { 100, 1, 0x00, 100 });
+        render(cpu);
+        REQUIRE(pixel(cpu, 100, 101) == red);
+        REQUIRE((cpu.memory.read_byte(0x2002) & 0x40) == 0);
+    }
+
+    SECTION("more than eight on a scanline")
+    {
+        for (uint8_t i = 0; i < 9; ++i) {
+            write_sprite(cpu, i, { 100, 1, 0x00, (uint8_t)(i * 16) });
+        }
+        render(cpu);
+        REQUIRE(pixel(cpu, 7 * 16, 101) == red);
+        REQUIRE(pixel(cpu, 8 * 16, 101) == black);
+        REQUIRE((cpu.memory.read_byte(0x2002) & 0x20) == 0x20);
+    }
+}
+
+TEST_CASE("MMC3 counts rendered scanlines", "[ppu],[mapper],[interrupt]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(make_chr_ram_cartridge(4, 2)));
+    // CLI; JMP $0001, IRQ: INC $21; STA $E000; RTI which acknowledges and disables it
+    write_program(cpu, 0x0000, { OPCODE_CLI_IMP, OPCODE_JMP_ABS, 0x01, 0x00 });
+    write_program(cpu, 0x0030, { OPCODE_INC_ZP, 0x21, OPCODE_STA_ABS, 0x00, 0xE0, OPCODE_RTI_IMP });
+    cpu.registers.pc = 0x0000;
+
+    // the counter is reloaded with 19 on the first scanline and reaches 0 on the 20th
+    cpu.memory.write_byte(0xC000, 19);
+    cpu.memory.write_byte(0xC001, 0);
+    cpu.memory.write_byte(0xE001, 0);
+    cpu.memory.write_byte(0x2001, 0x18);
+
+    cpu.run_until((19 * 341 + 200) / 3);
+    REQUIRE(cpu.memory.read_byte(0x21) == 0);
+    cpu.run_until((21 * 341) / 3);
+    REQUIRE(cpu.memory.read_byte(0x21) == 1);
+    cpu.run_frame();
+    REQUIRE(cpu.memory.read_byte(0x21) == 1);
+}
+
+// blargg's test ROMs write their result to $6000 once the signature at $6001 is there
+TEST_CASE("ppu_vbl_nmi", "[ppu],[interrupt]")
+{
+    const std::filesystem::path rom_path =
+        std::filesystem::path(NES_ROM_DIR) / "nes-test-roms/ppu_vbl_nmi/rom_singles/01-vbl_basics.nes";
+    if (!std::filesystem::exists(rom_path)) {
+        WARN("ppu_vbl_nmi not found in " NES_ROM_DIR ", skipping");
+        return;
+    }
+
+    std::optional<Cartridge> cart = Cartridge::from_file(rom_path.c_str());
+    REQUIRE(cart.has_value());
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*cart))));
+    cpu.reset();
+
+    const auto running = [&] {
+        const bool signature = cpu.memory.read_byte(0x6001) == 0xDE && cpu.memory.read_byte(0x6002) == 0xB0 &&
+                               cpu.memory.read_byte(0x6003) == 0x61;
+        return !signature || cpu.memory.read_byte(0x6000) >= 0x80;
+    };
+    for (int frame = 0; frame < 60 * 30 && running(); ++frame) {
+        cpu.run_frame();
+    }
+    REQUIRE(cpu.memory.read_byte(0x6000) == 0);
+}
+
+TEST_CASE("8x16 and flipped sprites", "[ppu]")
+{
+    CPU6502 cpu;
+    set_up_scene(cpu);
+    // tile 2 is colour 1 on its left half, tile 3 is empty
+    write_vram(cpu, 0x0020, { 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0 });
+    cpu.memory.write_byte(0x2000, 0x20);
+
+    SECTION("unflipped")
+    {
+        write_sprite(cpu, 5, { 49, 2, 0x00, 40 });
+        render(cpu);
+        REQUIRE(pixel(cpu, 40, 50) == red);
+        REQUIRE(pixel(cpu, 43, 57) == red);
+        REQUIRE(pixel(cpu, 44, 50) == black);
+        REQUIRE(pixel(cpu, 40, 58) == black);
+    }
+
+    SECTION("flipped both ways")
+    {
+        write_sprite(cpu, 5, { 49, 2, 0xC0, 40 });
+        render(cpu);
+        REQUIRE(pixel(cpu, 40, 50) == black);
+        REQUIRE(pixel(cpu, 44, 58) == red);
+        REQUIRE(pixel(cpu, 47, 65) == red);
+        REQUIRE(pixel(cpu, 43, 58) == black);
+    }
+
+    SECTION("lower numbered sprites go on top")
+    {
+        write_vram(cpu, 0x3F15, { 0x30 });
+        write_sprite(cpu, 5, { 49, 2, 0x01, 40 });
+        write_sprite(cpu, 6, { 49, 2, 0x00, 38 });
+        render(cpu);
+        REQUIRE(pixel(cpu, 38, 50) == red);
+        REQUIRE(pixel(cpu, 40, 50) == white);
+        REQUIRE(pixel(cpu, 42, 50) == white);
+    }
+}
+
+TEST_CASE("OAM DMA", "[ppu]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(make_chr_ram_cartridge(0, 1)));
+    for (uint16_t i = 0; i < 0x100; ++i) {
+        cpu.memory.write_byte(0x0200 + i, (uint8_t)i);
+    }
+    // LDA #$02; STA $4014
+    write_program(cpu, 0x0000, { OPCODE_LDA_IMM, 0x02, OPCODE_STA_ABS, 0x14, 0x40 });
+    cpu.registers.pc = 0x0000;
+    cpu.memory.write_byte(0x2003, 0x10);
+
+    cpu.run_for_cycles(2 + 4);
+    REQUIRE(cpu.cycle_count == 2 + 4 + 513);
+
+    // the copy starts at OAMADDR and wraps, the attribute bits that don't exist read as 0
+    cpu.memory.write_byte(0x2003, 0x10);
+    REQUIRE(cpu.memory.read_byte(0x2004) == 0x00);
+    cpu.memory.write_byte(0x2003, 0x0F);
+    REQUIRE(cpu.memory.read_byte(0x2004) == 0xFF);
+    cpu.memory.write_byte(0x2003, 0x12);
+    REQUIRE(cpu.memory.read_byte(0x2004) == (0x02 & 0xE3));
+    cpu.memory.write_byte(0x2003, 0x1E);
+    REQUIRE(cpu.memory.read_byte(0x2004) == (0x0E & 0xE3));
+
+    // the rest of the page is still plain registers
+    cpu.memory.write_byte(0x4015, 0x0F);
+    REQUIRE(cpu.memory.read_byte(0x4015) == 0x0F);
+}
@@ -0,0 +1,188 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "opcodes.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+static void write_program(CPU6502& cpu, uint16_t addr, std::initializer_list<uint8_t> program)
+{
+    for (uint8_t byte : program) {
+        cpu.memory.write_byte(addr++, byte);
+    }
+}
+
+TEST_CASE("profiler counts instructions by opcode and address", "[cpu],[profiler]")
+{
+    // LDX #$05; DEX; BNE $0002; JMP $0000
+    CPU6502 profiled;
+    CPU6502 unprofiled;
+    for (CPU6502* cpu : { &profiled, &unprofiled }) {
+        write_program(*cpu,
+                      0x0000,
+                      { OPCODE_LDX_IMM, 0x05, OPCODE_DEX_IMP, OPCODE_BNE_REL, 0xFD, OPCODE_JMP_ABS, 0x00, 0x00 });
+    }
+    auto profiler     = std::make_unique<Profiler>();
+    profiled.profiler = profiler.get();
+
+    // LDX (2) + 4 * (DEX (2) + BNE taken (3)) + DEX (2) + BNE (2) + JMP (3) is one time round
+    profiled.run_until(29);
+    unprofiled.run_until(29);
+    REQUIRE(profiled.cycle_count == unprofiled.cycle_count);
+    REQUIRE(profiled.registers.pc == unprofiled.registers.pc);
+    REQUIRE(profiled.registers.x == unprofiled.registers.x);
+
+    REQUIRE(profiler->total().executions == 12);
+    REQUIRE(profiler->total().cycles == 29);
+    REQUIRE(profiler->location(0x0002).counts.executions == 5);
+    REQUIRE(profiler->location(0x0002).counts.cycles == 10);
+    REQUIRE(profiler->location(0x0003).counts.executions == 5);
+    REQUIRE(profiler->location(0x0003).counts.cycles == 14);
+    REQUIRE(profiler->location(0x0003).operand == 0xFD);
+    REQUIRE(profiler->location(0x0003).prg_bank == Profiler::not_prg);
+    REQUIRE(profiler->location(0x0005).counts.cycles == 3);
+    REQUIRE(profiler->location(0x0004).counts.executions == 0);
+    REQUIRE(profiler->opcode_counts(OPCODE_BNE_REL).cycles == 14);
+    REQUIRE(profiler->opcode_counts(OPCODE_LDX_IMM).executions == 1);
+
+    profiler->clear();
+    REQUIRE(profiler->total().executions == 0);
+    REQUIRE(profiler->location(0x0002).counts.executions == 0);
+}
+
+TEST_CASE("disassembly", "[profiler]")
+{
+    REQUIRE(disassemble(0x8000, OPCODE_LDA_ABSX, 0x0300) == "LDA $0300,X");
+    REQUIRE(disassemble(0x8000, OPCODE_STA_INDY, 0x10) == "STA ($10),Y");
+    REQUIRE(disassemble(0x8000, OPCODE_CMP_IMM, 0x40) == "CMP #$40");
+    REQUIRE(disassemble(0x8000, OPCODE_ASL_ACC, 0) == "ASL A");
+    REQUIRE(disassemble(0x8000, OPCODE_JMP_IND, 0x0200) == "JMP ($0200)");
+    REQUIRE(disassemble(0x8010, OPCODE_BNE_REL, 0xFC) == "BNE $800E");
+    REQUIRE(disassemble(0x8000, OPCODE_INX_IMP, 0) == "INX");
+}
+
+// UxROM where 16KiB bank n starts LDX #n; RTS and the fixed bank at $C000 calls bank 1 and then bank 2 at the same
+// address: LDA #$01; STA $C100; JSR $8000; LDA #$02; STA $C100; JSR $8000; JMP $C000
+static std::shared_ptr<const Cartridge> make_banked_cartridge()
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, 4, 0 };
+    image.resize(16);
+    image[6] = 2 << 4;
+    for (uint8_t bank = 0; bank < 4; ++bank) {
+        const size_t start = image.size();
+        image.resize(start + 0x4000);
+        image[start]     = OPCODE_LDX_IMM;
+        image[start + 1] = bank;
+        image[start + 2] = OPCODE_RTS_IMP;
+    }
+
+    constexpr std::array<uint8_t, 19> fixed_bank = { OPCODE_LDA_IMM, 0x01, OPCODE_STA_ABS, 0x00, 0xC1, //
+                                                     OPCODE_JSR_ABS, 0x00, 0x80,                        //
+                                                     OPCODE_LDA_IMM, 0x02, OPCODE_STA_ABS, 0x00, 0xC1, //
+                                                     OPCODE_JSR_ABS, 0x00, 0x80,                        //
+                                                     OPCODE_JMP_ABS, 0x00, 0xC0 };
+    std::copy(fixed_bank.begin(), fixed_bank.end(), image.begin() + 16 + 3 * 0x4000);
+
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    return std::make_shared<const Cartridge>(std::move(*cart));
+}
+
+TEST_CASE("profiler counts the same pc in different banks apart", "[cpu],[profiler]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(make_banked_cartridge()));
+    cpu.registers.pc = 0xC000;
+    cpu.registers.s  = 0xFD;
+    auto profiler    = std::make_unique<Profiler>();
+    cpu.profiler     = profiler.get();
+
+    cpu.run_until(1000);
+    // 16KiB bank n is 8KiB banks 2n and 2n + 1
+    const Profiler::Location& bank_1 = profiler->location(0x8000, 2);
+    const Profiler::Location& bank_2 = profiler->location(0x8000, 4);
+    REQUIRE(bank_1.opcode == OPCODE_LDX_IMM);
+    REQUIRE(bank_1.operand == 0x01);
+    REQUIRE(bank_2.operand == 0x02);
+    REQUIRE(bank_1.counts.executions > 0);
+    REQUIRE(bank_2.counts.executions >= bank_1.counts.executions - 1);
+    REQUIRE(bank_2.counts.executions <= bank_1.counts.executions);
+    REQUIRE(profiler->location(0x8000, 0).counts.executions == 0);
+    REQUIRE(profiler->location(0x8000).counts.executions == 0);
+    REQUIRE(profiler->location(0xC005, 6).prg_bank == 6);
+
+    const std::string report = profiler->report(12);
+    REQUIRE(report.find("8000    02  LDX #$01") != std::string::npos);
+    REQUIRE(report.find("8000    04  LDX #$02") != std::string::npos);
+    REQUIRE(report.find("C005    06  JSR $8000") != std::string::npos);
+    REQUIRE(report.find("RTS") != std::string::npos);
+    // nothing that didn't run
+    REQUIRE(report.find("BRK") == std::string::npos);
+}
+
+TEST_CASE("profiling through the block cache counts the same as stepping", "[cpu],[profiler]")
+{
+    // LDX #$05; DEX; BNE $0002; CLC; ADC #$01; STA $10; JMP $0000, with the fused pairs and the DEX; BNE that isn't
+    // an idle loop as it counts down, then the same from the banked cartridge
+    CPU6502 blocks;
+    CPU6502 stepping;
+    stepping.use_block_cache = false;
+    auto block_profiler      = std::make_unique<Profiler>();
+    auto stepping_profiler   = std::make_unique<Profiler>();
+    blocks.profiler          = block_profiler.get();
+    stepping.profiler        = stepping_profiler.get();
+
+    const auto require_same_counts = [&](std::initializer_list<std::pair<uint16_t, int16_t>> locations) {
+        REQUIRE(blocks.cycle_count == stepping.cycle_count);
+        REQUIRE(blocks.registers.pc == stepping.registers.pc);
+        REQUIRE(block_profiler->total().executions == stepping_profiler->total().executions);
+        REQUIRE(block_profiler->total().cycles == stepping_profiler->total().cycles);
+        for (const auto& [pc, bank] : locations) {
+            const Profiler::Location& block_location    = block_profiler->location(pc, bank);
+            const Profiler::Location& stepping_location = stepping_profiler->location(pc, bank);
+            REQUIRE(block_location.counts.executions == stepping_location.counts.executions);
+            REQUIRE(block_location.counts.cycles == stepping_location.counts.cycles);
+            REQUIRE(block_location.operand == stepping_location.operand);
+            REQUIRE(block_location.opcode == stepping_location.opcode);
+        }
+    };
+
+    for (CPU6502* cpu : { &blocks, &stepping }) {
+        write_program(*cpu,
+                      0x0000,
+                      { OPCODE_LDX_IMM, 0x05, OPCODE_DEX_IMP, OPCODE_BNE_REL, 0xFD, //
+                        OPCODE_CLC_IMP, OPCODE_ADC_IMM, 0x01, OPCODE_STA_ZP, 0x10, //
+                        OPCODE_JMP_ABS, 0x00, 0x00 });
+    }
+    for (uint64_t target = 7; target < 5000; target += 97) {
+        blocks.run_until(target);
+        stepping.run_until(target);
+        require_same_counts({ { 0x0000, Profiler::not_prg },
+                              { 0x0002, Profiler::not_prg },
+                              { 0x0003, Profiler::not_prg },
+                              { 0x0005, Profiler::not_prg },
+                              { 0x0006, Profiler::not_prg },
+                              { 0x000A, Profiler::not_prg } });
+    }
+
+    for (CPU6502* cpu : { &blocks, &stepping }) {
+        REQUIRE(cpu->load_cartridge(make_banked_cartridge()));
+        cpu->registers.pc = 0xC000;
+        cpu->registers.s  = 0xFD;
+    }
+    block_profiler->clear();
+    stepping_profiler->clear();
+    for (uint64_t target = blocks.cycle_count + 7; target < 10000; target += 97) {
+        blocks.run_until(target);
+        stepping.run_until(target);
+        require_same_counts({ { 0x8000, 2 }, { 0x8002, 4 }, { 0xC005, 6 }, { 0xC010, 6 } });
+    }
+}
@@ -0,0 +1,220 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "opcodes.h"
+#include "trace_compare.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// A loop touching every instruction and addressing mode the recompiler translates itself, plus a few it hands back
+// to the interpreter
+// clang-format off
+static constexpr std::array<uint8_t, 0x54> mixed_program = {
+    OPCODE_LDX_IMM,  0x00,       // $8000 LDX #$00
+    OPCODE_LDY_IMM,  0x10,       // $8002 LDY #$10
+    OPCODE_LDA_ABSX, 0x00, 0x03, // $8004 LDA $0300,X
+    OPCODE_ADC_IMM,  0x37,       // $8007 ADC #$37
+    OPCODE_STA_ABSX, 0x00, 0x03, // $8009 STA $0300,X
+    OPCODE_SBC_ZP,   0x10,       // $800C SBC $10
+    OPCODE_EOR_IMM,  0xA5,       // $800E EOR #$A5
+    OPCODE_AND_ABSY, 0x00, 0x04, // $8010 AND $0400,Y
+    OPCODE_STA_ZP,   0x10,       // $8013 STA $10
+    OPCODE_LDA_ABSY, 0xF0, 0x03, // $8015 LDA $03F0,Y
+    OPCODE_ORA_IMM,  0x01,       // $8018 ORA #$01
+    OPCODE_STA_ZPX,  0x20,       // $801A STA $20,X
+    OPCODE_INC_ZP,   0x21,       // $801C INC $21
+    OPCODE_DEC_ABS,  0x00, 0x05, // $801E DEC $0500
+    OPCODE_CMP_ZP,   0x22,       // $8021 CMP $22
+    OPCODE_BVS_REL,  0x01,       // $8023 BVS $8026
+    OPCODE_ASL_ACC,              // $8025 ASL A
+    OPCODE_PHA_IMP,              // $8026 PHA
+    OPCODE_PLA_IMP,              // $8027 PLA
+    OPCODE_BMI_REL,  0x01,       // $8028 BMI $802B
+    OPCODE_INX_IMP,              // $802A INX
+    OPCODE_CLV_IMP,              // $802B CLV
+    OPCODE_SEC_IMP,              // $802C SEC
+    OPCODE_TXA_IMP,              // $802D TXA
+    OPCODE_TAY_IMP,              // $802E TAY
+    OPCODE_INY_IMP,              // $802F INY
+    OPCODE_STX_ZPY,  0x30,       // $8030 STX $30,Y
+    OPCODE_LDX_ZPY,  0x30,       // $8032 LDX $30,Y
+    OPCODE_CPX_IMM,  0xF0,       // $8034 CPX #$F0
+    OPCODE_CPY_ZP,   0x22,       // $8036 CPY $22
+    OPCODE_INX_IMP,              // $8038 INX
+    OPCODE_BNE_REL,  0xC9,       // $8039 BNE $8004
+    OPCODE_JSR_ABS,  0x50, 0x80, // $803B JSR $8050
+    OPCODE_CLC_IMP,              // $803E CLC
+    OPCODE_BCC_REL,  0x02,       // $803F BCC $8043
+    0x00, 0x00,
+    OPCODE_JMP_ABS,  0x00, 0x80, // $8043 JMP $8000
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    OPCODE_INY_IMP,              // $8050 INY
+    OPCODE_DEY_IMP,              // $8051 DEY
+    OPCODE_DEX_IMP,              // $8052 DEX
+    OPCODE_RTS_IMP,              // $8053 RTS
+};
+// clang-format on
+
+static void require_same_state(const CPU6502& translated, const CPU6502& interpreted)
+{
+    REQUIRE(translated.cycle_count == interpreted.cycle_count);
+    REQUIRE(translated.registers.pc == interpreted.registers.pc);
+    REQUIRE(translated.registers.a == interpreted.registers.a);
+    REQUIRE(translated.registers.x == interpreted.registers.x);
+    REQUIRE(translated.registers.y == interpreted.registers.y);
+    REQUIRE(translated.registers.s == interpreted.registers.s);
+    REQUIRE(translated.registers.p == interpreted.registers.p);
+    for (uint16_t addr = 0; addr < 0x800; ++addr) {
+        if (translated.memory.peek_byte(addr) != interpreted.memory.peek_byte(addr)) {
+            FAIL("RAM differs at " << addr);
+        }
+    }
+}
+
+TEST_CASE("recompiled code matches the interpreter", "[cpu],[recompiler]")
+{
+    CPU6502 translated;
+    CPU6502 interpreted;
+    translated.use_recompiler = true;
+    translated.memory.write_rom(0x8000, mixed_program);
+    interpreted.memory.write_rom(0x8000, mixed_program);
+    translated.registers.pc = interpreted.registers.pc = 0x8000;
+
+    translated.run_until(1);
+    if (!translated.recompiler) {
+        WARN("the recompiler isn't supported on this platform, skipping");
+        return;
+    }
+    interpreted.run_until(1);
+
+    // odd sized steps so runs end part way through blocks as well as on their boundaries
+    for (uint64_t target = 1; target < 200000; target += 997) {
+        translated.run_until(target);
+        interpreted.run_until(target);
+        require_same_state(translated, interpreted);
+    }
+}
+
+TEST_CASE("recompiled code sees code being written", "[cpu],[recompiler]")
+{
+    // loop: LDA #n; STA $0200; INC $0801; JMP loop with the INC rewriting the LDA through a mirror
+    const std::array<uint8_t, 11> program = {
+        OPCODE_LDA_IMM, 0x01, OPCODE_STA_ABS, 0x00, 0x02, OPCODE_INC_ABS, 0x01, 0x08, OPCODE_JMP_ABS, 0x00, 0x00
+    };
+
+    CPU6502 translated;
+    CPU6502 interpreted;
+    translated.use_recompiler = true;
+    for (uint16_t i = 0; i < program.size(); ++i) {
+        translated.memory.write_byte(i, program[i]);
+        interpreted.memory.write_byte(i, program[i]);
+    }
+
+    translated.run_until(20000);
+    interpreted.run_until(20000);
+    require_same_state(translated, interpreted);
+}
+
+// UxROM where 16KiB bank n starts LDX #n; RTS and the fixed bank at $C000 cycles through the first four:
+// loop: JSR $8000; TXA; STA $0200,Y; INY; TYA; AND #$03; STA $C100; JMP loop
+static std::shared_ptr<const Cartridge> make_bank_cycling_cartridge()
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, 8, 0 };
+    image.resize(16);
+    image[6] = 2 << 4;
+    for (uint8_t bank = 0; bank < 8; ++bank) {
+        const size_t start = image.size();
+        image.resize(start + 0x4000);
+        image[start]     = OPCODE_LDX_IMM;
+        image[start + 1] = bank;
+        image[start + 2] = OPCODE_RTS_IMP;
+    }
+
+    constexpr std::array<uint8_t, 17> fixed_bank = { OPCODE_JSR_ABS,  0x00, 0x80, OPCODE_TXA_IMP, //
+                                                     OPCODE_STA_ABSY, 0x00, 0x02, OPCODE_INY_IMP, //
+                                                     OPCODE_TYA_IMP,  OPCODE_AND_IMM, 0x03,       //
+                                                     OPCODE_STA_ABS,  0x00, 0xC1,                 //
+                                                     OPCODE_JMP_ABS,  0x00, 0xC0 };
+    std::copy(fixed_bank.begin(), fixed_bank.end(), image.begin() + 16 + 7 * 0x4000);
+
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    return std::make_shared<const Cartridge>(std::move(*cart));
+}
+
+TEST_CASE("recompiled code follows bank switches", "[cpu],[recompiler]")
+{
+    const auto cart = make_bank_cycling_cartridge();
+    CPU6502 translated;
+    CPU6502 interpreted;
+    translated.use_recompiler = true;
+    REQUIRE(translated.load_cartridge(cart));
+    REQUIRE(interpreted.load_cartridge(cart));
+    translated.registers.pc = interpreted.registers.pc = 0xC000;
+    translated.registers.s  = interpreted.registers.s  = 0xFD;
+
+    translated.run_until(50000);
+    interpreted.run_until(50000);
+    require_same_state(translated, interpreted);
+    REQUIRE(translated.memory.read_byte(0x0201) == 1);
+    REQUIRE(translated.memory.read_byte(0x0203) == 3);
+}
+
+TEST_CASE("recompiled nestest", "[cpu],[recompiler],[nestest]")
+{
+    const std::filesystem::path rom_path = std::filesystem::path(NES_ROM_DIR) / "nes-test-roms/other/nestest.nes";
+    const std::filesystem::path log_path = std::filesystem::path(NES_ROM_DIR) / "nes-test-roms/other/nestest.log";
+    if (!std::filesystem::exists(rom_path) || !std::filesystem::exists(log_path)) {
+        WARN("nestest not found in " NES_ROM_DIR ", skipping");
+        return;
+    }
+
+    std::optional<Cartridge> cart = Cartridge::from_file(rom_path.c_str());
+    REQUIRE(cart.has_value());
+    const std::optional<std::vector<TraceRecord>> log = load_nestest_log(log_path.c_str());
+    REQUIRE(log.has_value());
+    const std::span<const TraceRecord> reference = official_opcode_prefix(*log);
+
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*cart))));
+    cpu.reset();
+    cpu.registers.pc   = reference.front().pc;
+    cpu.use_recompiler = true;
+
+    const std::optional<TraceMismatch> mismatch = compare_trace_sampled(cpu, reference, 64);
+    if (mismatch.has_value()) {
+        FAIL(format_trace_mismatch(*mismatch));
+    }
+}
+
+TEST_CASE("recompiled code skips idle loops", "[cpu],[recompiler]")
+{
+    // LDX #$00; INX; BNE $0002; LDA $4015; BPL $0005 so the idle loop is only reached after the counting one is hot
+    const std::array<uint8_t, 10> program = { OPCODE_LDX_IMM, 0x00,                  //
+                                              OPCODE_INX_IMP, OPCODE_BNE_REL, 0xFD,  //
+                                              OPCODE_LDA_ABS, 0x15, 0x40,            //
+                                              OPCODE_BPL_REL, 0xFB };
+
+    CPU6502 translated;
+    CPU6502 interpreted;
+    translated.use_recompiler   = true;
+    interpreted.skip_idle_loops = false;
+    for (uint16_t i = 0; i < program.size(); ++i) {
+        translated.memory.write_byte(i, program[i]);
+        interpreted.memory.write_byte(i, program[i]);
+    }
+
+    for (uint64_t target = 1; target < 100000; target += 997) {
+        translated.run_until(target);
+        interpreted.run_until(target);
+        require_same_state(translated, interpreted);
+    }
+    REQUIRE(translated.idle_cycles_skipped > 0);
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cpu.h"
+#include "opcodes.h"
+#include "scheduler.h"
+
+#include <cstdint>
+#include <vector>
+
+// Records when it ran, and reschedules itself every period cycles when period isn't 0
+struct RecordingHandler : EventHandler
+{
+    RecordingHandler(Scheduler& events, std::vector<int>& run_log, int handler_id, uint64_t repeat_every = 0)
+        : scheduler(events), log(run_log), id(handler_id), period(repeat_every)
+    {
+    }
+
+    void run_event(uint64_t cycle) override
+    {
+        log.push_back(id);
+        ran_at.push_back(scheduler.now());
+        if (period) scheduler.schedule(this, cycle + period);
+    }
+
+    Scheduler& scheduler;
+    std::vector<int>& log;
+    int id;
+    uint64_t period;
+    std::vector<uint64_t> ran_at;
+};
+
+TEST_CASE("scheduler runs events in order", "[scheduler]")
+{
+    uint64_t cycle_count = 0;
+    uint64_t stop_cycle  = 1000;
+    Scheduler scheduler(cycle_count, stop_cycle);
+    std::vector<int> log;
+    RecordingHandler first(scheduler, log, 1);
+    RecordingHandler second(scheduler, log, 2);
+    RecordingHandler third(scheduler, log, 3);
+
+    scheduler.schedule(&third, 30);
+    scheduler.schedule(&first, 10);
+    scheduler.schedule(&second, 10);
+    REQUIRE(scheduler.next_event_cycle() == 10);
+    REQUIRE(stop_cycle == 10);
+
+    cycle_count = 9;
+    scheduler.run_due_events();
+    REQUIRE(log.empty());
+
+    cycle_count = 10;
+    scheduler.run_due_events();
+    REQUIRE(log == std::vector<int>{ 1, 2 });
+    REQUIRE(scheduler.next_event_cycle() == 30);
+
+    SECTION("rescheduling replaces the event")
+    {
+        scheduler.schedule(&third, 50);
+        cycle_count = 40;
+        scheduler.run_due_events();
+        REQUIRE(log.size() == 2);
+        cycle_count = 50;
+        scheduler.run_due_events();
+        REQUIRE(log == std::vector<int>{ 1, 2, 3 });
+    }
+
+    SECTION("cancelling")
+    {
+        REQUIRE(scheduler.scheduled(&third));
+        scheduler.cancel(&third);
+        REQUIRE_FALSE(scheduler.scheduled(&third));
+        REQUIRE(scheduler.next_event_cycle() == Scheduler::no_event);
+        cycle_count = 100;
+        scheduler.run_due_events();
+        REQUIRE(log.size() == 2);
+    }
+}
+
+TEST_CASE("the CPU stops for events", "[scheduler],[cpu]")
+{
+    CPU6502 cpu;
+    std::vector<int> log;
+    RecordingHandler handler(cpu.scheduler, log, 1, 100);
+
+    SECTION("running NOPs")
+    {
+        // NOP (2 cycles) over and over, so events land part way through an instruction every other time
+        for (uint16_t addr = 0; addr < 0x800; ++addr) {
+            cpu.memory.write_byte(addr, OPCODE_NOP_IMP);
+        }
+        cpu.scheduler.schedule(&handler, 101);
+        cpu.run_until(1000);
+        REQUIRE(handler.ran_at == std::vector<uint64_t>{ 102, 202, 302, 402, 502, 602, 702, 802, 902 });
+        REQUIRE(cpu.cycle_count == 1000);
+    }
+
+    SECTION("in an idle loop")
+    {
+        // JMP $0000 (3 cycles), which is skipped through up to each event
+        CPU6502 stepping;
+        stepping.skip_idle_loops = false;
+        RecordingHandler stepping_handler(stepping.scheduler, log, 2, 341);
+        handler.period = 341;
+        for (CPU6502* c : { &cpu, &stepping }) {
+            c->memory.write_byte(0, OPCODE_JMP_ABS);
+            c->memory.write_byte(1, 0x00);
+            c->memory.write_byte(2, 0x00);
+        }
+        cpu.scheduler.schedule(&handler, 341);
+        stepping.scheduler.schedule(&stepping_handler, 341);
+
+        cpu.run_until(100000);
+        stepping.run_until(100000);
+        REQUIRE(handler.ran_at == stepping_handler.ran_at);
+        REQUIRE(handler.ran_at.size() == 100000 / 341);
+        REQUIRE(cpu.cycle_count == stepping.cycle_count);
+        REQUIRE(cpu.idle_cycles_skipped > 90000);
+    }
+}
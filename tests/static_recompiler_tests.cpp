@@ -0,0 +1,125 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "static_recompiler.h"
+#include "static_test_rom.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+// static_test_program.cpp is generated from static_test_rom() when the tests are built
+static std::shared_ptr<const Cartridge> static_test_cartridge()
+{
+    std::optional<Cartridge> cart = Cartridge::from_memory(static_test_rom());
+    REQUIRE(cart.has_value());
+    return std::make_shared<const Cartridge>(std::move(*cart));
+}
+
+TEST_CASE("static programs are found for their rom", "[static_recompiler]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(static_test_cartridge()));
+    REQUIRE(cpu.static_program != nullptr);
+    REQUIRE(std::string(cpu.static_program->name) == "static_test");
+
+    std::vector<uint8_t> other = static_test_rom();
+    other[16] ^= 1;
+    std::optional<Cartridge> other_cart = Cartridge::from_memory(other);
+    REQUIRE(other_cart.has_value());
+    REQUIRE(cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*other_cart))));
+    REQUIRE(cpu.static_program == nullptr);
+}
+
+TEST_CASE("static recompilation only follows code it can see", "[static_recompiler]")
+{
+    const std::optional<std::string> source = recompile_nrom(*static_test_cartridge(), "test");
+    REQUIRE(source.has_value());
+
+    // the vectors, a subroutine and a branch target
+    REQUIRE(source->find("case 0xC000:") != std::string::npos);
+    REQUIRE(source->find("case 0xC060:") != std::string::npos);
+    REQUIRE(source->find("case 0xC080:") != std::string::npos);
+    REQUIRE(source->find("case 0xC120:") != std::string::npos);
+    REQUIRE(source->find("case 0xC11D:") != std::string::npos);
+    // only reached through JMP ($0020)
+    REQUIRE(source->find("case 0xC034:") == std::string::npos);
+}
+
+TEST_CASE("static recompilation needs NROM", "[static_recompiler]")
+{
+    std::vector<uint8_t> image = static_test_rom();
+    image[6]                   = 2 << 4;
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    REQUIRE_FALSE(recompile_nrom(*cart, "test").has_value());
+}
+
+TEST_CASE("static recompiled code matches the interpreter", "[static_recompiler]")
+{
+    const auto cart                     = static_test_cartridge();
+    const StaticProgram* program = find_static_program(cart->get_program_data());
+    REQUIRE(program != nullptr);
+
+    const std::optional<std::string> difference = verify_static_program(cart, *program, 60000);
+    if (difference.has_value()) {
+        FAIL(*difference);
+    }
+}
+
+// An NMI every period cycles, like the PPU at the start of vblank
+struct VblankNmi : EventHandler
+{
+    VblankNmi(CPU6502& nmi_cpu, uint64_t nmi_period) : cpu(nmi_cpu), period(nmi_period)
+    {
+        cpu.scheduler.schedule(this, period);
+    }
+
+    void run_event(uint64_t cycle) override
+    {
+        cpu.trigger_nmi();
+        cpu.scheduler.schedule(this, cycle + period);
+    }
+
+    CPU6502& cpu;
+    uint64_t period;
+};
+
+TEST_CASE("static recompiled code takes interrupts", "[static_recompiler],[interrupts]")
+{
+    const auto cart = static_test_cartridge();
+    CPU6502 recompiled;
+    CPU6502 interpreted;
+    REQUIRE(recompiled.load_cartridge(cart));
+    REQUIRE(interpreted.load_cartridge(cart));
+    REQUIRE(recompiled.static_program != nullptr);
+    interpreted.use_static_program = false;
+    recompiled.reset();
+    interpreted.reset();
+    VblankNmi recompiled_nmi(recompiled, 1789);
+    VblankNmi interpreted_nmi(interpreted, 1789);
+
+    for (uint64_t target = 1; target < 300000; target += 997) {
+        recompiled.run_until(target);
+        interpreted.run_until(target);
+        REQUIRE(recompiled.cycle_count == interpreted.cycle_count);
+        REQUIRE(recompiled.registers.pc == interpreted.registers.pc);
+        REQUIRE(recompiled.registers.a == interpreted.registers.a);
+        REQUIRE(recompiled.registers.x == interpreted.registers.x);
+        REQUIRE(recompiled.registers.y == interpreted.registers.y);
+        REQUIRE(recompiled.registers.s == interpreted.registers.s);
+        REQUIRE(recompiled.registers.p == interpreted.registers.p);
+        for (uint16_t addr = 0; addr < 0x800; ++addr) {
+            if (recompiled.memory.peek_byte(addr) != interpreted.memory.peek_byte(addr)) {
+                FAIL("RAM differs at " << addr);
+            }
+        }
+    }
+
+    // every path through the main loop was taken, and the NMI handler ran
+    for (uint16_t counter : { 0x11, 0x12, 0x50, 0x51, 0x52 }) {
+        REQUIRE(recompiled.memory.peek_byte(counter) != 0);
+    }
+}
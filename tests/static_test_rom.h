@@ -0,0 +1,116 @@
+#pragma once
+
+#include "opcodes.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+// An NROM-128 image that nes-static-recompile turns into a StaticProgram at build time for the tests to check against
+// the interpreter. The main loop jumps indirectly to code the recompiler can't find (so the interpreter runs it), one
+// piece of which calls a routine copied into RAM, another BRKs and another returns through an address it pushed.
+inline std::vector<uint8_t> static_test_rom()
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, 1, 0 };
+    image.resize(16 + 0x4000);
+    const auto place = [&](uint16_t addr, std::initializer_list<uint8_t> bytes) {
+        std::copy(bytes.begin(), bytes.end(), image.begin() + 16 + (addr - 0xC000));
+    };
+
+    // clang-format off
+    place(0xC000, { OPCODE_LDX_IMM,  0xFF,       // reset: LDX #$FF
+                    OPCODE_TXS_IMP,              //        TXS
+                    OPCODE_LDX_IMM,  0x00,       //        LDX #$00
+                    OPCODE_LDA_ABSX, 0x80, 0xC1, // $C005: LDA $C180,X
+                    OPCODE_STA_ABSX, 0x00, 0x03, //        STA $0300,X
+                    OPCODE_INX_IMP,              //        INX
+                    OPCODE_CPX_IMM,  0x08,       //        CPX #$08
+                    OPCODE_BNE_REL,  0xF5,       //        BNE $C005
+                    OPCODE_LDA_IMM,  0xF8,       //        LDA #$F8
+                    OPCODE_STA_ZP,   0x30,       //        STA $30
+                    OPCODE_LDA_IMM,  0x02,       //        LDA #$02
+                    OPCODE_STA_ZP,   0x31,       //        STA $31
+                    OPCODE_CLI_IMP,              //        CLI
+                    OPCODE_JSR_ABS,  0x00, 0xC1, // $C019: JSR $C100
+                    OPCODE_JSR_ABS,  0x20, 0xC1, //        JSR $C120
+                    OPCODE_INC_ZP,   0x10,       //        INC $10
+                    OPCODE_LDA_ZP,   0x10,       //        LDA $10
+                    OPCODE_AND_IMM,  0x03,       //        AND #$03
+                    OPCODE_ASL_ACC,              //        ASL A
+                    OPCODE_TAX_IMP,              //        TAX
+                    OPCODE_LDA_ABSX, 0x90, 0xC1, //        LDA $C190,X
+                    OPCODE_STA_ZP,   0x20,       //        STA $20
+                    OPCODE_LDA_ABSX, 0x91, 0xC1, //        LDA $C191,X
+                    OPCODE_STA_ZP,   0x21,       //        STA $21
+                    OPCODE_JMP_IND,  0x20, 0x00, //        JMP ($0020)
+                    OPCODE_JSR_ABS,  0x00, 0x03, // $C034: JSR $0300
+                    OPCODE_JMP_ABS,  0x19, 0xC0, //        JMP $C019
+                    OPCODE_BRK_IMP,  0xEA,       // $C03A: BRK
+                    OPCODE_JMP_ABS,  0x19, 0xC0, //        JMP $C019
+                    OPCODE_LDA_IMM,  0xC0,       // $C03F: LDA #$C0
+                    OPCODE_PHA_IMP,              //        PHA
+                    OPCODE_LDA_IMM,  0x47,       //        LDA #$47
+                    OPCODE_PHA_IMP,              //        PHA
+                    OPCODE_RTS_IMP,              //        RTS to $C048
+                    OPCODE_NOP_IMP,              //
+                    OPCODE_NOP_IMP,              //
+                    OPCODE_INC_ZP,   0x11,       // $C048: INC $11
+                    OPCODE_JMP_ABS,  0x19, 0xC0, //        JMP $C019
+                    OPCODE_INC_ZP,   0x12,       // $C04D: INC $12
+                    OPCODE_JMP_ABS,  0x19, 0xC0 });
+
+    // NMI
+    place(0xC060, { OPCODE_PHA_IMP,              // PHA
+                    OPCODE_TXA_IMP,              // TXA
+                    OPCODE_PHA_IMP,              // PHA
+                    OPCODE_INC_ZP,   0x50,       // INC $50
+                    OPCODE_LDX_ZP,   0x50,       // LDX $50
+                    OPCODE_LDA_ABSX, 0x00, 0xC0, // LDA $C000,X
+                    OPCODE_STA_ABSX, 0x00, 0x06, // STA $0600,X
+                    OPCODE_PLA_IMP,              // PLA
+                    OPCODE_TAX_IMP,              // TAX
+                    OPCODE_PLA_IMP,              // PLA
+                    OPCODE_RTI_IMP });           // RTI
+
+    // IRQ and BRK
+    place(0xC080, { OPCODE_INC_ZP, 0x51, OPCODE_RTI_IMP });
+
+    place(0xC100, { OPCODE_LDA_ZP,   0x10,       // LDA $10
+                    OPCODE_CLC_IMP,              // CLC
+                    OPCODE_ADC_IMM,  0x07,       // ADC #$07
+                    OPCODE_STA_ZP,   0x12,       // STA $12
+                    OPCODE_LDX_ZP,   0x12,       // LDX $12
+                    OPCODE_LDA_ZPX,  0x00,       // LDA $00,X
+                    OPCODE_EOR_ZP,   0x12,       // EOR $12
+                    OPCODE_STA_ZPX,  0x40,       // STA $40,X
+                    OPCODE_SEC_IMP,              // SEC
+                    OPCODE_SBC_ZP,   0x13,       // SBC $13
+                    OPCODE_STA_ZP,   0x13,       // STA $13
+                    OPCODE_LSR_ACC,              // LSR A
+                    OPCODE_ROR_ZP,   0x14,       // ROR $14
+                    OPCODE_BIT_ZP,   0x14,       // BIT $14
+                    OPCODE_BMI_REL,  0x02,       // BMI $C11D
+                    OPCODE_DEC_ZP,   0x15,       // DEC $15
+                    OPCODE_RTS_IMP });           // $C11D: RTS
+
+    place(0xC120, { OPCODE_LDY_IMM,  0xF0,       // LDY #$F0
+                    OPCODE_LDA_ABSY, 0x20, 0x02, // $C122: LDA $0220,Y
+                    OPCODE_ADC_ABSY, 0x00, 0x04, //        ADC $0400,Y
+                    OPCODE_STA_ABSY, 0x00, 0x05, //        STA $0500,Y
+                    OPCODE_EOR_INDY, 0x30,       //        EOR ($30),Y
+                    OPCODE_LDA_INDX, 0x40,       //        LDA ($40,X)
+                    OPCODE_INY_IMP,              //        INY
+                    OPCODE_BNE_REL,  0xF0,       //        BNE $C122
+                    OPCODE_RTS_IMP });           //        RTS
+
+    // copied to $0300
+    place(0xC180, { OPCODE_INC_ZP, 0x52, OPCODE_LDA_ZP, 0x52, OPCODE_STA_ABS, 0x01, 0x02, OPCODE_RTS_IMP });
+
+    // where JMP ($0020) goes
+    place(0xC190, { 0x34, 0xC0, 0x3A, 0xC0, 0x3F, 0xC0, 0x4D, 0xC0 });
+
+    place(0xFFFA, { 0x60, 0xC0, 0x00, 0xC0, 0x80, 0xC0 });
+    // clang-format on
+    return image;
+}
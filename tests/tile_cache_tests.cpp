@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "tile_cache.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+TEST_CASE("tiles are decoded a byte per pixel", "[ppu],[tile_cache]")
+{
+    // enough patterns to cover every bit of both planes, leftmost pixel in the lowest byte
+    uint32_t seed = 12345;
+    for (int i = 0; i < 1000; ++i) {
+        std::array<uint8_t, 16> planes;
+        for (uint8_t& byte : planes) {
+            seed = seed * 1103515245 + 12345;
+            byte = (uint8_t)(seed >> 16);
+        }
+
+        std::array<uint64_t, 8> rows;
+        TileCache::decode_tile(planes.data(), rows.data());
+        for (int row = 0; row < 8; ++row) {
+            for (int x = 0; x < 8; ++x) {
+                const int pixel = ((planes[row] >> (7 - x)) & 1) | (((planes[row + 8] >> (7 - x)) & 1) << 1);
+                REQUIRE((int)((rows[row] >> (x * 8)) & 0xFF) == pixel);
+            }
+        }
+    }
+}
+
+// Every byte of 1KiB CHR bank n is n
+static std::shared_ptr<const Cartridge> make_cartridge(uint8_t mapper_number, uint8_t chr_banks_8k)
+{
+    std::vector<uint8_t> image = { 'N', 'E', 'S', 0x1A, 2, chr_banks_8k };
+    image.resize(16);
+    image[6] = (uint8_t)(mapper_number << 4);
+    image.resize(16 + 2 * 0x4000);
+    for (size_t i = 0; i < chr_banks_8k * 8u; ++i) {
+        image.insert(image.end(), 0x400, (uint8_t)i);
+    }
+
+    std::optional<Cartridge> cart = Cartridge::from_memory(image);
+    REQUIRE(cart.has_value());
+    return std::make_shared<const Cartridge>(std::move(*cart));
+}
+
+TEST_CASE("the tile cache follows CHR bank switches", "[mapper],[tile_cache]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(make_cartridge(3, 2)));
+
+    REQUIRE(cpu.mapper->chr_row(0x0000) == 0);
+    REQUIRE(cpu.mapper->chr_row(0x1C05) == 0x0303030000000000);
+
+    // 8KiB bank 1 is 1KiB banks 8 to 15
+    cpu.memory.write_byte(0x8000, 1);
+    REQUIRE(cpu.mapper->chr_row(0x0000) == 0x0000000300000000);
+    REQUIRE(cpu.mapper->chr_row(0x1C05) == 0x0303030300000000);
+}
+
+TEST_CASE("the tile cache follows CHR-RAM writes", "[mapper],[tile_cache]")
+{
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(make_cartridge(0, 0)));
+    REQUIRE(cpu.mapper->chr_row(0x0012) == 0);
+
+    cpu.mapper->chr_write(0x0012, 0x81);
+    cpu.mapper->chr_write(0x001A, 0x01);
+    REQUIRE(cpu.mapper->chr_row(0x0012) == 0x0300000000000001);
+    REQUIRE(cpu.mapper->chr_row(0x0013) == 0);
+    REQUIRE(cpu.mapper->chr_row(0x0022) == 0);
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cartridge.h"
+#include "cpu.h"
+#include "opcodes.h"
+#include "trace_compare.h"
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+TEST_CASE("parse nestest log line", "[trace],[nestest]")
+{
+    SECTION("instruction with operands")
+    {
+        const std::optional<TraceRecord> record = parse_nestest_line(
+            "C5F5  A2 00     LDX #$00                        A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 30 CYC:10");
+        REQUIRE(record.has_value());
+        REQUIRE(record->pc == 0xC5F5);
+        REQUIRE(record->opcode == OPCODE_LDX_IMM);
+        REQUIRE(record->operands[0] == 0x00);
+        REQUIRE(record->p == 0x24);
+        REQUIRE(record->s == 0xFD);
+        REQUIRE(record->cycle == 10);
+    }
+
+    SECTION("implied instruction")
+    {
+        const std::optional<TraceRecord> record = parse_nestest_line(
+            "C72D  EA        NOP                             A:FF X:00 Y:00 P:E5 SP:FB PPU: 14, 47 CYC:1595");
+        REQUIRE(record.has_value());
+        REQUIRE(record->pc == 0xC72D);
+        REQUIRE(record->opcode == OPCODE_NOP_IMP);
+        REQUIRE(record->operands[0] == 0);
+        REQUIRE(record->a == 0xFF);
+        REQUIRE(record->p == 0xE5);
+        REQUIRE(record->s == 0xFB);
+        REQUIRE(record->cycle == 1595);
+    }
+
+    SECTION("garbage")
+    {
+        REQUIRE(!parse_nestest_line("").has_value());
+        REQUIRE(!parse_nestest_line("C72D  EA        NOP").has_value());
+    }
+}
+
+// LDX #$00; loop: INX; TXA; BNE loop; JMP $0000
+static void write_count_loop(CPU6502& cpu)
+{
+    cpu.memory.write_byte(0, OPCODE_LDX_IMM);
+    cpu.memory.write_byte(1, 0x00);
+    cpu.memory.write_byte(2, OPCODE_INX_IMP);
+    cpu.memory.write_byte(3, OPCODE_TXA_IMP);
+    cpu.memory.write_byte(4, OPCODE_BNE_REL);
+    cpu.memory.write_byte(5, 0xFC);
+    cpu.memory.write_byte(6, OPCODE_JMP_ABS);
+    cpu.memory.write_word(7, 0x0000);
+}
+
+TEST_CASE("compare against a reference trace", "[trace],[nestest]")
+{
+    std::vector<TraceRecord> reference;
+    {
+        CPU6502 cpu;
+        write_count_loop(cpu);
+        for (int i = 0; i < 100; ++i) {
+            reference.push_back(cpu.trace_record(cpu.registers.pc));
+            cpu.run_for_cycles(1);
+        }
+    }
+
+    CPU6502 cpu;
+    write_count_loop(cpu);
+
+    SECTION("matching trace")
+    {
+        REQUIRE(!compare_trace(cpu, reference).has_value());
+        REQUIRE(cpu.registers.x == 33);
+    }
+
+    SECTION("stops at the first difference")
+    {
+        reference[40].a ^= 1;
+        reference[60].x ^= 1;
+
+        const std::optional<TraceMismatch> mismatch = compare_trace(cpu, reference, 4);
+        REQUIRE(mismatch.has_value());
+        REQUIRE(mismatch->index == 40);
+        REQUIRE(mismatch->actual.a == (reference[40].a ^ 1));
+        REQUIRE(mismatch->context.size() == 4);
+        REQUIRE(mismatch->context.data() == &reference[36]);
+        REQUIRE(format_trace_mismatch(*mismatch).starts_with("trace diverged at line 41 (a)\n"));
+    }
+
+    SECTION("context is cut short at the start of the trace")
+    {
+        reference[2].cycle++;
+
+        const std::optional<TraceMismatch> mismatch = compare_trace(cpu, reference);
+        REQUIRE(mismatch.has_value());
+        REQUIRE(mismatch->index == 2);
+        REQUIRE(mismatch->context.size() == 2);
+    }
+}
+
+TEST_CASE("nestest", "[trace],[nestest]")
+{
+    const std::filesystem::path rom_path = std::filesystem::path(NES_ROM_DIR) / "nes-test-roms/other/nestest.nes";
+    const std::filesystem::path log_path = std::filesystem::path(NES_ROM_DIR) / "nes-test-roms/other/nestest.log";
+    if (!std::filesystem::exists(rom_path) || !std::filesystem::exists(log_path)) {
+        WARN("nestest not found in " NES_ROM_DIR ", skipping");
+        return;
+    }
+
+    std::optional<Cartridge> cart = Cartridge::from_file(rom_path.c_str());
+    REQUIRE(cart.has_value());
+    const std::optional<std::vector<TraceRecord>> log = load_nestest_log(log_path.c_str());
+    REQUIRE(log.has_value());
+    const std::span<const TraceRecord> reference = official_opcode_prefix(*log);
+    REQUIRE(!reference.empty());
+
+    CPU6502 cpu;
+    REQUIRE(cpu.load_cartridge(std::make_shared<const Cartridge>(std::move(*cart))));
+    cpu.reset();
+    cpu.registers.pc = reference.front().pc;
+
+    const std::optional<TraceMismatch> mismatch = compare_trace(cpu, reference);
+    if (mismatch.has_value()) {
+        FAIL(format_trace_mismatch(*mismatch));
+    }
+}
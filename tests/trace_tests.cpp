@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "cpu.h"
+#include "opcodes.h"
+#include "trace.h"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+TEST_CASE("trace record text format", "[trace]")
+{
+    TraceRecord record = {};
+    record.cycle       = 7;
+    record.pc          = 0xC000;
+    record.opcode      = OPCODE_JMP_ABS;
+    record.s           = 0xFD;
+    record.p           = 0x24;
+
+    REQUIRE(format_trace_record(record) ==
+            "C000 JMP  4C  a: 00  x: 00  y: 00  sp: FD  flags: --B-I--(24)  cycles:     7");
+}
+
+TEST_CASE("trace round trip", "[trace]")
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "nes-trace-test.bin").string();
+
+    {
+        std::unique_ptr<TraceWriter> tracer = TraceWriter::open(path.c_str());
+        REQUIRE(tracer);
+
+        CPU6502 cpu;
+        cpu.tracer = tracer.get();
+        cpu.memory.write_byte(0, OPCODE_LDX_IMM);
+        cpu.memory.write_byte(1, 0x00);
+        cpu.memory.write_byte(2, OPCODE_INX_IMP);
+        cpu.memory.write_byte(3, OPCODE_JMP_ABS);
+        cpu.memory.write_word(4, 0x0002);
+        // enough to wrap the ring buffer a few times
+        cpu.run_until(500000);
+    }
+
+    std::optional<TraceReader> reader = TraceReader::open(path.c_str());
+    REQUIRE(reader.has_value());
+
+    TraceRecord record;
+    REQUIRE(reader->next(record));
+    REQUIRE(record.pc == 0);
+    REQUIRE(record.opcode == OPCODE_LDX_IMM);
+    REQUIRE(record.operands[0] == 0x00);
+    REQUIRE(record.cycle == 0);
+
+    REQUIRE(reader->next(record));
+    REQUIRE(record.pc == 2);
+    REQUIRE(record.cycle == 2);
+
+    REQUIRE(reader->next(record));
+    REQUIRE(record.opcode == OPCODE_JMP_ABS);
+    REQUIRE(record.operands[0] == 0x02);
+    REQUIRE(record.operands[1] == 0x00);
+    REQUIRE(record.x == 1);
+
+    // every record made it to the file, in order
+    uint64_t last_cycle = record.cycle;
+    size_t count        = 3;
+    bool in_order       = true;
+    while (reader->next(record)) {
+        in_order   = in_order && record.cycle > last_cycle;
+        last_cycle = record.cycle;
+        count++;
+    }
+    REQUIRE(in_order);
+    REQUIRE(count == 1 + (500000 - 2 + 4) / 5 * 2);
+
+    std::filesystem::remove(path);
+}